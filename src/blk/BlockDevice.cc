@@ -34,6 +34,7 @@
 
 #include "common/debug.h"
 #include "common/EventTrace.h"
+#include "common/Formatter.h"
 #include "common/errno.h"
 #include "include/compat.h"
 
@@ -217,6 +218,66 @@ void BlockDevice::add_stalled_read_event() {
   trim_stalled_read_event_queue(cur_time);
 }
 
+void bdev_write_stats_t::dump(ceph::Formatter *f) const
+{
+  f->dump_float("lat_us", lat_us);
+  f->dump_float("bw", bw);
+  f->dump_bool("bw_fitted", bw_fitted);
+  f->dump_unsigned("in_flight", in_flight);
+  f->dump_unsigned("samples", samples);
+}
+
+// Bandwidth assumed until the observed writes vary enough in size to
+// fit one; the fixed latency is still measured from the start.
+static constexpr double BDEV_NOMINAL_BW_HDD = 150e6;
+static constexpr double BDEV_NOMINAL_BW_SSD = 1e9;
+
+// weight of a new sample in the smoothed moments
+static constexpr double BDEV_STATS_ALPHA = 1.0 / 64;
+
+void bdev_write_stats_t::add_sample(uint64_t len, double lat,
+				    double nominal_bw)
+{
+  double x = len;
+  if (samples++ == 0) {
+    mean_len = x;
+    mean_lat = lat;
+    mean_len2 = x * x;
+    mean_len_lat = x * lat;
+  } else {
+    mean_len += (x - mean_len) * BDEV_STATS_ALPHA;
+    mean_lat += (lat - mean_lat) * BDEV_STATS_ALPHA;
+    mean_len2 += (x * x - mean_len2) * BDEV_STATS_ALPHA;
+    mean_len_lat += (x * lat - mean_len_lat) * BDEV_STATS_ALPHA;
+  }
+  double var = mean_len2 - mean_len * mean_len;
+  double cov = mean_len_lat - mean_len * mean_lat;
+  // a slope is only meaningful once lengths spread by a quarter of
+  // their mean; a same-size stream cannot separate fixed cost from
+  // transfer time
+  bw_fitted = var > 0.0625 * mean_len * mean_len && cov > 0;
+  bw = bw_fitted ? var * 1000000.0 / cov : nominal_bw;
+  lat_us = std::max(0.0, mean_lat - mean_len * 1000000.0 / bw);
+}
+
+void BlockDevice::note_write_completed(uint64_t len, ceph::timespan lat)
+{
+  --writes_in_flight;
+  double lat_us = std::max(
+    1.0, std::chrono::duration<double, std::micro>(lat).count());
+  std::lock_guard l(write_stats_lock);
+  write_stats.add_sample(
+    len, lat_us, rotational ? BDEV_NOMINAL_BW_HDD : BDEV_NOMINAL_BW_SSD);
+}
+
+bdev_write_stats_t BlockDevice::get_write_stats() const
+{
+  std::lock_guard l(write_stats_lock);
+  bdev_write_stats_t s = write_stats;
+  s.in_flight = writes_in_flight;
+  return s;
+}
+
 void BlockDevice::collect_alerts(osd_alert_list_t& alerts, const std::string& device_name) {
   if (cct->_conf->bdev_stalled_read_warn_threshold) {
     size_t qsize = trim_stalled_read_event_queue(mono_clock::now());
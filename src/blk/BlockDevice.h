@@ -147,6 +147,30 @@ public:
 };
 
 
+/// smoothed write completion statistics of a device
+///
+/// Write latency is modelled as lat_us + len / bw.  Both are fitted by
+/// a least squares line through smoothed moments of (len, latency) over
+/// all completed writes.  Until the writes vary enough in size to fit a
+/// slope, e.g. when only small writes reach the device, bw stays at the
+/// nominal bandwidth of the device class.
+struct bdev_write_stats_t {
+  double lat_us = 0;       ///< per write latency not explained by transfer time
+  double bw = 0;           ///< bytes/sec
+  bool bw_fitted = false;  ///< bw comes from the fit, not the nominal value
+  uint64_t in_flight = 0;  ///< writes submitted and not yet completed
+  uint64_t samples = 0;    ///< completions observed so far
+
+  // smoothed moments of the samples
+  double mean_len = 0;
+  double mean_lat = 0;
+  double mean_len2 = 0;
+  double mean_len_lat = 0;
+
+  void add_sample(uint64_t len, double lat_us, double nominal_bw);
+  void dump(ceph::Formatter *f) const;
+};
+
 class BlockDevice {
 public:
   CephContext* cct;
@@ -178,6 +202,11 @@ private:
     CephContext* cct, const std::string& path, aio_callback_t cb,
     void *cbpriv, aio_callback_t d_cb, void *d_cbpriv, const char* dev_name);
 
+  mutable ceph::mutex write_stats_lock =
+    ceph::make_mutex("BlockDevice::write_stats_lock");
+  bdev_write_stats_t write_stats;
+  std::atomic<uint64_t> writes_in_flight = {0};
+
 protected:
   uint64_t size = 0;
   uint64_t block_size = 0;
@@ -197,6 +226,12 @@ protected:
   uint64_t zone_size = 0;
   void add_stalled_read_event();
 
+  // feed the write stats; called by backends from their aio paths
+  void note_writes_submitted(uint64_t n) {
+    writes_in_flight += n;
+  }
+  void note_write_completed(uint64_t len, ceph::timespan lat);
+
 public:
   aio_callback_t aio_callback;
   void *aio_callback_priv;
@@ -244,6 +279,8 @@ public:
   uint64_t get_block_size() const { return block_size; }
   uint64_t get_optimal_io_size() const { return optimal_io_size; }
   bool is_discard_supported() const { return support_discard; }
+  /// all zero unless the backend reports write completions
+  bdev_write_stats_t get_write_stats() const;
 
   /// hook to provide utilization of thinly-provisioned device
   virtual int get_ebd_state(ExtBlkDevState &state) const {
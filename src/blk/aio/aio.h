@@ -15,6 +15,7 @@
 #include <boost/intrusive/list.hpp>
 #include <boost/container/small_vector.hpp>
 
+#include "common/ceph_time.h"
 #include "include/buffer.h"
 #include "include/types.h"
 
@@ -34,6 +35,9 @@ struct aio_t {
   boost::container::small_vector<iovec,4> iov;
   uint64_t offset, length;
   long rval;
+  int fixed_buf = -1;     ///< io_uring registered buffer in use, if any
+  bool is_write = false;
+  ceph::mono_clock::time_point submitted;  ///< set by aio_submit
   ceph::buffer::list bl;  ///< write payload (so that it remains stable for duration)
 
   boost::intrusive::list_member_hook<> queue_item;
@@ -44,6 +48,7 @@ struct aio_t {
   void pwritev(uint64_t _offset, uint64_t len) {
     offset = _offset;
     length = len;
+    is_write = true;
 #if defined(HAVE_LIBAIO)
     io_prep_pwritev(&iocb, fd, &iov[0], iov.size(), offset);
 #elif defined(HAVE_POSIXAIO)
@@ -89,7 +89,13 @@ KernelDevice::KernelDevice(CephContext* cct, aio_callback_t cb, void *cbpriv, ai
   if (use_ioring && ioring_queue_t::supported()) {
     bool use_ioring_hipri = cct->_conf.get_val<bool>("bdev_ioring_hipri");
     bool use_ioring_sqthread_poll = cct->_conf.get_val<bool>("bdev_ioring_sqthread_poll");
-    io_queue = std::make_unique<ioring_queue_t>(iodepth, use_ioring_hipri, use_ioring_sqthread_poll);
+    unsigned fixed_buffers =
+      cct->_conf.get_val<uint64_t>("bdev_ioring_fixed_buffers");
+    uint64_t fixed_buffer_size =
+      cct->_conf.get_val<Option::size_t>("bdev_ioring_fixed_buffer_size");
+    io_queue = std::make_unique<ioring_queue_t>(
+      iodepth, use_ioring_hipri, use_ioring_sqthread_poll,
+      fixed_buffers, fixed_buffer_size);
   } else {
     static bool once;
     if (use_ioring && !once) {
@@ -548,6 +554,17 @@ int KernelDevice::_aio_start()
       }
       return r;
     }
+    if (auto ioring = dynamic_cast<ioring_queue_t*>(io_queue.get());
+	ioring && ioring->fixed_buffers) {
+      unsigned n = ioring->get_num_fixed_buffers();
+      if (n) {
+	dout(1) << __func__ << " io_uring registered " << n << " buffers of "
+		<< byte_u_t(ioring->fixed_buffer_size) << dendl;
+      } else {
+	derr << __func__ << " unable to register io_uring buffers; "
+	     << "check RLIMIT_MEMLOCK" << dendl;
+      }
+    }
     aio_thread.create("bstore_aio");
   }
   return 0;
@@ -676,9 +693,13 @@ void KernelDevice::_aio_thread()
     }
     if (r > 0) {
       dout(30) << __func__ << " got " << r << " completed aios" << dendl;
+      auto now = mono_clock::now();
       for (int i = 0; i < r; ++i) {
 	IOContext *ioc = static_cast<IOContext*>(aio[i]->priv);
 	_aio_log_finish(ioc, aio[i]->offset, aio[i]->length);
+	if (aio[i]->is_write) {
+	  note_write_completed(aio[i]->length, now - aio[i]->submitted);
+	}
 	if (aio[i]->queue_item.is_linked()) {
 	  std::lock_guard l(debug_queue_lock);
 	  debug_aio_unlink(*aio[i]);
@@ -1012,6 +1033,14 @@ void KernelDevice::aio_submit(IOContext *ioc)
     }
   }
 
+  auto now = mono_clock::now();
+  uint64_t writes = 0;
+  for (auto p = ioc->running_aios.begin(); p != e; ++p) {
+    p->submitted = now;
+    writes += p->is_write;
+  }
+  note_writes_submitted(writes);
+
   void *priv = static_cast<void*>(ioc);
   int retry_max = cct->_conf->bdev_aio_submit_retry_max;
   int initial_delay_us = cct->_conf->bdev_aio_submit_retry_initial_delay_us;
@@ -7,8 +7,12 @@
 
 #include "liburing.h"
 #include <sys/epoll.h>
+#include <cstring>
 #include <map>
 
+#include "include/intarith.h"
+#include "include/page.h"
+
 using std::list;
 using std::make_unique;
 
@@ -18,8 +22,62 @@ struct ioring_data {
   pthread_mutex_t sq_mutex;
   int epoll_fd = -1;
   std::map<int, int> fixed_fds_map;
+
+  // pool of registered buffers used to stage small IOs.  READ_FIXED and
+  // WRITE_FIXED skip pinning and unpinning the user pages on every O_DIRECT
+  // request, which is cheaper than the copy for small IOs.
+  pthread_mutex_t buf_mutex;
+  char *buf_base = nullptr;
+  uint64_t buf_size = 0;
+  unsigned num_bufs = 0;
+  std::vector<int> free_bufs;
 };
 
+static char *fixed_buf_ptr(struct ioring_data *d, int idx)
+{
+  return d->buf_base + idx * d->buf_size;
+}
+
+static int get_fixed_buf(struct ioring_data *d, uint64_t len)
+{
+  if (!d->buf_base || len > d->buf_size)
+    return -1;
+
+  int idx = -1;
+  pthread_mutex_lock(&d->buf_mutex);
+  if (!d->free_bufs.empty()) {
+    idx = d->free_bufs.back();
+    d->free_bufs.pop_back();
+  }
+  pthread_mutex_unlock(&d->buf_mutex);
+  return idx;
+}
+
+static void put_fixed_buf(struct ioring_data *d, int idx)
+{
+  pthread_mutex_lock(&d->buf_mutex);
+  d->free_bufs.push_back(idx);
+  pthread_mutex_unlock(&d->buf_mutex);
+}
+
+static void finish_fixed_buf(struct ioring_data *d, struct aio_t *io)
+{
+  if (io->iocb.aio_lio_opcode == IO_CMD_PREADV && io->rval > 0) {
+    const char *p = fixed_buf_ptr(d, io->fixed_buf);
+    uint64_t left = io->rval;
+    for (auto& v : io->iov) {
+      uint64_t n = std::min<uint64_t>(left, v.iov_len);
+      memcpy(v.iov_base, p, n);
+      p += n;
+      left -= n;
+      if (!left)
+	break;
+    }
+  }
+  put_fixed_buf(d, io->fixed_buf);
+  io->fixed_buf = -1;
+}
+
 static int ioring_get_cqe(struct ioring_data *d, unsigned int max,
 			  struct aio_t **paio)
 {
@@ -31,6 +89,8 @@ static int ioring_get_cqe(struct ioring_data *d, unsigned int max,
   io_uring_for_each_cqe(ring, head, cqe) {
     struct aio_t *io = (struct aio_t *)(uintptr_t) io_uring_cqe_get_data(cqe);
     io->rval = cqe->res;
+    if (io->fixed_buf >= 0)
+      finish_fixed_buf(d, io);
 
     paio[nr++] = io;
 
@@ -58,24 +118,44 @@ static void init_sqe(struct ioring_data *d, struct io_uring_sqe *sqe,
 
   ceph_assert(fixed_fd != -1);
 
-  if (io->iocb.aio_lio_opcode == IO_CMD_PWRITEV)
-    io_uring_prep_writev(sqe, fixed_fd, &io->iov[0],
-			 io->iov.size(), io->offset);
-  else if (io->iocb.aio_lio_opcode == IO_CMD_PREADV)
-    io_uring_prep_readv(sqe, fixed_fd, &io->iov[0],
-			io->iov.size(), io->offset);
-  else
+  io->fixed_buf = get_fixed_buf(d, io->length);
+
+  if (io->iocb.aio_lio_opcode == IO_CMD_PWRITEV) {
+    if (io->fixed_buf >= 0) {
+      char *p = fixed_buf_ptr(d, io->fixed_buf);
+      for (auto& v : io->iov) {
+	memcpy(p, v.iov_base, v.iov_len);
+	p += v.iov_len;
+      }
+      io_uring_prep_write_fixed(sqe, fixed_fd, fixed_buf_ptr(d, io->fixed_buf),
+				io->length, io->offset, io->fixed_buf);
+    } else {
+      io_uring_prep_writev(sqe, fixed_fd, &io->iov[0],
+			   io->iov.size(), io->offset);
+    }
+  } else if (io->iocb.aio_lio_opcode == IO_CMD_PREADV) {
+    if (io->fixed_buf >= 0) {
+      io_uring_prep_read_fixed(sqe, fixed_fd, fixed_buf_ptr(d, io->fixed_buf),
+			       io->length, io->offset, io->fixed_buf);
+    } else {
+      io_uring_prep_readv(sqe, fixed_fd, &io->iov[0],
+			  io->iov.size(), io->offset);
+    }
+  } else {
     ceph_assert(0);
+  }
 
   io_uring_sqe_set_data(sqe, io);
   io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
 }
 
+/* Queue as many of [beg, end) as there are free SQEs and submit them.
+ * beg is advanced past everything that was queued. */
 static int ioring_queue(struct ioring_data *d, void *priv,
-			list<aio_t>::iterator beg, list<aio_t>::iterator end)
+			list<aio_t>::iterator& beg, list<aio_t>::iterator end)
 {
   struct io_uring *ring = &d->io_uring;
-  struct aio_t *io = nullptr;
+  unsigned queued = 0;
 
   ceph_assert(beg != end);
 
@@ -84,18 +164,61 @@ static int ioring_queue(struct ioring_data *d, void *priv,
     if (!sqe)
       break;
 
-    io = &*beg;
+    struct aio_t *io = &*beg;
     io->priv = priv;
 
     init_sqe(d, sqe, io);
-
+    ++queued;
   } while (++beg != end);
 
-  if (!io)
+  if (!queued)
     /* Queue is full, go and reap something first */
     return 0;
 
-  return io_uring_submit(ring);
+  int ret = io_uring_submit(ring);
+  if (ret < 0)
+    return ret;
+  return queued;
+}
+
+static int register_fixed_buffers(struct ioring_data *d, unsigned count,
+				  uint64_t size)
+{
+  size = p2roundup<uint64_t>(size, CEPH_PAGE_SIZE);
+  void *base = nullptr;
+  int ret = ::posix_memalign(&base, CEPH_PAGE_SIZE, count * size);
+  if (ret)
+    return -ret;
+
+  std::vector<struct iovec> iovs(count);
+  for (unsigned i = 0; i < count; ++i) {
+    iovs[i].iov_base = (char *)base + i * size;
+    iovs[i].iov_len = size;
+  }
+  ret = io_uring_register_buffers(&d->io_uring, iovs.data(), iovs.size());
+  if (ret < 0) {
+    ::free(base);
+    return ret;
+  }
+
+  d->buf_base = (char *)base;
+  d->buf_size = size;
+  d->num_bufs = count;
+  d->free_bufs.reserve(count);
+  for (unsigned i = count; i > 0; --i)
+    d->free_bufs.push_back(i - 1);
+  return 0;
+}
+
+static void unregister_fixed_buffers(struct ioring_data *d)
+{
+  if (!d->buf_base)
+    return;
+  io_uring_unregister_buffers(&d->io_uring);
+  ::free(d->buf_base);
+  d->buf_base = nullptr;
+  d->num_bufs = 0;
+  d->free_bufs.clear();
 }
 
 static void build_fixed_fds_map(struct ioring_data *d,
@@ -107,11 +230,15 @@ static void build_fixed_fds_map(struct ioring_data *d,
   }
 }
 
-ioring_queue_t::ioring_queue_t(unsigned iodepth_, bool hipri_, bool sq_thread_) :
+ioring_queue_t::ioring_queue_t(unsigned iodepth_, bool hipri_, bool sq_thread_,
+                               unsigned fixed_buffers_,
+                               uint64_t fixed_buffer_size_) :
   d(make_unique<ioring_data>()),
   iodepth(iodepth_),
   hipri(hipri_),
-  sq_thread(sq_thread_)
+  sq_thread(sq_thread_),
+  fixed_buffers(fixed_buffers_),
+  fixed_buffer_size(fixed_buffer_size_)
 {
 }
 
@@ -125,6 +252,7 @@ int ioring_queue_t::init(std::vector<int> &fds)
 
   pthread_mutex_init(&d->cq_mutex, NULL);
   pthread_mutex_init(&d->sq_mutex, NULL);
+  pthread_mutex_init(&d->buf_mutex, NULL);
 
   if (hipri)
     flags |= IORING_SETUP_IOPOLL;
@@ -144,6 +272,12 @@ int ioring_queue_t::init(std::vector<int> &fds)
 
   build_fixed_fds_map(d.get(), fds);
 
+  if (fixed_buffers && fixed_buffer_size) {
+    // registered buffers count against RLIMIT_MEMLOCK; if we cannot get
+    // them, carry on with plain readv/writev
+    register_fixed_buffers(d.get(), fixed_buffers, fixed_buffer_size);
+  }
+
   d->epoll_fd = epoll_create1(0);
   if (d->epoll_fd < 0) {
     ret = -errno;
@@ -163,6 +297,7 @@ int ioring_queue_t::init(std::vector<int> &fds)
 close_epoll_fd:
   close(d->epoll_fd);
 unregister_files:
+  unregister_fixed_buffers(d.get());
   io_uring_unregister_files(&d->io_uring);
 close_ring_fd:
   io_uring_queue_exit(&d->io_uring);
@@ -175,6 +310,7 @@ void ioring_queue_t::shutdown()
   d->fixed_fds_map.clear();
   close(d->epoll_fd);
   d->epoll_fd = -1;
+  unregister_fixed_buffers(d.get());
   io_uring_unregister_files(&d->io_uring);
   io_uring_queue_exit(&d->io_uring);
 }
@@ -183,13 +319,36 @@ int ioring_queue_t::submit_batch(aio_iter beg, aio_iter end,
                                  void *priv,
                                  int *retries, int submit_retries, int initial_delay_us)
 {
-  (void)retries;
+  int attempts = submit_retries;
+  uint64_t delay = initial_delay_us;
+  int done = 0;
+  int rc = 0;
 
   pthread_mutex_lock(&d->sq_mutex);
-  int rc = ioring_queue(d.get(), priv, beg, end);
+  while (beg != end) {
+    rc = ioring_queue(d.get(), priv, beg, end);
+    if (rc < 0)
+      break;
+    if (rc > 0) {
+      done += rc;
+      continue;
+    }
+    /* No free SQEs (e.g. the SQPOLL thread is lagging); back off. */
+    if (attempts-- <= 0) {
+      rc = -EAGAIN;
+      break;
+    }
+    ++(*retries);
+    pthread_mutex_unlock(&d->sq_mutex);
+    usleep(delay);
+    delay *= 2;
+    pthread_mutex_lock(&d->sq_mutex);
+  }
   pthread_mutex_unlock(&d->sq_mutex);
 
-  return rc;
+  if (rc < 0)
+    return rc;
+  return done;
 }
 
 int ioring_queue_t::get_next_completed(int timeout_ms, aio_t **paio, int max)
@@ -212,6 +371,11 @@ get_cqe:
   return events;
 }
 
+unsigned ioring_queue_t::get_num_fixed_buffers() const
+{
+  return d->num_bufs;
+}
+
 bool ioring_queue_t::supported()
 {
   struct io_uring ring;
@@ -227,7 +391,9 @@ bool ioring_queue_t::supported()
 
 struct ioring_data {};
 
-ioring_queue_t::ioring_queue_t(unsigned iodepth_, bool hipri_, bool sq_thread_)
+ioring_queue_t::ioring_queue_t(unsigned iodepth_, bool hipri_, bool sq_thread_,
+                               unsigned fixed_buffers_,
+                               uint64_t fixed_buffer_size_)
 {
   ceph_assert(0);
 }
@@ -259,6 +425,11 @@ int ioring_queue_t::get_next_completed(int timeout_ms, aio_t **paio, int max)
   ceph_assert(0);
 }
 
+unsigned ioring_queue_t::get_num_fixed_buffers() const
+{
+  ceph_assert(0);
+}
+
 bool ioring_queue_t::supported()
 {
   return false;
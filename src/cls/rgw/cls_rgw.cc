@@ -557,6 +557,15 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
   // wanting to slow down this op with too many omap reads
   constexpr int max_attempts = 8;
 
+  // extra calls allowed when a delimiter is present, so that a page of
+  // common prefixes does not cost one omap seek per prefix without
+  // bound; the caller picks up from the returned marker
+  constexpr int max_delim_attempts = 32;
+
+  // smallest read size used when a delimiter is present and reads keep
+  // landing inside a single common prefix
+  constexpr uint32_t min_delim_read_size = 16;
+
   auto iter = in->cbegin();
 
   rgw_cls_list_op op;
@@ -619,8 +628,17 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
     start_after_omap_key = cls_rgw_after_delim(start_after_omap_key);
   }
 
+  // with a delimiter every common prefix returned may need its own
+  // omap seek to jump past the rest of the "subdirectory", so allow
+  // extra attempts, up to one per entry; reads are then kept small while
+  // they keep ending inside a common prefix, so the cost of a prefix does
+  // not depend on how many keys it holds
+  const int attempt_limit = max_attempts +
+    (has_delimiter ? std::min<int>(op.num_entries, max_delim_attempts) : 0);
+  uint32_t read_size = op.num_entries;
+
   for (int attempt = 0;
-       attempt < max_attempts &&
+       attempt < attempt_limit &&
 	 more &&
 	 !done &&
 	 name_entry_map.size() < op.num_entries;
@@ -631,7 +649,8 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
     // entries that start with the BI_PREFIX_CHAR), so no need to
     // check for such entries
     rc = get_obj_vals(hctx, start_after_omap_key, op.filter_prefix,
-		      op.num_entries - name_entry_map.size(),
+		      std::min<uint32_t>(read_size,
+					 op.num_entries - name_entry_map.size()),
 		      &keys, &more);
     if (rc < 0) {
       return rc;
@@ -641,6 +660,9 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
 
     done = keys.empty();
 
+    // whether the tail of this read was skipped as part of a common prefix
+    bool tail_in_prefix = false;
+
     for (auto kiter = keys.cbegin(); kiter != keys.cend(); ++kiter) {
       rgw_bucket_dir_entry entry;
       try {
@@ -723,6 +745,7 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
 	  // advance past this subdirectory, but then back up one,
 	  // so the loop increment will put us in the right place
 	  kiter = keys.lower_bound(start_after_omap_key);
+	  tail_in_prefix = (kiter == keys.cend());
 	  --kiter;
 
           continue;
@@ -741,6 +764,12 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
 		int(name_entry_map.size()));
       }
     } // for (auto kiter...
+
+    if (has_delimiter) {
+      read_size = tail_in_prefix ?
+	std::max(min_delim_read_size, read_size / 2) :
+	std::min(op.num_entries, read_size * 2);
+    }
   } // for (int attempt...
 
   ret.is_truncated = more && !done;
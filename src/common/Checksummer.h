@@ -71,9 +71,43 @@ public:
     }
   }
 
+  /// crc32c of count consecutive blocks of len bytes each.  Blocks
+  /// that are contiguous in memory are computed side by side.
+  static void crc32c_blocks(
+    uint32_t init_value,
+    size_t len,
+    size_t count,
+    ceph::buffer::list::const_iterator& p,
+    uint32_t *crcs
+    ) {
+    constexpr size_t max_batch = 16;
+    const unsigned char *data[max_batch];
+    unsigned lengths[max_batch];
+    while (count > 0) {
+      size_t k = std::min(count, max_batch);
+      for (size_t i = 0; i < k; i++) {
+	const char *d;
+	size_t l = p.get_ptr_and_advance(len, &d);
+	data[i] = reinterpret_cast<const unsigned char*>(d);
+	if (l == len) {
+	  crcs[i] = init_value;
+	  lengths[i] = len;
+	} else {
+	  // spans ptrs; finish it here and leave nothing for the batch
+	  crcs[i] = p.crc32c(len - l, ceph_crc32c(init_value, data[i], l));
+	  lengths[i] = 0;
+	}
+      }
+      ceph_crc32c_multi(crcs, data, lengths, k);
+      crcs += k;
+      count -= k;
+    }
+  }
+
   struct crc32c {
     typedef uint32_t init_value_t;
     typedef ceph_le32 value_t;
+    static constexpr uint32_t crc32c_mask = 0xffffffff;
 
     // we have no execution context/state.
     typedef int state_t;
@@ -95,6 +129,7 @@ public:
   struct crc32c_16 {
     typedef uint32_t init_value_t;
     typedef ceph_le16 value_t;
+    static constexpr uint32_t crc32c_mask = 0xffff;
 
     // we have no execution context/state.
     typedef int state_t;
@@ -116,6 +151,7 @@ public:
   struct crc32c_8 {
     typedef uint32_t init_value_t;
     typedef __u8 value_t;
+    static constexpr uint32_t crc32c_mask = 0xff;
 
     // we have no execution context/state.
     typedef int state_t;
@@ -225,9 +261,22 @@ public:
     typename Alg::value_t *pv =
       reinterpret_cast<typename Alg::value_t*>(csum_data->c_str());
     pv += offset / csum_block_size;
-    while (blocks--) {
-      *pv = Alg::calc(state, init_value, csum_block_size, p);
-      ++pv;
+    if constexpr (requires { Alg::crc32c_mask; }) {
+      uint32_t crcs[16];
+      while (blocks > 0) {
+	size_t k = std::min(blocks, std::size(crcs));
+	crc32c_blocks(init_value, csum_block_size, k, p, crcs);
+	for (size_t i = 0; i < k; i++) {
+	  *pv = crcs[i] & Alg::crc32c_mask;
+	  ++pv;
+	}
+	blocks -= k;
+      }
+    } else {
+      while (blocks--) {
+	*pv = Alg::calc(state, init_value, csum_block_size, p);
+	++pv;
+      }
     }
     Alg::fini(&state);
     return 0;
@@ -253,6 +302,28 @@ public:
       reinterpret_cast<const typename Alg::value_t*>(csum_data.c_str());
     pv += offset / csum_block_size;
     size_t pos = offset;
+    if constexpr (requires { Alg::crc32c_mask; }) {
+      uint32_t crcs[16];
+      while (length > 0) {
+	size_t k = std::min(length / csum_block_size, std::size(crcs));
+	crc32c_blocks(-1, csum_block_size, k, p, crcs);
+	for (size_t i = 0; i < k; i++) {
+	  typename Alg::init_value_t v = crcs[i] & Alg::crc32c_mask;
+	  if (*pv != v) {
+	    if (bad_csum) {
+	      *bad_csum = v;
+	    }
+	    Alg::fini(&state);
+	    return pos;
+	  }
+	  ++pv;
+	  pos += csum_block_size;
+	}
+	length -= k * csum_block_size;
+      }
+      Alg::fini(&state);
+      return -1;  // no errors
+    }
     while (length > 0) {
       typename Alg::init_value_t v = Alg::calc(state, -1, csum_block_size, p);
       if (*pv != v) {
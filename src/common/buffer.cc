@@ -2131,6 +2131,89 @@ __u32 buffer::list::crc32c(__u32 crc) const
   return crc;
 }
 
+/*
+ * The lists are walked side by side.  Each round takes the next
+ * uncached ptr of every list and computes their crcs together with
+ * ceph_crc32c_multi(), which interleaves them where the CPU allows.
+ */
+void buffer::list::crc32c_multi(const list* const* bls, uint32_t* crcs,
+				unsigned n)
+{
+  constexpr unsigned max_lists = 16;
+  for (; n > max_lists; bls += max_lists, crcs += max_lists, n -= max_lists) {
+    crc32c_multi(bls, crcs, max_lists);
+  }
+
+  int cache_misses = 0;
+  int cache_hits = 0;
+  int cache_adjusts = 0;
+
+  buffers_t::const_iterator pos[max_lists];
+  unsigned idx[max_lists];
+  const unsigned char* data[max_lists];
+  unsigned lengths[max_lists];
+  uint32_t batch[max_lists];
+  for (unsigned i = 0; i < n; i++) {
+    pos[i] = bls[i]->_buffers.begin();
+  }
+
+  while (true) {
+    unsigned k = 0;
+    for (unsigned i = 0; i < n; i++) {
+      auto& p = pos[i];
+      const auto end = bls[i]->_buffers.end();
+      // cached ptrs cost nothing, consume them right away
+      for (; p != end; ++p) {
+	if (!p->length()) {
+	  continue;
+	}
+	pair<size_t, size_t> ofs(p->offset(), p->offset() + p->length());
+	pair<uint32_t, uint32_t> ccrc;
+	if (!p->_raw->get_crc(ofs, &ccrc)) {
+	  break;
+	}
+	if (ccrc.first == crcs[i]) {
+	  crcs[i] = ccrc.second;
+	  cache_hits++;
+	} else {
+	  // see crc32c() above
+	  crcs[i] = ccrc.second ^ ceph_crc32c(ccrc.first ^ crcs[i], NULL, p->length());
+	  cache_adjusts++;
+	}
+      }
+      if (p != end) {
+	idx[k] = i;
+	data[k] = (const unsigned char*)p->c_str();
+	lengths[k] = p->length();
+	batch[k] = crcs[i];
+	k++;
+      }
+    }
+    if (k == 0) {
+      break;
+    }
+    ceph_crc32c_multi(batch, data, lengths, k);
+    for (unsigned j = 0; j < k; j++) {
+      unsigned i = idx[j];
+      auto& p = pos[i];
+      p->_raw->set_crc(make_pair(p->offset(), p->offset() + p->length()),
+		       make_pair(crcs[i], batch[j]));
+      crcs[i] = batch[j];
+      ++p;
+    }
+    cache_misses += k;
+  }
+
+  if (buffer_track_crc) {
+    if (cache_adjusts)
+      buffer_cached_crc_adjusted += cache_adjusts;
+    if (cache_hits)
+      buffer_cached_crc += cache_hits;
+    if (cache_misses)
+      buffer_missed_crc += cache_misses;
+  }
+}
+
 void buffer::list::invalidate_crc()
 {
   for (const auto& node : _buffers) {
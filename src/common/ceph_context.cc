@@ -47,6 +47,7 @@
 #endif
 
 #include "log/Log.h"
+#include "msg/MessagePool.h"
 
 #include "auth/Crypto.h"
 #include "include/str_list.h"
@@ -173,6 +174,11 @@ public:
       this,
       "get mempool stats");
     ceph_assert(r == 0);
+    r = cct->get_admin_socket()->register_command(
+      "dump_message_pools",
+      this,
+      "get message pool stats");
+    ceph_assert(r == 0);
   }
   ~MempoolObs() override {
     cct->_conf.remove_observer(this);
@@ -204,6 +210,12 @@ public:
       f->close_section();
       return 0;
     }
+    if (command == "dump_message_pools") {
+      f->open_object_section("message_pools");
+      ceph::msg::MessagePoolBase::dump_all(f);
+      f->close_section();
+      return 0;
+    }
     return -ENOSYS;
   }
 };
@@ -66,6 +66,7 @@ namespace ceph {
   using mutex = dummy_mutex;
   using recursive_mutex = dummy_mutex;
   using shared_mutex = dummy_shared_mutex;
+  using sharded_shared_mutex = dummy_shared_mutex;
   using condition_variable = green_condition_variable;
 
   template <typename ...Args>
@@ -83,6 +84,11 @@ namespace ceph {
     return {};
   }
 
+  template <typename ...Args>
+  sharded_shared_mutex make_sharded_shared_mutex(Args&& ...args) {
+    return {};
+  }
+
   #define ceph_mutex_is_locked(m) true
   #define ceph_mutex_is_locked_by_me(m) true
 }
@@ -111,6 +117,8 @@ namespace ceph {
   typedef ceph::mutex_recursive_debug recursive_mutex;
   typedef ceph::condition_variable_debug condition_variable;
   typedef ceph::shared_mutex_debug shared_mutex;
+  // lockdep tracks a single lock, so keep it unsharded here
+  typedef ceph::shared_mutex_debug sharded_shared_mutex;
 
   // pass arguments to mutex_debug ctor
   template <typename ...Args>
@@ -130,6 +138,11 @@ namespace ceph {
     return {std::forward<Args>(args)...};
   }
 
+  template <typename ...Args>
+  sharded_shared_mutex make_sharded_shared_mutex(Args&& ...args) {
+    return {std::forward<Args>(args)...};
+  }
+
   // debug methods
   #define ceph_mutex_is_locked(m) ((m).is_locked())
   #define ceph_mutex_is_not_locked(m) (!(m).is_locked())
@@ -155,6 +168,7 @@ namespace ceph {
 #include <boost/thread/shared_mutex.hpp>
 #else
 #include <shared_mutex>
+#include "common/sharded_shared_mutex.h"
 #endif
 
 namespace ceph {
@@ -165,6 +179,7 @@ namespace ceph {
 
 #if defined(__MINGW32__) && !defined(__clang__)
   typedef boost::shared_mutex shared_mutex;
+  typedef boost::shared_mutex sharded_shared_mutex;
 #else
   typedef std::shared_mutex shared_mutex;
 #endif
@@ -182,6 +197,10 @@ namespace ceph {
   shared_mutex make_shared_mutex(Args&& ...args) {
     return {};
   }
+  template <typename ...Args>
+  sharded_shared_mutex make_sharded_shared_mutex(Args&& ...args) {
+    return {};
+  }
 
   // debug methods.  Note that these can blindly return true
   // because any code that does anything other than assert these
@@ -9,6 +9,7 @@
 #include "arch/s390x.h"
 #include "common/sctp_crc32.h"
 #include "common/crc32c_intel_fast.h"
+#include "common/crc32c_intel_multi.h"
 #include "common/crc32c_aarch64.h"
 #include "common/crc32c_ppc.h"
 #include "common/crc32c_s390x.h"
@@ -61,6 +62,38 @@ ceph_crc32c_func_t ceph_choose_crc32(void)
  */
 ceph_crc32c_func_t ceph_crc32c_func = ceph_choose_crc32();
 
+static void ceph_crc32c_multi_serial(uint32_t *crcs, unsigned char const * const *data,
+				     unsigned const *lengths, unsigned n)
+{
+  for (unsigned i = 0; i < n; i++) {
+    crcs[i] = ceph_crc32c(crcs[i], data[i], lengths[i]);
+  }
+}
+
+/*
+ * choose an interleaved implementation where the CPU has crc32c
+ * instructions; otherwise the buffers are done one after another.
+ */
+ceph_crc32c_multi_func_t ceph_choose_crc32c_multi(void)
+{
+  ceph_arch_probe();
+
+#if defined(__x86_64__)
+  if (ceph_arch_intel_sse42) {
+    return ceph_crc32c_intel_multi;
+  }
+#elif defined(__arm__) || defined(__aarch64__)
+# if defined(HAVE_ARMV8_CRC)
+  if (ceph_arch_aarch64_crc32) {
+    return ceph_crc32c_aarch64_multi;
+  }
+# endif
+#endif
+  return ceph_crc32c_multi_serial;
+}
+
+ceph_crc32c_multi_func_t ceph_crc32c_multi_func = ceph_choose_crc32c_multi();
+
 
 /*
  * Look: http://crcutil.googlecode.com/files/crc-doc.1.0.pdf
@@ -272,3 +272,70 @@ uint32_t ceph_crc32c_aarch64(uint32_t crc, unsigned char const *buffer, unsigned
 	}
 	return crc;
 }
+
+/*
+ * crc32cx has a latency of several cycles but can issue every cycle,
+ * so independent buffers are run side by side over their common
+ * length, four at a time, and finished one by one.
+ */
+#define MULTI_STREAMS 4
+#define MULTI_MIN_INTERLEAVE 16
+
+static void crc32c_aarch64_interleave(uint32_t *crcs, unsigned char const * const *data,
+				      unsigned const *lengths, unsigned const *idx, unsigned k)
+{
+	uint32_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+	unsigned char const *p[MULTI_STREAMS] = {0};
+	unsigned common = lengths[idx[0]];
+	unsigned i, off;
+
+	for (i = 0; i < k; i++) {
+		p[i] = data[idx[i]];
+		if (lengths[idx[i]] < common)
+			common = lengths[idx[i]];
+	}
+	common &= ~7u;
+	c0 = crcs[idx[0]];
+	c1 = crcs[idx[1]];
+	if (k > 2)
+		c2 = crcs[idx[2]];
+	if (k > 3)
+		c3 = crcs[idx[3]];
+	for (off = 0; off < common; off += sizeof(uint64_t)) {
+		CRC32CX(c0, *(const uint64_t *)(p[0] + off));
+		CRC32CX(c1, *(const uint64_t *)(p[1] + off));
+		if (k > 2)
+			CRC32CX(c2, *(const uint64_t *)(p[2] + off));
+		if (k > 3)
+			CRC32CX(c3, *(const uint64_t *)(p[3] + off));
+	}
+	crcs[idx[0]] = ceph_crc32c_aarch64(c0, p[0] + common, lengths[idx[0]] - common);
+	crcs[idx[1]] = ceph_crc32c_aarch64(c1, p[1] + common, lengths[idx[1]] - common);
+	if (k > 2)
+		crcs[idx[2]] = ceph_crc32c_aarch64(c2, p[2] + common, lengths[idx[2]] - common);
+	if (k > 3)
+		crcs[idx[3]] = ceph_crc32c_aarch64(c3, p[3] + common, lengths[idx[3]] - common);
+}
+
+void ceph_crc32c_aarch64_multi(uint32_t *crcs, unsigned char const * const *data,
+			       unsigned const *lengths, unsigned n)
+{
+	unsigned idx[MULTI_STREAMS];
+	unsigned i, k = 0;
+
+	for (i = 0; i < n; i++) {
+		if (!data[i] || lengths[i] < MULTI_MIN_INTERLEAVE) {
+			crcs[i] = ceph_crc32c_aarch64(crcs[i], data[i], lengths[i]);
+			continue;
+		}
+		idx[k++] = i;
+		if (k == MULTI_STREAMS) {
+			crc32c_aarch64_interleave(crcs, data, lengths, idx, k);
+			k = 0;
+		}
+	}
+	if (k == 1)
+		crcs[idx[0]] = ceph_crc32c_aarch64(crcs[idx[0]], data[idx[0]], lengths[idx[0]]);
+	else if (k)
+		crc32c_aarch64_interleave(crcs, data, lengths, idx, k);
+}
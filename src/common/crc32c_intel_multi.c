@@ -0,0 +1,86 @@
+#include "acconfig.h"
+#include "include/crc32c.h"
+#include "common/crc32c_intel_multi.h"
+
+#ifdef __x86_64__
+
+#include <string.h>
+#include <nmmintrin.h>
+
+/*
+ * The crc32 instruction has a latency of 3 cycles and a throughput of
+ * one per cycle, so a single short stream keeps the unit busy a third
+ * of the time.  Independent buffers are run side by side, STREAMS at a
+ * time, over their common length; what is left of each is finished by
+ * the single stream implementation.
+ */
+#define STREAMS 4
+#define MIN_INTERLEAVE 16
+
+static inline uint64_t load64(unsigned char const *p)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+__attribute__((target("sse4.2")))
+static void crc32c_interleave(uint32_t *crcs, unsigned char const * const *data,
+			      unsigned const *lengths, unsigned const *idx, unsigned k)
+{
+	uint64_t c[STREAMS];
+	unsigned char const *p[STREAMS];
+	unsigned common = lengths[idx[0]];
+	unsigned i, off;
+
+	for (i = 0; i < k; i++) {
+		c[i] = crcs[idx[i]];
+		p[i] = data[idx[i]];
+		if (lengths[idx[i]] < common)
+			common = lengths[idx[i]];
+	}
+	common &= ~7u;
+	if (k == STREAMS) {
+		for (off = 0; off < common; off += 8) {
+			c[0] = _mm_crc32_u64(c[0], load64(p[0] + off));
+			c[1] = _mm_crc32_u64(c[1], load64(p[1] + off));
+			c[2] = _mm_crc32_u64(c[2], load64(p[2] + off));
+			c[3] = _mm_crc32_u64(c[3], load64(p[3] + off));
+		}
+	} else {
+		for (off = 0; off < common; off += 8) {
+			for (i = 0; i < k; i++)
+				c[i] = _mm_crc32_u64(c[i], load64(p[i] + off));
+		}
+	}
+	for (i = 0; i < k; i++) {
+		unsigned j = idx[i];
+		crcs[j] = ceph_crc32c_func((uint32_t)c[i], p[i] + common,
+					   lengths[j] - common);
+	}
+}
+
+void ceph_crc32c_intel_multi(uint32_t *crcs, unsigned char const * const *data,
+			     unsigned const *lengths, unsigned n)
+{
+	unsigned idx[STREAMS];
+	unsigned i, k = 0;
+
+	for (i = 0; i < n; i++) {
+		if (!data[i] || lengths[i] < MIN_INTERLEAVE) {
+			crcs[i] = ceph_crc32c(crcs[i], data[i], lengths[i]);
+			continue;
+		}
+		idx[k++] = i;
+		if (k == STREAMS) {
+			crc32c_interleave(crcs, data, lengths, idx, k);
+			k = 0;
+		}
+	}
+	if (k == 1)
+		crcs[idx[0]] = ceph_crc32c_func(crcs[idx[0]], data[idx[0]], lengths[idx[0]]);
+	else if (k)
+		crc32c_interleave(crcs, data, lengths, idx, k);
+}
+
+#endif
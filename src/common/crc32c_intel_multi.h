@@ -0,0 +1,28 @@
+#ifndef CEPH_COMMON_CRC32C_INTEL_MULTI_H
+#define CEPH_COMMON_CRC32C_INTEL_MULTI_H
+
+#include "include/int_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __x86_64__
+
+extern void ceph_crc32c_intel_multi(uint32_t *crcs, unsigned char const * const *data,
+				    unsigned const *lengths, unsigned n);
+
+#else
+
+static inline void ceph_crc32c_intel_multi(uint32_t *crcs, unsigned char const * const *data,
+					   unsigned const *lengths, unsigned n)
+{
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
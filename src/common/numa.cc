@@ -9,6 +9,7 @@
 #include <unistd.h> // for close(), getpid()
 #include <errno.h>
 #include <iostream>
+#include <vector>
 
 #include "include/stringify.h"
 #include "common/safe_io.h"
@@ -227,6 +228,48 @@ int set_cpu_affinity_all_threads(size_t cpu_set_size, cpu_set_t *cpu_set)
   return 0;
 }
 
+int get_cpu_set_slice(size_t cpu_set_size,
+		      const cpu_set_t *cpu_set,
+		      unsigned num_slices,
+		      unsigned slice,
+		      size_t *slice_set_size,
+		      cpu_set_t *slice_set)
+{
+  if (num_slices == 0 || slice >= num_slices) {
+    return -EINVAL;
+  }
+  auto s = cpu_set_to_set(cpu_set_size, cpu_set);
+  if (s.empty()) {
+    return -EINVAL;
+  }
+  std::vector<int> cpus(s.begin(), s.end());
+  CPU_ZERO(slice_set);
+  if (cpus.size() < num_slices) {
+    int cpu = cpus[slice % cpus.size()];
+    CPU_SET(cpu, slice_set);
+    *slice_set_size = cpu + 1;
+    return 0;
+  }
+  size_t begin = cpus.size() * slice / num_slices;
+  size_t end = cpus.size() * (slice + 1) / num_slices;
+  for (size_t i = begin; i < end; ++i) {
+    CPU_SET(cpus[i], slice_set);
+  }
+  *slice_set_size = cpus[end - 1] + 1;
+  return 0;
+}
+
+int set_cpu_affinity_this_thread(size_t cpu_set_size,
+				 const cpu_set_t *cpu_set)
+{
+  // pid 0 is the calling thread
+  int r = sched_setaffinity(0, sizeof(cpu_set_t), cpu_set);
+  if (r < 0) {
+    return -errno;
+  }
+  return 0;
+}
+
 #else
 int parse_cpu_set_list(const char *s,
 		       size_t *cpu_set_size,
@@ -260,4 +303,20 @@ int set_cpu_affinity_all_threads(size_t cpu_set_size,
   return -ENOTSUP;
 }
 
+int get_cpu_set_slice(size_t cpu_set_size,
+		      const cpu_set_t *cpu_set,
+		      unsigned num_slices,
+		      unsigned slice,
+		      size_t *slice_set_size,
+		      cpu_set_t *slice_set)
+{
+  return -ENOTSUP;
+}
+
+int set_cpu_affinity_this_thread(size_t cpu_set_size,
+				 const cpu_set_t *cpu_set)
+{
+  return -ENOTSUP;
+}
+
 #endif
@@ -26,3 +26,16 @@ int get_numa_node_cpu_set(int node,
 
 int set_cpu_affinity_all_threads(size_t cpu_set_size,
 				 cpu_set_t *cpu_set);
+
+/// carve slice @slice out of @num_slices roughly equal, contiguous slices
+/// of @cpu_set.  if there are fewer cpus than slices, slices share cpus.
+int get_cpu_set_slice(size_t cpu_set_size,
+		      const cpu_set_t *cpu_set,
+		      unsigned num_slices,
+		      unsigned slice,
+		      size_t *slice_set_size,
+		      cpu_set_t *slice_set);
+
+/// set the affinity of the calling thread only
+int set_cpu_affinity_this_thread(size_t cpu_set_size,
+				 const cpu_set_t *cpu_set);
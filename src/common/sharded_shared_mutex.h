@@ -0,0 +1,76 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <shared_mutex>
+
+namespace ceph {
+
+// A reader/writer lock for read-mostly state on a hot path.
+//
+// A single shared_mutex makes every reader write the same cache line,
+// so readers on different cores still serialize on it.  Here each
+// thread takes the shared side of one of several shards, and a writer
+// has to take them all.  Readers thus only contend with other threads
+// on their own shard, at the price of a much more expensive lock().
+//
+// As with std::shared_mutex, the shared side must be released by the
+// thread that acquired it.
+class sharded_shared_mutex {
+public:
+  static constexpr unsigned num_shards = 16;
+
+  sharded_shared_mutex() = default;
+  sharded_shared_mutex(const sharded_shared_mutex&) = delete;
+  sharded_shared_mutex& operator=(const sharded_shared_mutex&) = delete;
+
+  void lock() {
+    for (auto& s : shards) {
+      s.m.lock();
+    }
+  }
+  bool try_lock() {
+    for (unsigned i = 0; i < num_shards; ++i) {
+      if (!shards[i].m.try_lock()) {
+        while (i > 0) {
+          shards[--i].m.unlock();
+        }
+        return false;
+      }
+    }
+    return true;
+  }
+  void unlock() {
+    for (auto s = shards.rbegin(); s != shards.rend(); ++s) {
+      s->m.unlock();
+    }
+  }
+
+  void lock_shared() {
+    shards[my_shard()].m.lock_shared();
+  }
+  bool try_lock_shared() {
+    return shards[my_shard()].m.try_lock_shared();
+  }
+  void unlock_shared() {
+    shards[my_shard()].m.unlock_shared();
+  }
+
+private:
+  struct alignas(64) shard_t {
+    std::shared_mutex m;
+  };
+  std::array<shard_t, num_shards> shards;
+
+  static unsigned my_shard() {
+    static std::atomic<unsigned> next_shard = {0};
+    thread_local unsigned shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % num_shards;
+    return shard;
+  }
+};
+
+} // namespace ceph
@@ -16,10 +16,12 @@
 #ifndef CEPH_COMPRESSOR_H
 #define CEPH_COMPRESSOR_H
 
+#include <cerrno>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 #include "include/ceph_assert.h"    // boost clobbers this
 #include "include/common_fwd.h"
 #include "include/buffer.h"
@@ -89,6 +91,28 @@ public:
   // alignment with decode methods
   virtual int decompress(ceph::bufferlist::const_iterator &p, size_t compressed_len, ceph::bufferlist &out, std::optional<int32_t> compressor_message) = 0;
 
+  /// a trained dictionary, loaded into the algorithm's own form
+  struct Dictionary {
+    virtual ~Dictionary() {}
+  };
+  using DictionaryRef = std::shared_ptr<const Dictionary>;
+
+  // dictionary compression, for algorithms that support it.  the
+  // dictionary must be presented again on decompression.
+  virtual int train_dictionary(const std::vector<ceph::bufferlist>& samples,
+			       size_t max_len, ceph::bufferlist *dict) {
+    return -EOPNOTSUPP;
+  }
+  virtual DictionaryRef load_dictionary(const ceph::bufferlist& dict) {
+    return DictionaryRef();
+  }
+  virtual int compress_with_dict(const ceph::bufferlist &in, ceph::bufferlist &out, const DictionaryRef& dict, std::optional<int32_t> &compressor_message) {
+    return -EOPNOTSUPP;
+  }
+  virtual int decompress_with_dict(ceph::bufferlist::const_iterator &p, size_t compressed_len, ceph::bufferlist &out, const DictionaryRef& dict, std::optional<int32_t> compressor_message) {
+    return -EOPNOTSUPP;
+  }
+
   static CompressorRef create(CephContext *cct, const std::string &type);
   static CompressorRef create(CephContext *cct, int alg);
 
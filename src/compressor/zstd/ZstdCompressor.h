@@ -18,6 +18,7 @@
 
 #define ZSTD_STATIC_LINKING_ONLY
 #include "zstd/lib/zstd.h"
+#include "zstd/lib/zdict.h"
 
 #include "include/buffer.h"
 #include "include/encoding.h"
@@ -30,6 +31,106 @@ class ZstdCompressor : public Compressor {
   int compress(const ceph::buffer::list &src, ceph::buffer::list &dst, std::optional<int32_t> &compressor_message) override {
     ZSTD_CStream *s = ZSTD_createCStream();
     ZSTD_initCStream_srcSize(s, cct->_conf->compressor_zstd_level, src.length());
+    int r = _compress(s, src, dst);
+    ZSTD_freeCStream(s);
+    return r;
+  }
+
+  int decompress(const ceph::buffer::list &src, ceph::buffer::list &dst, std::optional<int32_t> compressor_message) override {
+    auto i = std::cbegin(src);
+    return decompress(i, src.length(), dst, compressor_message);
+  }
+
+  int decompress(ceph::buffer::list::const_iterator &p,
+		 size_t compressed_len,
+		 ceph::buffer::list &dst,
+		 std::optional<int32_t> compressor_message) override {
+    ZSTD_DStream *s = ZSTD_createDStream();
+    ZSTD_initDStream(s);
+    int r = _decompress(s, p, compressed_len, dst);
+    ZSTD_freeDStream(s);
+    return r;
+  }
+
+  int train_dictionary(const std::vector<ceph::buffer::list>& samples,
+		       size_t max_len,
+		       ceph::buffer::list *dict) override {
+    ceph::buffer::list all;
+    std::vector<size_t> sizes;
+    sizes.reserve(samples.size());
+    for (auto& i : samples) {
+      all.append(i);
+      sizes.push_back(i.length());
+    }
+    ceph::buffer::ptr out(max_len);
+    size_t r = ZDICT_trainFromBuffer(out.c_str(), out.length(),
+				     all.c_str(), sizes.data(), sizes.size());
+    if (ZDICT_isError(r)) {
+      return -EINVAL;
+    }
+    dict->append(out, 0, r);
+    return 0;
+  }
+
+  DictionaryRef load_dictionary(const ceph::buffer::list& dict) override {
+    ceph::buffer::list d = dict;
+    auto z = std::make_shared<ZstdDictionary>();
+    z->cdict = ZSTD_createCDict(d.c_str(), d.length(),
+				cct->_conf->compressor_zstd_level);
+    z->ddict = ZSTD_createDDict(d.c_str(), d.length());
+    if (!z->cdict || !z->ddict) {
+      return DictionaryRef();
+    }
+    return z;
+  }
+
+  int compress_with_dict(const ceph::buffer::list &src,
+			 ceph::buffer::list &dst,
+			 const DictionaryRef& dict,
+			 std::optional<int32_t> &compressor_message) override {
+    auto z = dynamic_cast<const ZstdDictionary*>(dict.get());
+    if (!z) {
+      return -EINVAL;
+    }
+    ZSTD_CCtx *s = ZSTD_createCCtx();
+    ZSTD_CCtx_refCDict(s, z->cdict);
+    ZSTD_CCtx_setPledgedSrcSize(s, src.length());
+    int r = _compress(s, src, dst);
+    ZSTD_freeCCtx(s);
+    return r;
+  }
+
+  int decompress_with_dict(ceph::buffer::list::const_iterator &p,
+			   size_t compressed_len,
+			   ceph::buffer::list &dst,
+			   const DictionaryRef& dict,
+			   std::optional<int32_t> compressor_message) override {
+    auto z = dynamic_cast<const ZstdDictionary*>(dict.get());
+    if (!z) {
+      return -EINVAL;
+    }
+    ZSTD_DCtx *s = ZSTD_createDCtx();
+    ZSTD_DCtx_refDDict(s, z->ddict);
+    int r = _decompress(s, p, compressed_len, dst);
+    ZSTD_freeDCtx(s);
+    return r;
+  }
+
+ private:
+  CephContext *const cct;
+
+  struct ZstdDictionary : public Dictionary {
+    ZSTD_CDict *cdict = nullptr;
+    ZSTD_DDict *ddict = nullptr;
+    ~ZstdDictionary() override {
+      ZSTD_freeCDict(cdict);
+      ZSTD_freeDDict(ddict);
+    }
+  };
+
+  int _compress(ZSTD_CStream *s,
+		const ceph::buffer::list &src,
+		ceph::buffer::list &dst) {
     auto p = src.begin();
     size_t left = src.length();
 
@@ -54,23 +155,16 @@ class ZstdCompressor : public Compressor {
     }
     ceph_assert(p.get_remaining() == 0);
 
-    ZSTD_freeCStream(s);
-
     // prefix with decompressed length
     ceph::encode((uint32_t)src.length(), dst);
     dst.append(outptr, 0, outbuf.pos);
     return 0;
   }
 
-  int decompress(const ceph::buffer::list &src, ceph::buffer::list &dst, std::optional<int32_t> compressor_message) override {
-    auto i = std::cbegin(src);
-    return decompress(i, src.length(), dst, compressor_message);
-  }
-
-  int decompress(ceph::buffer::list::const_iterator &p,
-		 size_t compressed_len,
-		 ceph::buffer::list &dst,
-		 std::optional<int32_t> compressor_message) override {
+  int _decompress(ZSTD_DStream *s,
+		  ceph::buffer::list::const_iterator &p,
+		  size_t compressed_len,
+		  ceph::buffer::list &dst) {
     if (compressed_len < 4) {
       return -1;
     }
@@ -83,8 +177,6 @@ class ZstdCompressor : public Compressor {
     outbuf.dst = dstptr.c_str();
     outbuf.size = dstptr.length();
     outbuf.pos = 0;
-    ZSTD_DStream *s = ZSTD_createDStream();
-    ZSTD_initDStream(s);
     while (compressed_len > 0) {
       if (p.end()) {
 	return -1;
@@ -93,16 +185,16 @@ class ZstdCompressor : public Compressor {
       inbuf.pos = 0;
       inbuf.size = p.get_ptr_and_advance(compressed_len,
 					 (const char**)&inbuf.src);
-      ZSTD_decompressStream(s, &outbuf, &inbuf);
+      size_t r = ZSTD_decompressStream(s, &outbuf, &inbuf);
+      if (ZSTD_isError(r)) {
+	return -1;
+      }
       compressed_len -= inbuf.size;
     }
-    ZSTD_freeDStream(s);
 
     dst.append(dstptr, 0, outbuf.pos);
     return 0;
   }
- private:
-  CephContext *const cct;
 };
 
 #endif
@@ -19,6 +19,7 @@
 #include "common/ceph_context.h"
 #include "include/ceph_features.h"
 #include "common/debug.h"
+#include "common/ceph_time.h"
 
 #define dout_subsys ceph_subsys_crush
 #undef dout_prefix
@@ -757,3 +758,94 @@ int CrushTester::compare(CrushWrapper& crush2)
   }
   return ret;
 }
+
+int CrushTester::bench_batch()
+{
+  if (min_rule < 0 || max_rule < 0) {
+    min_rule = 0;
+    max_rule = crush.get_max_rules() - 1;
+  }
+  if (min_x < 0 || max_x < 0) {
+    min_x = 0;
+    max_x = 1023;
+  }
+  if (min_rep < 0 && max_rep < 0) {
+    cerr << "must specify --num-rep or both --min-rep and --max-rep" << std::endl;
+    return -EINVAL;
+  }
+
+  // initial osd weights
+  vector<__u32> weight;
+  for (int o = 0; o < crush.get_max_devices(); o++) {
+    if (device_weight.count(o)) {
+      weight.push_back(device_weight[o]);
+    } else if (crush.check_item_present(o)) {
+      weight.push_back(0x10000);
+    } else {
+      weight.push_back(0);
+    }
+  }
+
+  // make adjustments
+  adjust_weights(weight);
+
+  vector<int> xs;
+  for (int x = min_x; x <= max_x; ++x) {
+    int real_x = x;
+    if (pool_id != -1) {
+      real_x = crush_hash32_2(CRUSH_HASH_RJENKINS1, x, (uint32_t)pool_id);
+    }
+    xs.push_back(real_x);
+  }
+
+  int ret = 0;
+  for (int r = min_rule; r < crush.get_max_rules() && r <= max_rule; r++) {
+    if (!crush.rule_exists(r)) {
+      continue;
+    }
+    for (int nr = min_rep; nr <= max_rep; nr++) {
+      vector<vector<int>> single(xs.size());
+      auto start = ceph::mono_clock::now();
+      for (unsigned i = 0; i < xs.size(); ++i) {
+	crush.do_rule(r, xs[i], single[i], nr, weight, 0);
+      }
+      auto single_time = ceph::mono_clock::now() - start;
+
+      vector<int> out, out_len;
+      start = ceph::mono_clock::now();
+      crush.do_rule_batch(r, xs, nr, weight, 0, &out, &out_len);
+      auto batch_time = ceph::mono_clock::now() - start;
+
+      int bad = 0;
+      for (unsigned i = 0; i < xs.size(); ++i) {
+	auto row = out.begin() + i * nr;
+	if (!std::equal(single[i].begin(), single[i].end(),
+			row, row + out_len[i])) {
+	  if (output_bad_mappings) {
+	    err << "rule " << r << " x " << (min_x + (int)i)
+		<< " batch mapping " << vector<int>(row, row + out_len[i])
+		<< " != " << single[i] << std::endl;
+	  }
+	  ++bad;
+	}
+      }
+      if (bad) {
+	ret = -EINVAL;
+      }
+      double single_s = ceph::to_seconds<double>(single_time);
+      double batch_s = ceph::to_seconds<double>(batch_time);
+      cout << "rule " << r << " (" << crush.get_rule_name(r)
+	   << ") num_rep " << nr << " x " << min_x << ".." << max_x
+	   << ": single " << single_s << "s, batch " << batch_s << "s";
+      if (batch_s > 0) {
+	cout << " (" << std::fixed << std::setprecision(2)
+	     << single_s / batch_s << "x)" << std::defaultfloat;
+      }
+      cout << ", " << bad << " mismatched mappings" << std::endl;
+    }
+  }
+  if (ret) {
+    cerr << "warning: batched mappings do NOT match" << std::endl;
+  }
+  return ret;
+}
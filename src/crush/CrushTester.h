@@ -352,6 +352,13 @@ public:
   int test_with_fork(CephContext* cct, int timeout);
 
   int compare(CrushWrapper& other);
+
+  /**
+   * time mapping the test range with do_rule() against do_rule_batch(),
+   * which reuses one workspace for all inputs, and check that both agree
+   * @return 0 if every mapping matches, -EINVAL otherwise
+   */
+  int bench_batch();
 };
 
 #endif
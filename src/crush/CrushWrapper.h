@@ -1617,6 +1617,35 @@ public:
       out[i] = rawout[i];
   }
 
+  /// map every input in xs with one rule.  unlike calling do_rule() for
+  /// each input, the workspace is sized, allocated and initialized (a
+  /// scan of every rule and bucket) and the choose_args are looked up only
+  /// once for the whole batch.
+  /// out receives xs.size() rows of maxout items; row i holds out_len[i]
+  /// valid items, exactly as do_rule() would return for xs[i].
+  template<typename WeightVector>
+  void do_rule_batch(int rule, const std::vector<int>& xs, int maxout,
+		     const WeightVector& weight,
+		     uint64_t choose_args_index,
+		     std::vector<int> *out,
+		     std::vector<int> *out_len) const {
+    out->resize(xs.size() * maxout);
+    out_len->resize(xs.size());
+    std::vector<char> work(crush_work_size(crush, maxout));
+    crush_init_workspace(crush, std::data(work));
+    crush_choose_arg_map arg_map = choose_args_get_with_fallback(
+      choose_args_index);
+    for (size_t i = 0; i < xs.size(); ++i) {
+      // the workspace only caches per-bucket permutations keyed by x, so
+      // it can be reused from one input to the next
+      int numrep = crush_do_rule(crush, rule, xs[i],
+				 std::data(*out) + i * maxout, maxout,
+				 std::data(weight), std::size(weight),
+				 std::data(work), arg_map.args);
+      (*out_len)[i] = std::max(numrep, 0);
+    }
+  }
+
   int _choose_type_stack(
     CephContext *cct,
     const std::vector<std::pair<int,int>>& stack,
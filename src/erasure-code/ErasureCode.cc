@@ -18,11 +18,13 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <cstring>
 
 #include "ErasureCode.h"
 
 #include "common/strtol.h"
 #include "include/buffer.h"
+#include "include/intarith.h"
 #include "crush/CrushWrapper.h"
 #include "osd/osd_types.h"
 
@@ -478,6 +480,169 @@ int ErasureCode::decode(const shard_id_set &want_to_read,
   return _decode(want_to_read, chunks, decoded);
 }
 
+int ErasureCode::encode_stripes(const shard_id_set &want_to_encode,
+                                const bufferlist &in,
+                                unsigned int stripe_width,
+                                shard_id_map<bufferlist> *encoded)
+{
+  unsigned int k = get_data_chunk_count();
+  unsigned int k_plus_m = get_chunk_count();
+
+  if (!encoded || !encoded->empty() || stripe_width == 0 ||
+      stripe_width % k != 0 || in.length() % stripe_width != 0) {
+    return -EINVAL;
+  }
+  unsigned int chunk_size = stripe_width / k;
+  unsigned int stripes = in.length() / stripe_width;
+  if (stripes == 0) {
+    return 0;
+  }
+  uint64_t length = (uint64_t)stripes * chunk_size;
+
+  /* Transpose the stripes into one aligned buffer per chunk, so that each
+   * chunk is allocated and copied exactly once for the whole batch. */
+  shard_id_map<bufferptr> in_shards(k_plus_m);
+  shard_id_map<bufferptr> out_shards(k_plus_m);
+  for (raw_shard_id_t raw_shard; raw_shard < k_plus_m; ++raw_shard) {
+    bufferptr bp = buffer::create_aligned(length, SIMD_ALIGN);
+    if (raw_shard < k) {
+      in_shards[chunk_index(raw_shard)] = bp;
+    } else {
+      out_shards[chunk_index(raw_shard)] = bp;
+    }
+  }
+  auto p = in.begin();
+  for (uint64_t off = 0; off < length; off += chunk_size) {
+    for (raw_shard_id_t raw_shard; raw_shard < k; ++raw_shard) {
+      p.copy(chunk_size, in_shards[chunk_index(raw_shard)].c_str() + off);
+    }
+  }
+
+  if (can_batch_stripes()) {
+    if (int r = encode_chunks(in_shards, out_shards); r) {
+      return r;
+    }
+  } else {
+    for (uint64_t off = 0; off < length; off += chunk_size) {
+      shard_id_map<bufferptr> in_stripe(k_plus_m);
+      shard_id_map<bufferptr> out_stripe(k_plus_m);
+      for (auto &&[shard, bp] : in_shards) {
+        in_stripe.emplace(shard, bufferptr(bp, off, chunk_size));
+      }
+      for (auto &&[shard, bp] : out_shards) {
+        out_stripe.emplace(shard, bufferptr(bp, off, chunk_size));
+      }
+      if (int r = encode_chunks(in_stripe, out_stripe); r) {
+        return r;
+      }
+      /* The plugin may have swapped a parity buffer for a zero buffer. */
+      for (auto &&[shard, bp] : out_stripe) {
+        char *dst = out_shards[shard].c_str() + off;
+        if (bp.c_str() != dst) {
+          memcpy(dst, bp.c_str(), chunk_size);
+        }
+      }
+    }
+  }
+
+  for (auto &&shard : want_to_encode) {
+    if (in_shards.contains(shard)) {
+      (*encoded)[shard].push_back(in_shards[shard]);
+    } else if (out_shards.contains(shard)) {
+      (*encoded)[shard].push_back(out_shards[shard]);
+    }
+  }
+  return 0;
+}
+
+int ErasureCode::decode_stripes(const shard_id_set &want_to_read,
+                                const shard_id_map<bufferlist> &chunks,
+                                unsigned int chunk_size,
+                                shard_id_map<bufferlist> *decoded)
+{
+  if (!decoded || !decoded->empty() || chunks.empty() || chunk_size == 0) {
+    return -EINVAL;
+  }
+  uint64_t length = chunks.begin()->second.length();
+  if (length % chunk_size != 0) {
+    return -EINVAL;
+  }
+  for (auto &&[shard, bl] : chunks) {
+    if (bl.length() != length) {
+      return -EINVAL;
+    }
+  }
+
+  if (length == chunk_size || can_batch_stripes()) {
+    return decode(want_to_read, chunks, decoded, chunk_size);
+  }
+
+  for (uint64_t off = 0; off < length; off += chunk_size) {
+    shard_id_map<bufferlist> stripe(get_chunk_count());
+    for (auto &&[shard, bl] : chunks) {
+      stripe[shard].substr_of(bl, off, chunk_size);
+    }
+    shard_id_map<bufferlist> stripe_decoded(get_chunk_count());
+    if (int r = decode(want_to_read, stripe, &stripe_decoded, chunk_size); r) {
+      return r;
+    }
+    for (auto &&shard : want_to_read) {
+      (*decoded)[shard].claim_append(stripe_decoded[shard]);
+    }
+  }
+  return 0;
+}
+
+namespace {
+struct ScratchBuffers {
+  std::vector<std::pair<char*, size_t>> buffers;
+  std::pair<char*, size_t> zeros = {nullptr, 0};
+
+  /* Buffers above this size are given back once requests shrink, so one
+   * huge stripe does not pin its memory for the life of the thread. */
+  static constexpr size_t max_retained = 4 << 20;
+
+  /* Returns true if buf was (re)allocated. */
+  static bool reserve(std::pair<char*, size_t> &buf, size_t size) {
+    if (buf.second >= size &&
+        (buf.second <= max_retained || buf.second / 4 < size)) {
+      return false;
+    }
+    free(buf.first);
+    buf.second = p2roundup<size_t>(size, ErasureCode::SIMD_ALIGN);
+    buf.first = static_cast<char*>(
+      aligned_alloc(ErasureCode::SIMD_ALIGN, buf.second));
+    ceph_assert(buf.first);
+    return true;
+  }
+
+  ~ScratchBuffers() {
+    for (auto &&[p, _] : buffers) {
+      free(p);
+    }
+    free(zeros.first);
+  }
+};
+thread_local ScratchBuffers scratch;
+}
+
+char *ErasureCode::get_scratch_buffer(unsigned int index, size_t size)
+{
+  if (scratch.buffers.size() <= index) {
+    scratch.buffers.resize(index + 1, {nullptr, 0});
+  }
+  ScratchBuffers::reserve(scratch.buffers[index], size);
+  return scratch.buffers[index].first;
+}
+
+const char *ErasureCode::get_zero_buffer(size_t size)
+{
+  if (ScratchBuffers::reserve(scratch.zeros, size)) {
+    memset(scratch.zeros.first, 0, scratch.zeros.second);
+  }
+  return scratch.zeros.first;
+}
+
 int ErasureCode::parse(const ErasureCodeProfile &profile,
 		       ostream *ss)
 {
@@ -111,6 +111,16 @@ class ErasureCode : public ErasureCodeInterface {
              const bufferlist &in,
              std::map<int, bufferlist> *encoded) override;
 
+  int encode_stripes(const shard_id_set &want_to_encode,
+                     const bufferlist &in,
+                     unsigned int stripe_width,
+                     mini_flat_map<shard_id_t, bufferlist> *encoded) override;
+
+  int decode_stripes(const shard_id_set &want_to_read,
+                     const mini_flat_map<shard_id_t, bufferlist> &chunks,
+                     unsigned int chunk_size,
+                     mini_flat_map<shard_id_t, bufferlist> *decoded) override;
+
   [[deprecated]]
   int decode(const std::set<int> &want_to_read,
              const std::map<int, bufferlist> &chunks,
@@ -174,6 +184,18 @@ class ErasureCode : public ErasureCodeInterface {
  protected:
   int parse(const ErasureCodeProfile &profile, std::ostream *ss);
 
+  /* True if encode_chunks and decode_chunks accept chunks spanning
+   * several stripes, i.e. the plugin supports the optimized EC path. */
+  bool can_batch_stripes() const {
+    return get_supported_optimizations() & FLAG_EC_PLUGIN_OPTIMIZED_SUPPORTED;
+  }
+
+  /* SIMD aligned scratch buffer owned by the calling thread and reused
+   * across calls. Each index is a distinct buffer of at least size bytes;
+   * zero buffers are read only and always contain zeros. */
+  static char *get_scratch_buffer(unsigned int index, size_t size);
+  static const char *get_zero_buffer(size_t size);
+
  private:
   [[deprecated]]
   unsigned int chunk_index(unsigned int i) const;
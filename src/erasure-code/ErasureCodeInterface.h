@@ -448,6 +448,28 @@ namespace ceph {
     virtual int encode_chunks(const shard_id_map<bufferptr> &in,
                               shard_id_map<bufferptr> &out) = 0;
 
+    /**
+     * Encode a batch of consecutive stripes from **in** and store the
+     * result in **encoded**. The length of **in** must be a multiple of
+     * **stripe_width**, which must itself be a multiple of the number of
+     * data chunks.
+     *
+     * The result is identical to calling **encode** once per stripe
+     * and appending the chunks of each stripe to **encoded**, but each
+     * chunk is allocated once for the whole batch and plugins that can
+     * encode chunks spanning several stripes do so in a single pass.
+     *
+     * @param [in] want_to_encode chunk indexes to be encoded
+     * @param [in] in stripes to be encoded
+     * @param [in] stripe_width number of data bytes per stripe
+     * @param [out] encoded map chunk indexes to chunk data
+     * @return **0** on success or a negative errno on error.
+     */
+    virtual int encode_stripes(const shard_id_set &want_to_encode,
+                               const bufferlist &in,
+                               unsigned int stripe_width,
+                               shard_id_map<bufferlist> *encoded) = 0;
+
     /**
      * Calculate the delta between the old_data and new_data buffers using xor,
      * (or plugin-specific implementation) and returns the result in the
@@ -576,6 +598,27 @@ namespace ceph {
                               const std::map<int, bufferlist> &chunks,
                               std::map<int, bufferlist> *decoded) = 0;
 
+    /**
+     * Decode a batch of consecutive stripes. Every buffer in **chunks**
+     * holds the same number of chunks of **chunk_size** bytes, one per
+     * stripe, and **decoded** receives **want_to_read** chunks of the
+     * same length.
+     *
+     * The result is identical to calling **decode** once per stripe
+     * and appending the decoded chunks, but plugins that can decode
+     * chunks spanning several stripes do so in a single pass.
+     *
+     * @param [in] want_to_read chunk indexes to be decoded
+     * @param [in] chunks map chunk indexes to chunk data
+     * @param [in] chunk_size size of the chunk of each stripe
+     * @param [out] decoded map chunk indexes to chunk data
+     * @return **0** on success or a negative errno on error.
+     */
+    virtual int decode_stripes(const shard_id_set &want_to_read,
+                               const shard_id_map<bufferlist> &chunks,
+                               unsigned int chunk_size,
+                               shard_id_map<bufferlist> *decoded) = 0;
+
     /**
      * Return the ordered list of chunks or an empty vector
      * if no remapping is necessary.
@@ -140,27 +140,22 @@ int ErasureCodeIsa::encode_chunks(const shard_id_map<bufferptr> &in,
     chunks[static_cast<int>(shard)] = ptr.c_str();
   }
 
-  char *zeros = nullptr;
-
   for (shard_id_t i; i < k + m; ++i) {
     if (in.contains(i) || out.contains(i)) {
       continue;
     }
-
-    if (zeros == nullptr) {
-      zeros = (char*)malloc(size);
-      memset(zeros, 0, size);
+    /* A missing data shard reads as zeros; a missing parity shard is still
+     * written by the encode, so it must not share the zero buffer. */
+    if (i < k) {
+      chunks[static_cast<int>(i)] = const_cast<char*>(get_zero_buffer(size));
+    } else {
+      chunks[static_cast<int>(i)] =
+        get_scratch_buffer(static_cast<int>(i), size);
     }
-
-    chunks[static_cast<int>(i)] = zeros;
   }
 
   isa_encode(&chunks[0], &chunks[k], size);
 
-  if (zeros != nullptr) {
-    free(zeros);
-  }
-
   return 0;
 }
 
@@ -170,7 +165,6 @@ int ErasureCodeIsa::decode_chunks(const shard_id_set &want_to_read,
 {
   unsigned int size = 0;
   shard_id_set erasures_set;
-  shard_id_set to_free;
   erasures_set.insert_range(shard_id_t(0), k + m);
   int erasures[k + m + 1];
   int erasures_count = 0;
@@ -212,9 +206,7 @@ int ErasureCodeIsa::decode_chunks(const shard_id_set &want_to_read,
   for (int i = 0; i < k + m; i++) {
     char **buf = i < k ? &data[i] : &coding[i - k];
     if (*buf == nullptr) {
-      *buf = (char *)malloc(size);
-      ceph_assert(buf != nullptr);
-      to_free.insert(shard_id_t(i));
+      *buf = get_scratch_buffer(i, size);
       /* If buffer was not provided, is not an erasure (i.e. in the out map),
        * and a data shard, then it can be assumed to be zero. This is most
        * likely due to EC shards being different sizes.
@@ -232,14 +224,7 @@ int ErasureCodeIsa::decode_chunks(const shard_id_set &want_to_read,
 
   erasures[erasures_count] = -1;
   ceph_assert(erasures_count > 0);
-  int r = isa_decode(erasures, data, coding, size);
-  for (auto & shard : to_free) {
-    int i = static_cast<int>(shard);
-    char **buf = i < k ? &data[i] : &coding[i - k];
-    free(*buf);
-    *buf = nullptr;
-  }
-  return r;
+  return isa_decode(erasures, data, coding, size);
 }
 
 // -----------------------------------------------------------------------------
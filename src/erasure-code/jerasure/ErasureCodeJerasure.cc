@@ -139,23 +139,22 @@ int ErasureCodeJerasure::encode_chunks(const shard_id_map<bufferptr> &in,
     chunks[static_cast<int>(shard)] = ptr.c_str();
   }
 
-  char *zeros = nullptr;
-
   for (shard_id_t i; i < k + m; ++i) {
-    if (in.contains(i) || out.contains(i)) continue;
-
-    if (zeros == nullptr) {
-      zeros = (char*)malloc(size);
-      memset(zeros, 0, size);
+    if (in.contains(i) || out.contains(i)) {
+      continue;
+    }
+    /* A missing data shard reads as zeros; a missing parity shard is still
+     * written by the encode, so it must not share the zero buffer. */
+    if (i < k) {
+      chunks[static_cast<int>(i)] = const_cast<char*>(get_zero_buffer(size));
+    } else {
+      chunks[static_cast<int>(i)] =
+        get_scratch_buffer(static_cast<int>(i), size);
     }
-
-    chunks[static_cast<int>(i)] = zeros;
   }
 
   jerasure_encode(&chunks[0], &chunks[k], size);
 
-  if (zeros != nullptr) free(zeros);
-
   return 0;
 }
 
@@ -192,7 +191,6 @@ int ErasureCodeJerasure::decode_chunks(const shard_id_set &want_to_read,
 {
   unsigned int size = 0;
   shard_id_set erasures_set;
-  shard_id_set to_free;
   erasures_set.insert_range(shard_id_t(0), k + m);
   int erasures[k + m + 1];
   int erasures_count = 0;
@@ -226,8 +224,7 @@ int ErasureCodeJerasure::decode_chunks(const shard_id_set &want_to_read,
   for (int i = 0; i < k + m; i++) {
     char **buf = i < k ? &data[i] : &coding[i - k];
     if (*buf == nullptr) {
-      *buf = (char *)malloc(size);
-      to_free.insert(shard_id_t(i));
+      *buf = get_scratch_buffer(i, size);
       /* If we are inventing a buffer for non-erasure shard, its zeros! */
       if (i < k && !erasures_set.contains(shard_id_t(i))) {
         memset(*buf, 0, size);
@@ -241,14 +238,7 @@ int ErasureCodeJerasure::decode_chunks(const shard_id_set &want_to_read,
   erasures[erasures_count] = -1;
   ceph_assert(erasures_count > 0);
 
-  int r = jerasure_decode(erasures, data, coding, size);
-  for (auto & shard : to_free) {
-    int i = static_cast<int>(shard);
-    char **buf = i < k ? &data[i] : &coding[i - k];
-    free(*buf);
-    *buf = nullptr;
-  }
-  return r;
+  return jerasure_decode(erasures, data, coding, size);
 }
 
 void ErasureCodeJerasure::encode_delta(const bufferptr &old_data,
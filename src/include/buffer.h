@@ -1230,6 +1230,10 @@ struct error_code;
     iov_vec_t prepare_iovs() const;
 
     uint32_t crc32c(uint32_t crc) const;
+    /// crc32c of several lists at once; crcs holds the initial value
+    /// for each list on input and its crc on output
+    static void crc32c_multi(const list* const* bls, uint32_t* crcs,
+			     unsigned n);
     void invalidate_crc();
 
     // These functions return a bufferlist with a pointer to a single
@@ -1,6 +1,7 @@
 #ifndef CEPH_CRC32C_H
 #define CEPH_CRC32C_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -17,6 +18,16 @@ extern ceph_crc32c_func_t ceph_crc32c_func;
 
 extern ceph_crc32c_func_t ceph_choose_crc32(void);
 
+typedef void (*ceph_crc32c_multi_func_t)(uint32_t *crcs, unsigned char const * const *data,
+					 unsigned const *lengths, unsigned n);
+
+/*
+ * implementation of ceph_crc32c_multi for the given architecture.
+ */
+extern ceph_crc32c_multi_func_t ceph_crc32c_multi_func;
+
+extern ceph_crc32c_multi_func_t ceph_choose_crc32c_multi(void);
+
 /**
  * calculate crc32c for data that is entirely 0 (ZERO)
  *
@@ -50,6 +61,38 @@ static inline uint32_t ceph_crc32c(uint32_t crc, unsigned char const *data, unsi
   return ceph_crc32c_func(crc, data, length);
 }
 
+/**
+ * calculate crc32c of several independent buffers
+ *
+ * The buffers are processed in interleaved streams where the CPU
+ * allows it, which is faster than one at a time for short buffers.
+ *
+ * @param crcs in: initial value for each buffer, out: its crc
+ * @param data pointers to the buffers; NULL is zero-filled
+ * @param lengths length of each buffer
+ * @param n number of buffers
+ */
+static inline void ceph_crc32c_multi(uint32_t *crcs, unsigned char const * const *data,
+				     unsigned const *lengths, unsigned n)
+{
+  ceph_crc32c_multi_func(crcs, data, lengths, n);
+}
+
+/**
+ * combine the crc32c of two adjacent buffers
+ *
+ * crc32c(A+B, v) from crc_a = crc32c(A, v) and crc_b = crc32c(B, 0):
+ * crc_a is shifted over length_b zero bytes, as ceph_crc32c_zeros.
+ *
+ * @param crc_a crc of the first buffer, with any initial value
+ * @param crc_b crc of the second buffer, with initial value 0
+ * @param length_b length of the second buffer
+ */
+static inline uint32_t ceph_crc32c_combine(uint32_t crc_a, uint32_t crc_b, unsigned length_b)
+{
+  return crc_b ^ ceph_crc32c(crc_a, NULL, length_b);
+}
+
 #ifdef __cplusplus
 }
 #endif
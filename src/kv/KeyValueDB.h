@@ -167,6 +167,17 @@ public:
 
   virtual Transaction get_transaction() = 0;
   virtual int submit_transaction(Transaction) = 0;
+  /// submit several transactions, in order, as a single write when
+  /// the backend supports it
+  virtual int submit_transactions(const std::vector<Transaction>& ts) {
+    for (auto& t : ts) {
+      int r = submit_transaction(t);
+      if (r < 0) {
+        return r;
+      }
+    }
+    return 0;
+  }
   virtual int submit_transaction_sync(Transaction t) {
     return submit_transaction(t);
   }
@@ -18,6 +18,7 @@
 #include "rocksdb/slice.h"
 #include "rocksdb/cache.h"
 #include "rocksdb/filter_policy.h"
+#include "rocksdb/slice_transform.h"
 #include "rocksdb/utilities/convenience.h"
 #include "rocksdb/utilities/table_properties_collectors.h"
 #include "rocksdb/merge_operator.h"
@@ -631,6 +632,7 @@ void RocksDBStore::add_column_family(const std::string& cf_name, uint32_t hash_l
     ceph_assert(hash_l < hash_h);
     column.hash_l = hash_l;
     column.hash_h = hash_h;
+    column.prefix_extractor = db->GetOptions(handle).prefix_extractor;
   }
   if (column.handles.size() <= shard_idx)
     column.handles.resize(shard_idx + 1);
@@ -705,6 +707,48 @@ rocksdb::ColumnFamilyHandle *RocksDBStore::check_cf_handle_bounds(const cf_handl
   }
 }
 
+/**
+ * Column families may define a prefix_extractor, and rocksdb then seeks
+ * by prefix unless told otherwise, which is only correct when iteration
+ * stays within the prefix of the seek key.  Iterators are therefore
+ * total order, except when both bounds extract to the same prefix: every
+ * key between them has that prefix too, and prefix filters can skip the
+ * SST files that do not contain it.
+ */
+rocksdb::ReadOptions RocksDBStore::get_iterator_options(
+  rocksdb::ColumnFamilyHandle *cf,
+  const IteratorBounds& bounds,
+  const rocksdb::Slice* lower,
+  const rocksdb::Slice* upper) const
+{
+  rocksdb::ReadOptions options;
+  options.total_order_seek = true;
+  if (!cct->_conf->osd_rocksdb_iterator_bounds_enabled) {
+    return options;
+  }
+  if (bounds.lower_bound) {
+    options.iterate_lower_bound = lower;
+  }
+  if (bounds.upper_bound) {
+    options.iterate_upper_bound = upper;
+  }
+  if (!bounds.lower_bound || !bounds.upper_bound) {
+    return options;
+  }
+  auto p = cf_ids_to_prefix.find(cf->GetID());
+  if (p == cf_ids_to_prefix.end()) {
+    return options;
+  }
+  auto& extractor = cf_handles.at(p->second).prefix_extractor;
+  if (extractor &&
+      extractor->InDomain(*lower) && extractor->InDomain(*upper) &&
+      extractor->Transform(*lower) == extractor->Transform(*upper)) {
+    options.total_order_seek = false;
+    options.prefix_same_as_start = true;
+  }
+  return options;
+}
+
 /**
  * Definition of sharding:
  * space-separated list of: column_def [ '=' options ]
@@ -1634,6 +1678,40 @@ int RocksDBStore::submit_transaction(KeyValueDB::Transaction t)
   return result;
 }
 
+// Concatenate the already encoded batches behind a single header,
+// which is what WriteBatchInternal::Append() does.  Every key and
+// value is moved in bulk with its batch, not re-encoded.
+int RocksDBStore::submit_transactions(
+  const std::vector<KeyValueDB::Transaction>& ts)
+{
+  if (ts.size() == 1) {
+    return submit_transaction(ts.front());
+  }
+  // WriteBatch rep: fixed64 sequence, fixed32 count, records
+  constexpr size_t header = 12;
+  size_t len = header;
+  uint32_t count = 0;
+  for (auto& t : ts) {
+    auto& bat = static_cast<RocksDBTransactionImpl*>(t.get())->bat;
+    len += bat.GetDataSize() - header;
+    count += bat.Count();
+  }
+  std::string rep;
+  rep.reserve(len);
+  rep.append(header, '\0');
+  for (auto& t : ts) {
+    auto& data = static_cast<RocksDBTransactionImpl*>(t.get())->bat.Data();
+    rep.append(data, header, std::string::npos);
+  }
+  for (int i = 0; i < 4; i++) {
+    rep[8 + i] = char(count >> (8 * i));  // little endian
+  }
+
+  auto merged = std::make_shared<RocksDBTransactionImpl>(this);
+  merged->bat = rocksdb::WriteBatch(std::move(rep));
+  return submit_transaction(merged);
+}
+
 int RocksDBStore::submit_transaction_sync(KeyValueDB::Transaction t)
 {
   utime_t start = ceph_clock_now();
@@ -2352,15 +2430,8 @@ public:
       iterate_lower_bound(make_slice(bounds.lower_bound)),
       iterate_upper_bound(make_slice(bounds.upper_bound))
       {
-      auto options = rocksdb::ReadOptions();
-      if (db->cct->_conf->osd_rocksdb_iterator_bounds_enabled) {
-        if (bounds.lower_bound) {
-          options.iterate_lower_bound = &iterate_lower_bound;
-        }
-        if (bounds.upper_bound) {
-          options.iterate_upper_bound = &iterate_upper_bound;
-        }
-      }
+      auto options = db->get_iterator_options(
+        cf, bounds, &iterate_lower_bound, &iterate_upper_bound);
       dbiter = db->db->NewIterator(options, cf);
   }
   ~CFIteratorImpl() {
@@ -2945,15 +3016,9 @@ public:
       iterate_upper_bound(make_slice(bounds.upper_bound))
   {
     iters.reserve(shards.size());
-    auto options = rocksdb::ReadOptions();
-    if (db->cct->_conf->osd_rocksdb_iterator_bounds_enabled) {
-      if (bounds.lower_bound) {
-        options.iterate_lower_bound = &iterate_lower_bound;
-      }
-      if (bounds.upper_bound) {
-        options.iterate_upper_bound = &iterate_upper_bound;
-      }
-    }
+    // all shards share the column options
+    auto options = db->get_iterator_options(
+      shards.front(), bounds, &iterate_lower_bound, &iterate_upper_bound);
     for (auto& s : shards) {
       iters.push_back(db->db->NewIterator(options, s));
     }
@@ -3476,8 +3541,10 @@ int RocksDBStore::reshard(const std::string& new_sharding, const RocksDBStore::r
 			    const std::string& fixed_prefix)
   {
     dout(5) << " column=" << (void*)handle << " prefix=" << fixed_prefix << dendl;
+    rocksdb::ReadOptions ropts;
+    ropts.total_order_seek = true;
     std::unique_ptr<rocksdb::Iterator> it{
-      db->NewIterator(rocksdb::ReadOptions(), handle)};
+      db->NewIterator(ropts, handle)};
     ceph_assert(it);
 
     rocksdb::WriteBatch bat;
@@ -3491,7 +3558,7 @@ int RocksDBStore::reshard(const std::string& new_sharding, const RocksDBStore::r
 	bytes_per_iterator = 0;
 	keys_per_iterator = 0;
 	std::string raw_key_str = raw_key.ToString();
-	it.reset(db->NewIterator(rocksdb::ReadOptions(), handle));
+	it.reset(db->NewIterator(ropts, handle));
 	ceph_assert(it);
 	it->Seek(raw_key_str);
 	ceph_assert(it->Valid());
@@ -62,7 +62,9 @@ namespace rocksdb{
   class Iterator;
   class Logger;
   class ColumnFamilyHandle;
+  class SliceTransform;
   struct Options;
+  struct ReadOptions;
   struct BlockBasedTableOptions;
   struct DBOptions;
   struct ColumnFamilyOptions;
@@ -126,6 +128,8 @@ private:
     uint32_t hash_l;  //< first character to take for hash calc.
     uint32_t hash_h;  //< last character to take for hash calc.
     std::vector<rocksdb::ColumnFamilyHandle *> handles;
+    /// prefix_extractor of the column options, same for all shards
+    std::shared_ptr<const rocksdb::SliceTransform> prefix_extractor;
   };
   std::unordered_map<std::string, prefix_shards> cf_handles;
   typedef decltype(cf_handles)::iterator cf_handles_iterator;
@@ -140,6 +144,10 @@ private:
   rocksdb::ColumnFamilyHandle *get_cf_handle(const std::string& prefix, const std::string& key);
   rocksdb::ColumnFamilyHandle *get_cf_handle(const std::string& prefix, const char* key, size_t keylen);
   rocksdb::ColumnFamilyHandle *check_cf_handle_bounds(const cf_handles_iterator& it, const IteratorBounds& bounds);
+  rocksdb::ReadOptions get_iterator_options(rocksdb::ColumnFamilyHandle *cf,
+					    const IteratorBounds& bounds,
+					    const rocksdb::Slice* lower,
+					    const rocksdb::Slice* upper) const;
 
   int submit_common(rocksdb::WriteOptions& woptions, KeyValueDB::Transaction t);
   int install_cf_mergeop(const std::string &cf_name, rocksdb::ColumnFamilyOptions *cf_opt);
@@ -346,6 +354,7 @@ public:
   }
 
   int submit_transaction(KeyValueDB::Transaction t) override;
+  int submit_transactions(const std::vector<KeyValueDB::Transaction>& ts) override;
   int submit_transaction_sync(KeyValueDB::Transaction t) override;
   int get(
     const std::string &prefix,
@@ -374,6 +383,8 @@ public:
                                            const KeyValueDB::IteratorOpts opts)
       {
         rocksdb::ReadOptions options = rocksdb::ReadOptions();
+        // whole column walks cross prefixes
+        options.total_order_seek = true;
         if (opts & ITERATOR_NOCACHE)
           options.fill_cache=false;
         dbiter = db->db->NewIterator(options, cf);
@@ -18,6 +18,7 @@
 
 #include "MOSDFastDispatchOp.h"
 #include "osd/ECMsgTypes.h"
+#include "msg/MessagePool.h"
 
 class MOSDECSubOpWrite : public MOSDFastDispatchOp {
 private:
@@ -25,6 +26,8 @@ private:
   static constexpr int COMPAT_VERSION = 1;
 
 public:
+  MESSAGE_POOL_CLASS_HELPERS(MOSDECSubOpWrite)
+
   spg_t pgid;
   epoch_t map_epoch = 0, min_epoch = 0;
   ECSubWrite op;
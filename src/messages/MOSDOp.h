@@ -25,6 +25,7 @@
 #include "include/ceph_features.h"
 #include "include/ceph_fs.h" // for CEPH_MSG_OSD_OP
 #include "common/hobject.h"
+#include "msg/MessagePool.h"
 
 /*
  * OSD op
@@ -204,6 +205,8 @@ private:
   ~MOSDOp() final {}
 
 public:
+  MESSAGE_POOL_CLASS_HELPERS(MOSDOp)
+
   void set_mtime(utime_t mt) { mtime = mt; }
   void set_mtime(ceph::real_time mt) {
     mtime = ceph::real_clock::to_timespec(mt);
@@ -18,6 +18,7 @@
 #define CEPH_MOSDREPOP_H
 
 #include "MOSDFastDispatchOp.h"
+#include "msg/MessagePool.h"
 
 /*
  * OSD sub op - for internal ops on pobjects between primary and replicas(/stripes/whatever)
@@ -195,6 +196,8 @@ private:
   ~MOSDRepOp() final {}
 
 public:
+  MESSAGE_POOL_CLASS_HELPERS(MOSDRepOp)
+
   std::string_view get_type_name() const override { return "osd_repop"; }
   void print(std::ostream& out) const override {
     out << "osd_repop(" << reqid
@@ -834,6 +834,7 @@ void OSDMonitor::update_from_paxos(bool *need_bootstrap)
     dout(7) << "update_from_paxos  applying incremental " << osdmap.epoch+1
 	    << dendl;
     OSDMap::Incremental inc(inc_bl);
+    mapping_delta.note_incremental(osdmap, inc);
     err = osdmap.apply_incremental(inc);
     ceph_assert(err == 0);
 
@@ -1081,15 +1082,27 @@ void OSDMonitor::start_mapping()
   }
   if (!osdmap.get_pools().empty()) {
     auto fin = new C_UpdateCreatingPGs(this, osdmap.get_epoch());
-    mapping_job = mapping.start_update(osdmap, mapper,
-				       g_conf()->mon_osd_mapping_pgs_per_chunk);
-    dout(10) << __func__ << " started mapping job " << mapping_job.get()
+    bool incremental =
+      g_conf().get_val<bool>("mon_osd_mapping_incremental") &&
+      mapping.can_apply(osdmap, mapping_delta);
+    if (incremental) {
+      mapping_job = mapping.start_update(
+	osdmap, mapper, g_conf()->mon_osd_mapping_pgs_per_chunk,
+	mapping_delta);
+    } else {
+      mapping_job = mapping.start_update(
+	osdmap, mapper, g_conf()->mon_osd_mapping_pgs_per_chunk);
+    }
+    dout(10) << __func__ << " started "
+	     << (incremental ? "incremental " : "")
+	     << "mapping job " << mapping_job.get()
 	     << " at " << fin->start << dendl;
     mapping_job->set_finish_event(fin);
   } else {
     dout(10) << __func__ << " no pools, no mapping job" << dendl;
     mapping_job = nullptr;
   }
+  mapping_delta.reset(osdmap.get_epoch());
 }
 
 void OSDMonitor::update_msgr_features()
@@ -390,6 +390,7 @@ private:
   ParallelPGMapper mapper;                        ///< for background pg work
   OSDMapMapping mapping;                          ///< pg <-> osd mappings
   std::unique_ptr<ParallelPGMapper::Job> mapping_job;  ///< background mapping job
+  OSDMapMapping::Delta mapping_delta;             ///< changes since last mapping
   void start_mapping();
 
   void update_logger();
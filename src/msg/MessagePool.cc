@@ -0,0 +1,54 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab
+
+#include "msg/MessagePool.h"
+
+namespace ceph::msg {
+
+namespace {
+// pools are never destroyed, so the registry is a plain list
+std::mutex registry_lock;
+MessagePoolBase *registry_head = nullptr;
+}
+
+MessagePoolBase::MessagePoolBase(const char *name)
+  : name(name)
+{
+  std::lock_guard l(registry_lock);
+  next = registry_head;
+  registry_head = this;
+}
+
+void MessagePoolBase::flush_stats(thread_stats_t& s)
+{
+  heap_allocs += s.heap_allocs;
+  pool_allocs += s.pool_allocs;
+  frees += s.frees;
+  heap_frees += s.heap_frees;
+  heap_alloc_ns += s.heap_alloc_ns;
+  s = thread_stats_t();
+}
+
+void MessagePoolBase::dump(ceph::Formatter *f) const
+{
+  uint64_t heap = heap_allocs;
+  uint64_t ns = heap_alloc_ns;
+  f->dump_unsigned("heap_allocs", heap);
+  f->dump_unsigned("pool_allocs", pool_allocs);
+  f->dump_unsigned("frees", frees);
+  f->dump_unsigned("heap_frees", heap_frees);
+  f->dump_unsigned("heap_alloc_avg_ns", heap ? ns / heap : 0);
+  f->dump_unsigned("depot_magazines", get_depot_size());
+}
+
+void MessagePoolBase::dump_all(ceph::Formatter *f)
+{
+  std::lock_guard l(registry_lock);
+  for (auto p = registry_head; p; p = p->next) {
+    f->open_object_section(p->get_name());
+    p->dump(f);
+    f->close_section();
+  }
+}
+
+} // namespace ceph::msg
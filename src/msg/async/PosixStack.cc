@@ -20,8 +20,12 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
 
 #include <algorithm>
+#include <deque>
 
 #include "PosixStack.h"
 
@@ -38,16 +42,145 @@
 #undef dout_prefix
 #define dout_prefix *_dout << "PosixStack "
 
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#define HAVE_MSG_ZEROCOPY
+#endif
+
+#ifdef HAVE_MSG_ZEROCOPY
+// Buffers of MSG_ZEROCOPY sends the kernel may still read from. Every
+// successful MSG_ZEROCOPY sendmsg() is numbered by the kernel, and
+// completions report ranges of these numbers. Sent buffers are held,
+// tagged with the last number they were part of, until that completes.
+// TCP reports completions in order.
+struct ZerocopyPending {
+  std::deque<std::pair<uint32_t, ceph::buffer::list>> sends;
+  uint32_t next_seq = 0;
+
+  bool empty() const {
+    return sends.empty();
+  }
+
+  // hold bl until every zerocopy sendmsg() so far has completed
+  void hold(ceph::buffer::list&& bl) {
+    sends.emplace_back(next_seq - 1, std::move(bl));
+  }
+
+  // Release the buffers of completed sends. Completions are read from
+  // the socket error queue, which never blocks. Returns true if the
+  // kernel reported that it copied the data anyway.
+  bool reap(int fd) {
+    bool copied = false;
+    while (!sends.empty()) {
+      char control[CMSG_SPACE(sizeof(struct sock_extended_err)) * 4];
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      if (::recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+	break;
+      }
+      for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm;
+	   cm = CMSG_NXTHDR(&msg, cm)) {
+	if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+	    !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)) {
+	  continue;
+	}
+	auto serr = reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cm));
+	if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+	  continue;
+	}
+	if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+	  copied = true;
+	}
+	uint32_t hi = serr->ee_data;
+	while (!sends.empty() &&
+	       static_cast<int32_t>(sends.front().first - hi) <= 0) {
+	  sends.pop_front();
+	}
+      }
+    }
+    return copied;
+  }
+};
+
+// Data queued on a socket is still sent after close(), so a closed
+// connection with zerocopy sends outstanding keeps its fd, and the
+// buffers, until the kernel completes them. The error queue is polled
+// from the worker's event loop; if the sends do not complete within
+// linger_timeout the connection is reset, which drops the queued data.
+class C_zerocopy_linger : public EventCallback {
+  static constexpr uint64_t poll_interval_us = 10000;
+  static constexpr auto linger_timeout = std::chrono::seconds(30);
+
+  CephContext *cct;
+  EventCenter *center;
+  int fd;
+  ZerocopyPending pending;
+  ceph::mono_time deadline;
+
+ public:
+  C_zerocopy_linger(CephContext *cct, EventCenter *center, int fd,
+		    ZerocopyPending&& pending)
+    : cct(cct), center(center), fd(fd), pending(std::move(pending)),
+      deadline(ceph::mono_clock::now() + linger_timeout) {}
+
+  void do_request(uint64_t id) override {
+    pending.reap(fd);
+    if (!pending.empty() && ceph::mono_clock::now() < deadline) {
+      center->create_time_event(poll_interval_us, this);
+      return;
+    }
+    if (!pending.empty()) {
+      ldout(cct, 1) << __func__ << " fd=" << fd << " " << pending.sends.size()
+		    << " zerocopy sends did not complete, resetting" << dendl;
+      struct linger l = {1, 0};
+      ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+    }
+    compat_closesocket(fd);
+    delete this;
+  }
+};
+#endif
+
 class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   ceph::NetHandler &handler;
   int _fd;
   entity_addr_t sa;
   bool connected;
+  CephContext *cct;
+  PerfCounters *logger;
+  EventCenter *center;
+  // sends of at least this many bytes use MSG_ZEROCOPY, 0 = never
+  uint64_t zerocopy_min_size = 0;
+  SocketSendStats stats;
+#ifdef HAVE_MSG_ZEROCOPY
+  ZerocopyPending zerocopy;
+#endif
 
  public:
   explicit PosixConnectedSocketImpl(ceph::NetHandler &h, const entity_addr_t &sa,
-				    int f, bool connected)
-      : handler(h), _fd(f), sa(sa), connected(connected) {}
+				    int f, bool connected, CephContext *cct,
+				    PerfCounters *logger, EventCenter *center)
+      : handler(h), _fd(f), sa(sa), connected(connected), cct(cct),
+	logger(logger), center(center) {
+#ifdef HAVE_MSG_ZEROCOPY
+    uint64_t min_size = cct->_conf->ms_async_zerocopy_min_size;
+    if (min_size) {
+      int one = 1;
+      if (::setsockopt(_fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0) {
+	zerocopy_min_size = min_size;
+      } else {
+	ldout(cct, 5) << __func__ << " fd=" << _fd
+		      << " unable to enable SO_ZEROCOPY: "
+		      << cpp_strerror(ceph_sock_errno()) << dendl;
+      }
+    }
+#endif
+  }
+
+  SocketSendStats get_send_stats() const override {
+    return stats;
+  }
 
   int is_connected() override {
     if (connected)
@@ -65,6 +198,10 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   }
 
   ssize_t read(char *buf, size_t len) override {
+#ifdef HAVE_MSG_ZEROCOPY
+    // completions raise EPOLLERR, which wakes us up as readable
+    reap_zerocopy();
+#endif
     #ifdef _WIN32
     ssize_t r = ::recv(_fd, buf, len, 0);
     #else
@@ -78,23 +215,39 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   // return the sent length
   // < 0 means error occurred
   #ifndef _WIN32
-  static ssize_t do_sendmsg(int fd, struct msghdr &msg, unsigned len, bool more)
+  // *zerocopy_calls and *zerocopy_sent count the successful sendmsg()
+  // calls made with MSG_ZEROCOPY and the bytes they sent
+  static ssize_t do_sendmsg(int fd, struct msghdr &msg, unsigned len, bool more,
+			    int flags, unsigned *zerocopy_calls,
+			    size_t *zerocopy_sent)
   {
     size_t sent = 0;
     while (1) {
       MSGR_SIGPIPE_STOPPER;
       ssize_t r;
-      r = ::sendmsg(fd, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+      r = ::sendmsg(fd, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0) | flags);
       if (r < 0) {
         int err = ceph_sock_errno();
         if (err == EINTR) {
           continue;
         } else if (err == EAGAIN) {
           break;
+#ifdef HAVE_MSG_ZEROCOPY
+        } else if (err == ENOBUFS && (flags & MSG_ZEROCOPY)) {
+          // out of optmem for completion notifications, copy instead
+          flags &= ~MSG_ZEROCOPY;
+          continue;
+#endif
         }
         return -err;
       }
 
+#ifdef HAVE_MSG_ZEROCOPY
+      if (flags & MSG_ZEROCOPY) {
+        ++*zerocopy_calls;
+        *zerocopy_sent += r;
+      }
+#endif
       sent += r;
       if (len == sent) break;
 
@@ -114,8 +267,26 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
     return (ssize_t)sent;
   }
 
+#ifdef HAVE_MSG_ZEROCOPY
+  void reap_zerocopy() {
+    if (zerocopy.empty()) {
+      return;
+    }
+    if (zerocopy.reap(_fd) && zerocopy_min_size) {
+      // the kernel copied anyway, deferring the copy only costs us
+      ldout(cct, 10) << __func__ << " fd=" << _fd
+		     << " kernel copied zerocopy send, disabling" << dendl;
+      zerocopy_min_size = 0;
+    }
+  }
+#endif
+
   ssize_t send(ceph::buffer::list &bl, bool more) override {
+#ifdef HAVE_MSG_ZEROCOPY
+    reap_zerocopy();
+#endif
     size_t sent_bytes = 0;
+    size_t zerocopy_bytes = 0;
     auto pb = std::cbegin(bl.buffers());
     uint64_t left_pbrs = bl.get_num_buffers();
     while (left_pbrs) {
@@ -134,7 +305,23 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
 	msglen += pb->length();
 	++pb;
       }
-      ssize_t r = do_sendmsg(_fd, msg, msglen, left_pbrs || more);
+      int flags = 0;
+#ifdef HAVE_MSG_ZEROCOPY
+      if (zerocopy_min_size && msglen >= zerocopy_min_size) {
+	flags = MSG_ZEROCOPY;
+      }
+#endif
+      unsigned zerocopy_calls = 0;
+      ssize_t r = do_sendmsg(_fd, msg, msglen, left_pbrs || more, flags,
+			     &zerocopy_calls, &zerocopy_bytes);
+#ifdef HAVE_MSG_ZEROCOPY
+      zerocopy.next_seq += zerocopy_calls;
+      if (r < 0 && zerocopy_bytes) {
+	// the caller drops bl on error, but part of it is already queued
+	// in the kernel; keep all of it until that completes
+	zerocopy.hold(ceph::buffer::list(bl));
+      }
+#endif
       if (r < 0)
         return r;
 
@@ -151,8 +338,23 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
         bl.splice(sent_bytes, bl.length()-sent_bytes, &swapped);
         bl.swap(swapped);
       } else {
-        bl.clear();
+        swapped.swap(bl);
+      }
+#ifdef HAVE_MSG_ZEROCOPY
+      // the kernel may still read from the sent buffers
+      if (zerocopy_bytes) {
+        zerocopy.hold(std::move(swapped));
       }
+#endif
+    }
+
+    stats.zerocopy_bytes += zerocopy_bytes;
+    stats.copied_bytes += sent_bytes - zerocopy_bytes;
+    if (logger) {
+      if (zerocopy_bytes) {
+        logger->inc(l_msgr_send_zerocopy_bytes, zerocopy_bytes);
+      }
+      logger->inc(l_msgr_send_copied_bytes, sent_bytes - zerocopy_bytes);
     }
 
     return static_cast<ssize_t>(sent_bytes);
@@ -205,6 +407,17 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
     ::shutdown(_fd, SHUT_RDWR);
   }
   void close() override {
+    ldout(cct, 10) << __func__ << " fd=" << _fd
+		   << " zerocopy_bytes=" << stats.zerocopy_bytes
+		   << " copied_bytes=" << stats.copied_bytes << dendl;
+#ifdef HAVE_MSG_ZEROCOPY
+    reap_zerocopy();
+    if (!zerocopy.empty()) {
+      center->dispatch_event_external(
+	new C_zerocopy_linger(cct, center, _fd, std::move(zerocopy)));
+      return;
+    }
+#endif
     compat_closesocket(_fd);
   }
   void set_priority(int sd, int prio, int domain) override {
@@ -263,7 +476,9 @@ int PosixServerSocketImpl::accept(ConnectedSocket *sock, const SocketOptions &op
   out->set_sockaddr((sockaddr*)&ss);
   handler.set_priority(sd, opt.priority, out->get_family());
 
-  std::unique_ptr<PosixConnectedSocketImpl> csi(new PosixConnectedSocketImpl(handler, *out, sd, true));
+  std::unique_ptr<PosixConnectedSocketImpl> csi(
+    new PosixConnectedSocketImpl(handler, *out, sd, true, w->cct,
+				 w->perf_logger, &w->center));
   *sock = ConnectedSocket(std::move(csi));
   return 0;
 }
@@ -332,7 +547,9 @@ int PosixWorker::connect(const entity_addr_t &addr, const SocketOptions &opts, C
 
   net.set_priority(sd, opts.priority, addr.get_family());
   *socket = ConnectedSocket(
-      std::unique_ptr<PosixConnectedSocketImpl>(new PosixConnectedSocketImpl(net, addr, sd, !opts.nonblock)));
+      std::unique_ptr<PosixConnectedSocketImpl>(
+	new PosixConnectedSocketImpl(net, addr, sd, !opts.nonblock, cct,
+				     perf_logger, &center)));
   return 0;
 }
 
@@ -37,6 +37,11 @@
 #include <string>
 
 class Worker;
+struct SocketSendStats {
+  uint64_t zerocopy_bytes = 0; ///< bytes handed to the kernel without copying
+  uint64_t copied_bytes = 0;   ///< bytes copied into the socket buffer
+};
+
 class ConnectedSocketImpl {
  public:
   virtual ~ConnectedSocketImpl() {}
@@ -47,6 +52,9 @@ class ConnectedSocketImpl {
   virtual void close() = 0;
   virtual int fd() const = 0;
   virtual void set_priority(int sd, int prio, int domain) = 0;
+  virtual SocketSendStats get_send_stats() const {
+    return {};
+  }
 };
 
 class ConnectedSocket;
@@ -142,6 +150,10 @@ class ConnectedSocket {
     _csi->set_priority(sd, prio, domain);
   }
 
+  SocketSendStats get_send_stats() const {
+    return _csi->get_send_stats();
+  }
+
   explicit operator bool() const {
     return _csi.get();
   }
@@ -225,6 +237,9 @@ enum {
   l_msgr_recv_encrypted_bytes,
   l_msgr_send_encrypted_bytes,
 
+  l_msgr_send_zerocopy_bytes,
+  l_msgr_send_copied_bytes,
+
   l_msgr_last,
 };
 
@@ -283,6 +298,9 @@ class Worker {
     plb.add_u64_counter(l_msgr_recv_encrypted_bytes, "msgr_recv_encrypted_bytes", "Network received encrypted bytes", NULL, 0, unit_t(UNIT_BYTES));
     plb.add_u64_counter(l_msgr_send_encrypted_bytes, "msgr_send_encrypted_bytes", "Network sent encrypted bytes", NULL, 0, unit_t(UNIT_BYTES));
 
+    plb.add_u64_counter(l_msgr_send_zerocopy_bytes, "msgr_send_zerocopy_bytes", "Network sent bytes using MSG_ZEROCOPY", NULL, 0, unit_t(UNIT_BYTES));
+    plb.add_u64_counter(l_msgr_send_copied_bytes, "msgr_send_copied_bytes", "Network sent bytes copied into the socket buffer", NULL, 0, unit_t(UNIT_BYTES));
+
     perf_logger = plb.create_perf_counters();
     cct->get_perfcounters_collection()->add(perf_logger);
 
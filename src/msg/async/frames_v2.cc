@@ -51,6 +51,32 @@ static void check_segment_crc(const bufferlist& segment_bl,
   }
 }
 
+// Segment crcs are independent, so they are computed side by side.
+static void calc_segment_crcs(const bufferlist segment_bls[],
+                              size_t segment_count, uint32_t crcs[]) {
+  ceph_assert(segment_count <= MAX_NUM_SEGMENTS);
+  const bufferlist* bls[MAX_NUM_SEGMENTS];
+  for (size_t i = 0; i < segment_count; i++) {
+    bls[i] = &segment_bls[i];
+    crcs[i] = -1;
+  }
+  bufferlist::crc32c_multi(bls, crcs, segment_count);
+}
+
+static void check_segment_crcs(const bufferlist segment_bls[],
+                               size_t segment_count,
+                               const ceph_le32 expected_crcs[]) {
+  uint32_t crcs[MAX_NUM_SEGMENTS];
+  calc_segment_crcs(segment_bls, segment_count, crcs);
+  for (size_t i = 0; i < segment_count; i++) {
+    if (crcs[i] != expected_crcs[i]) {
+      throw FrameError(fmt::format(
+          "bad segment crc calculated={} expected={}", crcs[i],
+          (uint32_t)expected_crcs[i]));
+    }
+  }
+}
+
 // Returns true if the frame is ready for dispatching, or false if
 // it was aborted by the sender and must be dropped.
 static bool check_epilogue_late_status(__u8 late_status) {
@@ -103,9 +129,13 @@ bufferlist FrameAssembler::asm_crc_rev0(const preamble_block_t& preamble,
 
   bufferlist frame_bl(sizeof(preamble) + sizeof(epilogue));
   frame_bl.append(reinterpret_cast<const char*>(&preamble), sizeof(preamble));
+  uint32_t crcs[MAX_NUM_SEGMENTS] = {};
+  if (m_with_data_crc) {
+    calc_segment_crcs(segment_bls, m_descs.size(), crcs);
+  }
   for (size_t i = 0; i < m_descs.size(); i++) {
     ceph_assert(segment_bls[i].length() == m_descs[i].logical_len);
-    epilogue.crc_values[i] = m_with_data_crc ? segment_bls[i].crc32c(-1) : 0;
+    epilogue.crc_values[i] = crcs[i];
     if (segment_bls[i].length() > 0) {
       frame_bl.claim_append(segment_bls[i]);
     }
@@ -152,11 +182,14 @@ bufferlist FrameAssembler::asm_crc_rev1(const preamble_block_t& preamble,
   bufferlist frame_bl(sizeof(preamble) + FRAME_CRC_SIZE + sizeof(epilogue));
   frame_bl.append(reinterpret_cast<const char*>(&preamble), sizeof(preamble));
 
+  uint32_t crcs[MAX_NUM_SEGMENTS] = {};
+  if (m_with_data_crc) {
+    calc_segment_crcs(segment_bls, m_descs.size(), crcs);
+  }
   ceph_assert(segment_bls[0].length() == m_descs[0].logical_len);
   if (segment_bls[0].length() > 0) {
-    uint32_t crc = m_with_data_crc ? segment_bls[0].crc32c(-1) : 0;
     frame_bl.claim_append(segment_bls[0]);
-    encode(crc, frame_bl);
+    encode(crcs[0], frame_bl);
   }
   if (m_descs.size() == 1) {
     return frame_bl;  // no epilogue if only one segment
@@ -164,8 +197,7 @@ bufferlist FrameAssembler::asm_crc_rev1(const preamble_block_t& preamble,
 
   for (size_t i = 1; i < m_descs.size(); i++) {
     ceph_assert(segment_bls[i].length() == m_descs[i].logical_len);
-    epilogue.crc_values[i - 1] =
-            m_with_data_crc ? segment_bls[i].crc32c(-1) : 0;
+    epilogue.crc_values[i - 1] = crcs[i];
     if (segment_bls[i].length() > 0) {
       frame_bl.claim_append(segment_bls[i]);
     }
@@ -333,9 +365,9 @@ bool FrameAssembler::disasm_all_crc_rev0(bufferlist segment_bls[],
 
   for (size_t i = 0; i < m_descs.size(); i++) {
     ceph_assert(segment_bls[i].length() == m_descs[i].logical_len);
-    if (m_with_data_crc) {
-      check_segment_crc(segment_bls[i], epilogue->crc_values[i]);
-    }
+  }
+  if (m_with_data_crc) {
+    check_segment_crcs(segment_bls, m_descs.size(), epilogue->crc_values);
   }
   return !(epilogue->late_flags & FRAME_LATE_FLAG_ABORTED);
 }
@@ -384,9 +416,10 @@ bool FrameAssembler::disasm_remaining_crc_rev1(bufferlist segment_bls[],
 
   for (size_t i = 1; i < m_descs.size(); i++) {
     ceph_assert(segment_bls[i].length() == m_descs[i].logical_len);
-    if (m_with_data_crc) {
-      check_segment_crc(segment_bls[i], epilogue->crc_values[i - 1]);
-    }
+  }
+  if (m_with_data_crc && m_descs.size() > 1) {
+    check_segment_crcs(segment_bls + 1, m_descs.size() - 1,
+                       epilogue->crc_values);
   }
   return check_epilogue_late_status(epilogue->late_status);
 }
@@ -491,6 +491,38 @@ public:
      ceph::buffer::list& bl,
      uint32_t op_flags = 0) = 0;
 
+  /**
+   * verify_object_checksums -- check a byte range against the stored
+   * checksums and digest it without returning the data
+   *
+   * The result is the same as read() followed by folding the crc32c
+   * of the data into *digest, so digests from stores that verify in
+   * place and from ones that fall back to this read can be compared.
+   *
+   * @param cid collection for object
+   * @param oid oid of object
+   * @param offset location offset of first byte to be verified
+   * @param len number of bytes to be verified
+   * @param digest in: crc32c seed, out: crc32c of the range
+   * @param op_flags is CEPH_OSD_OP_FLAG_*
+   * @returns number of bytes covered on success, -EIO if a stored
+   * checksum does not match, or another negative error code on failure.
+   */
+  virtual int verify_object_checksums(
+    CollectionHandle &c,
+    const ghobject_t& oid,
+    uint64_t offset,
+    size_t len,
+    uint32_t *digest,
+    uint32_t op_flags = 0) {
+    ceph::buffer::list bl;
+    int r = read(c, oid, offset, len, bl, op_flags);
+    if (r > 0) {
+      *digest = bl.crc32c(*digest);
+    }
+    return r;
+  }
+
   /**
    * fiemap -- get extent std::map of data of an object
    *
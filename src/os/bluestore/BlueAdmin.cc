@@ -49,6 +49,11 @@ BlueStore::SocketHook::SocketHook(BlueStore& store)
       this,
       "print compression stats, per collection");
     ceph_assert(r == 0);
+    r = admin_socket->register_command(
+      "bluestore deferred policy",
+      this,
+      "print the deferred write size and the device model behind it");
+    ceph_assert(r == 0);
   }
 }
 
@@ -177,6 +182,32 @@ int BlueStore::SocketHook::call(
     }
     f->close_section();
     return 0;
+  } else if (command == "bluestore deferred policy") {
+    f->open_object_section("deferred_policy");
+    f->dump_bool("adaptive", store.cct->_conf->bluestore_prefer_deferred_adaptive);
+    f->dump_unsigned("prefer_deferred_size", store.prefer_deferred_size);
+    if (store.bdev) {
+      DeferredWriteModel m = store._get_deferred_write_model();
+      f->open_object_section("model");
+      m.dump(f);
+      f->close_section();
+      if (m.ready()) {
+        f->dump_unsigned("breakeven_size", m.breakeven(
+          store.cct->_conf->bluestore_prefer_deferred_adaptive_max,
+          store.block_size));
+        f->open_array_section("expected_latency_us");
+        for (uint64_t len : {4096ull, 65536ull, 1048576ull}) {
+          f->open_object_section("write");
+          f->dump_unsigned("length", len);
+          f->dump_float("direct", m.direct_us(len));
+          f->dump_float("deferred", m.deferred_us(len));
+          f->close_section();
+        }
+        f->close_section();
+      }
+    }
+    f->close_section();
+    return 0;
   } else {
     ss << "Invalid command" << std::endl;
     r = -ENOSYS;
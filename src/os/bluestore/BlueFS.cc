@@ -220,6 +220,7 @@ BlueFS::BlueFS(CephContext* cct)
 
 BlueFS::~BlueFS()
 {
+  _stop_log_compact_thread();
   delete asok_hook;
   for (auto p : ioc) {
     if (p)
@@ -1172,6 +1173,9 @@ int BlueFS::mount()
            << dendl;
   // update log size
   logger->set(l_bluefs_log_bytes, log.writer->file->fnode.size);
+  if (cct->_conf->bluefs_compact_log_background) {
+    _start_log_compact_thread();
+  }
   return 0;
 
  out:
@@ -1200,6 +1204,8 @@ void BlueFS::umount(bool avoid_compact)
 {
   dout(1) << __func__ << dendl;
 
+  // any compaction from here on runs inline
+  _stop_log_compact_thread();
   sync_metadata(avoid_compact);
   if (cct->_conf->bluefs_check_volume_selector_on_umount) {
     _check_vselector_LNF();
@@ -3031,6 +3037,7 @@ void BlueFS::_rewrite_log_and_layout_sync_LNF_LD(bool permit_dev_fallback,
 
   // Part 0.
   // Lock the log totally till the end of the procedure
+  _pause_log_compact();
   std::lock_guard ll(log.lock);
   auto t0 = mono_clock::now();
 
@@ -3224,6 +3231,7 @@ void BlueFS::_rewrite_log_and_layout_sync_LNF_LD(bool permit_dev_fallback,
     }
   }
   logger->tinc(l_bluefs_compaction_lock_lat, mono_clock::now() - t0);
+  _resume_log_compact();
 }
 
 /*
@@ -4591,6 +4599,9 @@ void BlueFS::_maybe_compact_log_LNF_NF_LD_D()
 {
   if (!cct->_conf->bluefs_replay_recovery_disable_compact &&
       _should_start_compact_log_L_N()) {
+    if (!cct->_conf->bluefs_compact_log_sync && _request_log_compact()) {
+      return;
+    }
     auto t0 = mono_clock::now();
     if (cct->_conf->bluefs_compact_log_sync) {
       _compact_log_sync_LNF_LD();
@@ -4601,6 +4612,93 @@ void BlueFS::_maybe_compact_log_LNF_NF_LD_D()
   }
 }
 
+void BlueFS::_start_log_compact_thread()
+{
+  std::lock_guard l(log_compact_lock);
+  ceph_assert(!log_compact_started);
+  log_compact_stop = false;
+  log_compact_requested = false;
+  log_compact_thread.create("bfs_compact");
+  log_compact_started = true;
+}
+
+void BlueFS::_stop_log_compact_thread()
+{
+  {
+    std::lock_guard l(log_compact_lock);
+    if (!log_compact_started) {
+      return;
+    }
+    log_compact_stop = true;
+    log_compact_cond.notify_all();
+  }
+  // waits for a compaction in progress to finish
+  log_compact_thread.join();
+  std::lock_guard l(log_compact_lock);
+  log_compact_started = false;
+  log_compact_requested = false;
+}
+
+// Hand the compaction over to the compaction thread so that the
+// caller, typically a RocksDB WAL fsync, does not pay for it.
+// Returns false if there is no thread to take it.
+bool BlueFS::_request_log_compact()
+{
+  std::lock_guard l(log_compact_lock);
+  if (!log_compact_started || log_compact_stop) {
+    return false;
+  }
+  if (!log_compact_requested) {
+    log_compact_requested = true;
+    log_compact_cond.notify_one();
+  }
+  return true;
+}
+
+// Keep the compaction thread away while the log is rewritten
+// synchronously; waits for a compaction in progress to finish.
+// Must not be called with log.lock held.
+void BlueFS::_pause_log_compact()
+{
+  std::unique_lock l(log_compact_lock);
+  ++log_compact_paused;
+  log_compact_cond.wait(l, [this] { return !log_compact_running; });
+}
+
+void BlueFS::_resume_log_compact()
+{
+  std::lock_guard l(log_compact_lock);
+  ceph_assert(log_compact_paused > 0);
+  if (--log_compact_paused == 0) {
+    log_compact_cond.notify_all();
+  }
+}
+
+void BlueFS::_log_compact_thread()
+{
+  dout(10) << __func__ << " start" << dendl;
+  std::unique_lock l(log_compact_lock);
+  while (!log_compact_stop) {
+    if (!log_compact_requested || log_compact_paused) {
+      log_compact_cond.wait(l);
+      continue;
+    }
+    log_compact_requested = false;
+    log_compact_running = true;
+    l.unlock();
+    // requests may be stale by now, recheck
+    if (_should_start_compact_log_L_N()) {
+      auto t0 = mono_clock::now();
+      _compact_log_async_LD_LNF_D();
+      logger->tinc(l_bluefs_compaction_lat, mono_clock::now() - t0);
+    }
+    l.lock();
+    log_compact_running = false;
+    log_compact_cond.notify_all();
+  }
+  dout(10) << __func__ << " finish" << dendl;
+}
+
 int BlueFS::open_for_write(
   std::string_view dirname,
   std::string_view filename,
@@ -13,6 +13,7 @@
 #include "blk/BlockDevice.h"
 
 #include "common/RefCountedObj.h"
+#include "common/Thread.h"
 #include "common/ceph_context.h"
 #include "global/global_context.h"
 #include "include/byteorder.h"
@@ -592,6 +593,22 @@ private:
   std::atomic<bool> log_is_compacting{false};                    ///< signals that bluefs log is already ongoing compaction
   std::atomic<bool> log_forbidden_to_expand{false};              ///< used to signal that async compaction is in state
                                                                  ///  that prohibits expansion of bluefs log
+
+  struct LogCompactThread : public Thread {
+    BlueFS *fs;
+    explicit LogCompactThread(BlueFS *f) : fs(f) {}
+    void *entry() override {
+      fs->_log_compact_thread();
+      return nullptr;
+    }
+  } log_compact_thread{this};
+  ceph::mutex log_compact_lock = ceph::make_mutex("BlueFS::log_compact_lock");
+  ceph::condition_variable log_compact_cond;
+  bool log_compact_started = false;                              ///< compaction thread is running
+  bool log_compact_stop = false;
+  bool log_compact_requested = false;                            ///< compaction wanted, thread not yet woken
+  bool log_compact_running = false;                              ///< thread is compacting right now
+  int log_compact_paused = 0;                                    ///< sync log rewrites in progress
   /*
    * There are up to 3 block devices:
    *
@@ -635,6 +652,13 @@ private:
   void _init_alloc();
   void _stop_alloc();
 
+  void _start_log_compact_thread();
+  void _stop_log_compact_thread();
+  void _log_compact_thread();
+  bool _request_log_compact();
+  void _pause_log_compact();
+  void _resume_log_compact();
+
   ///< pad ceph::buffer::list to max(block size, pad_size) w/ zeros
   void _pad_bl(ceph::buffer::list& bl, uint64_t pad_size = 0);
 
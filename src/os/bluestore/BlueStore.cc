@@ -37,6 +37,7 @@
 #include "simple_bitmap.h"
 #include "os/kv.h"
 #include "include/compat.h"
+#include "include/crc32c.h"
 #include "include/intarith.h"
 #include "include/stringify.h"
 #include "include/str_map.h"
@@ -562,6 +563,24 @@ static void get_deferred_key(uint64_t seq, string *out)
   _key_encode_u64(seq, out);
 }
 
+// compression dictionaries live in PREFIX_SUPER
+static const string COMPRESSION_DICT_KEY_PREFIX = "compress_dict.";
+
+static void get_compression_dict_key(uint32_t id, string *key)
+{
+  *key = COMPRESSION_DICT_KEY_PREFIX;
+  _key_encode_u32(id, key);
+}
+
+static int get_key_compression_dict(const string& key, uint32_t *id)
+{
+  if (key.length() != COMPRESSION_DICT_KEY_PREFIX.length() + sizeof(uint32_t)) {
+    return -1;
+  }
+  _key_decode_u32(key.c_str() + COMPRESSION_DICT_KEY_PREFIX.length(), id);
+  return 0;
+}
+
 static void get_pool_stat_key(int64_t pool_id, string *key)
 {
   key->clear();
@@ -1210,6 +1229,224 @@ struct LruOnodeCacheShard : public BlueStore::OnodeCacheShard {
 #endif
 };
 
+// ClockOnodeCacheShard
+//
+// A scan resistant CLOCK variant.  New onodes enter a small FIFO "cold"
+// list; those referenced again before falling off its tail are promoted to
+// the "hot" list, which is swept by a CLOCK hand.  Unlike the LRU shard,
+// onodes stay linked while pinned, so unpinning a cached onode (the common
+// case on every op) only bumps its atomic reference count and does not
+// take the shard lock or reorder any list.
+struct ClockOnodeCacheShard : public BlueStore::OnodeCacheShard {
+  typedef boost::intrusive::list<
+    BlueStore::Onode,
+    boost::intrusive::member_hook<
+      BlueStore::Onode,
+      boost::intrusive::list_member_hook<>,
+      &BlueStore::Onode::lru_item> > list_t;
+
+  // the unpin that follows admission counts as one reference, so a cold
+  // onode needs one more to be promoted
+  static constexpr uint8_t COLD_PROMOTE_REF = 2;
+  static constexpr uint8_t MAX_REF = 2;
+
+  list_t cold;
+  list_t hot;
+  // onodes with clock_pinned set.  An onode that changes shards while it
+  // is being pinned or unpinned may be counted in one shard and uncounted
+  // in another, so a single shard can go negative, but each count has
+  // exactly one uncount and the sum over all shards is exact.
+  std::atomic<int64_t> num_pinned = {0};
+
+  explicit ClockOnodeCacheShard(CephContext *cct)
+    : BlueStore::OnodeCacheShard(cct) {}
+
+  static void _touch(BlueStore::Onode* o) {
+    uint8_t r = o->clock_ref.load(std::memory_order_relaxed);
+    if (r < MAX_REF) {
+      // racing touches may be lost; the reference count is a hint
+      o->clock_ref.store(r + 1, std::memory_order_relaxed);
+    }
+  }
+
+  void _count_pin(BlueStore::Onode* o) {
+    if (!o->clock_pinned.exchange(true)) {
+      num_pinned.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  void _uncount_pin(BlueStore::Onode* o) {
+    if (o->clock_pinned.exchange(false)) {
+      num_pinned.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  void _rebin(BlueStore::Onode* o) {
+    if (o->cache_age_bin != age_bins.front()) {
+      *(o->cache_age_bin) -= 1;
+      o->cache_age_bin = age_bins.front();
+      *(o->cache_age_bin) += 1;
+    }
+  }
+
+  void _add(BlueStore::Onode* o, int level) override
+  {
+    o->set_cached();
+    o->clock_ref.store(0, std::memory_order_relaxed);
+    if (level > 0) {
+      o->clock_hot = false;
+      cold.push_front(*o);
+    } else {
+      // moved between shards; it has already proven itself
+      o->clock_hot = true;
+      hot.push_front(*o);
+    }
+    o->clock_linked.store(true, std::memory_order_release);
+    if (o->pin_nref > 1) {
+      _count_pin(o);
+    }
+    o->cache_age_bin = age_bins.front();
+    *(o->cache_age_bin) += 1;
+    ++num;
+    dout(20) << __func__ << " " << this << " " << o->oid << " added, num="
+             << num << dendl;
+  }
+  void _unlink(BlueStore::Onode* o) {
+    o->clock_linked.store(false, std::memory_order_release);
+    _uncount_pin(o);
+    *(o->cache_age_bin) -= 1;
+    list_t& l = o->clock_hot ? hot : cold;
+    l.erase(l.iterator_to(*o));
+  }
+  void _rm(BlueStore::Onode* o) override
+  {
+    o->clear_cached();
+    if (o->lru_item.is_linked()) {
+      _unlink(o);
+    }
+    ceph_assert(num);
+    --num;
+    dout(20) << __func__ << " " << this << " " << " " << o->oid << " removed, num=" << num << dendl;
+  }
+
+  void on_pin(BlueStore::Onode* o) override
+  {
+    if (o->clock_linked.load(std::memory_order_acquire)) {
+      _count_pin(o);
+    }
+  }
+
+  void maybe_unpin(BlueStore::Onode* o) override
+  {
+    _uncount_pin(o);
+    if (o->clock_linked.load(std::memory_order_acquire) && o->exists) {
+      _touch(o);
+      return;
+    }
+    OnodeCacheShard* ocs = this;
+    ocs->lock.lock();
+    // It is possible that during waiting split_cache moved us to different OnodeCacheShard.
+    while (ocs != o->c->get_onode_cache()) {
+      ocs->lock.unlock();
+      ocs = o->c->get_onode_cache();
+      ocs->lock.lock();
+    }
+    if (o->is_cached() && o->pin_nref == 1) {
+      if (o->exists) {
+        _touch(o);
+      } else {
+        static_cast<ClockOnodeCacheShard*>(ocs)->_unlink(o);
+        ceph_assert(ocs->num);
+        --ocs->num;
+        o->clear_cached();
+        dout(20) << __func__ << " " << ocs << " " << o->oid << " removed"
+                 << dendl;
+        // remove will also decrement nref
+        o->c->onode_space._remove(o->oid);
+      }
+    }
+    ocs->lock.unlock();
+  }
+
+  void _evict(BlueStore::Onode* o) {
+    dout(20) << __func__ << "  rm " << o->oid << " "
+             << o->nref << " " << o->cached << dendl;
+    _unlink(o);
+    ceph_assert(num);
+    --num;
+    o->clear_cached();
+    o->c->onode_space._remove(o->oid);
+  }
+
+  void _trim_to(uint64_t new_size) override
+  {
+    if (new_size >= num) {
+      return; // don't even try
+    }
+    uint64_t n = num - new_size;
+    uint64_t cold_target =
+      new_size * cct->_conf->bluestore_clock_onode_cache_cold_ratio;
+    // each step either evicts, promotes or rotates one onode; bound the
+    // sweep so a cache full of pinned onodes does not spin forever
+    uint64_t steps = 2 * (cold.size() + hot.size());
+    while (n > 0 && steps-- > 0) {
+      if (!cold.empty() && (cold.size() > cold_target || hot.empty())) {
+        BlueStore::Onode *o = &cold.back();
+        // an onode still (or again) in use when it reaches the tail has
+        // been referenced since admission as well
+        if (o->pin_nref > 1 ||
+            o->clock_ref.load(std::memory_order_relaxed) >= COLD_PROMOTE_REF) {
+          cold.erase(cold.iterator_to(*o));
+          o->clock_hot = true;
+          o->clock_ref.store(0, std::memory_order_relaxed);
+          hot.push_front(*o);
+          _rebin(o);
+          dout(20) << __func__ << " " << this << " " << o->oid << " promoted"
+                   << dendl;
+        } else {
+          _evict(o);
+          --n;
+        }
+      } else if (!hot.empty()) {
+        BlueStore::Onode *o = &hot.back();
+        if (o->pin_nref > 1 || o->clock_ref.load(std::memory_order_relaxed)) {
+          // second chance
+          hot.erase(hot.iterator_to(*o));
+          o->clock_ref.store(0, std::memory_order_relaxed);
+          hot.push_front(*o);
+          _rebin(o);
+        } else {
+          _evict(o);
+          --n;
+        }
+      } else {
+        break;
+      }
+    }
+  }
+  void _move_pinned(OnodeCacheShard *to, BlueStore::Onode *o) override
+  {
+    if (to == this) {
+      return;
+    }
+    _rm(o);
+    ceph_assert(o->nref > 1);
+    to->_add(o, 0);
+  }
+  void add_stats(uint64_t *onodes, uint64_t *pinned_onodes) override
+  {
+    std::lock_guard l(lock);
+    *onodes += num;
+    // may wrap for this shard; see num_pinned
+    *pinned_onodes += static_cast<uint64_t>(
+      num_pinned.load(std::memory_order_relaxed));
+  }
+#ifdef DEBUG_CACHE
+  void _audit(const char *when) override
+  {
+  }
+#endif
+};
+
 // OnodeCacheShard
 BlueStore::OnodeCacheShard *BlueStore::OnodeCacheShard::create(
     CephContext* cct,
@@ -1217,8 +1454,10 @@ BlueStore::OnodeCacheShard *BlueStore::OnodeCacheShard::create(
     PerfCounters *logger)
 {
   BlueStore::OnodeCacheShard *c = nullptr;
-  // Currently we only implement an LRU cache for onodes
-  c = new LruOnodeCacheShard(cct);
+  if (type == "clock")
+    c = new ClockOnodeCacheShard(cct);
+  else
+    c = new LruOnodeCacheShard(cct);
   c->logger = logger;
   return c;
 }
@@ -1678,7 +1917,8 @@ BlueStore::BufferCacheShard *BlueStore::BufferCacheShard::create(
   BufferCacheShard *c = nullptr;
   if (type == "lru")
     c = new LruBufferCacheShard(store);
-  else if (type == "2q")
+  else if (type == "2q" || type == "clock")
+    // "clock" only changes the onode cache; 2Q is already scan resistant
     c = new TwoQBufferCacheShard(store);
   else
     ceph_abort_msg("unrecognized cache type");
@@ -4905,7 +5145,9 @@ void BlueStore::Onode::calc_omap_tail(
 void BlueStore::Onode::get()
 {
   ++nref;
-  ++pin_nref;
+  if (++pin_nref == 2 && c) {
+    c->get_onode_cache()->on_pin(this);
+  }
 }
 void BlueStore::Onode::put()
 {
@@ -5583,6 +5825,9 @@ void *BlueStore::MempoolThread::entry()
       next_deferred_force_submit += max_defer_interval/3;
     }
 
+    store->_queue_compression_dict_training();
+    store->_update_deferred_policy();
+
     // Now Resize the shards 
     _resize_shards(interval_stats_trim);
     interval_stats_trim = false;
@@ -5753,6 +5998,7 @@ BlueStore::BlueStore(CephContext *cct,
     kv_finalize_thread(this),
     min_alloc_size(_min_alloc_size),
     min_alloc_size_order(std::countr_zero(_min_alloc_size)),
+    compression_dict_finisher(cct, "compress_dict_finisher", "bstore_dict"),
     mempool_thread(this)
 {
   _init_logger();
@@ -5800,6 +6046,7 @@ std::vector<std::string> BlueStore::get_tracked_keys() const noexcept
     "bluestore_prefer_deferred_size"s,
     "bluestore_prefer_deferred_size_hdd"s,
     "bluestore_prefer_deferred_size_ssd"s,
+    "bluestore_prefer_deferred_adaptive"s,
     "bluestore_deferred_batch_ops"s,
     "bluestore_deferred_batch_ops_hdd"s,
     "bluestore_deferred_batch_ops_ssd"s,
@@ -5870,6 +6117,7 @@ void BlueStore::handle_conf_change(const ConfigProxy& conf,
   if (changed.count("bluestore_prefer_deferred_size") ||
       changed.count("bluestore_prefer_deferred_size_hdd") ||
       changed.count("bluestore_prefer_deferred_size_ssd") ||
+      changed.count("bluestore_prefer_deferred_adaptive") ||
       changed.count("bluestore_max_alloc_size") ||
       changed.count("bluestore_deferred_batch_ops") ||
       changed.count("bluestore_deferred_batch_ops_hdd") ||
@@ -6357,6 +6605,8 @@ void BlueStore::_init_logger()
   b.add_time_avg(l_bluestore_kv_final_lat, "kv_final_lat",
 		 "Average kv_finalize thread latency",
 		 "kfll", PerfCountersBuilder::PRIO_INTERESTING);
+  b.add_u64_avg(l_bluestore_kv_batched_txcs, "kv_batched_txcs",
+		"Average number of transactions merged into one kv submit");
   //****************************************
 
   // write op stats
@@ -6420,6 +6670,12 @@ void BlueStore::_init_logger()
 		    NULL,
 		    PerfCountersBuilder::PRIO_DEBUGONLY,
 		    unit_t(UNIT_BYTES));
+  b.add_u64(l_bluestore_deferred_adaptive_size,
+	    "deferred_adaptive_size",
+	    "Deferred write size chosen by the adaptive policy",
+	    NULL,
+	    PerfCountersBuilder::PRIO_DEBUGONLY,
+	    unit_t(UNIT_BYTES));
 
   b.add_u64_counter(l_bluestore_write_big_skipped_blobs,
       "write_big_skipped_blobs",
@@ -7133,6 +7389,47 @@ void BlueStore::_set_alloc_sizes(void)
 	   << dendl;
 }
 
+DeferredWriteModel BlueStore::_get_deferred_write_model() const
+{
+  DeferredWriteModel m;
+  m.main = bdev->get_write_stats();
+  m.main_rotational = bdev->is_rotational();
+  if (bluefs) {
+    // deferred payloads land in the RocksDB WAL
+    BlockDevice *kv_bdev = bluefs->get_block_device(BlueFS::BDEV_WAL);
+    if (!kv_bdev) {
+      kv_bdev = bluefs->get_block_device(BlueFS::BDEV_DB);
+    }
+    if (kv_bdev) {
+      m.kv = kv_bdev->get_write_stats();
+    }
+  }
+  return m;
+}
+
+void BlueStore::_update_deferred_policy()
+{
+  if (!cct->_conf->bluestore_prefer_deferred_adaptive || !bdev) {
+    return;
+  }
+  DeferredWriteModel m = _get_deferred_write_model();
+  if (!m.ready()) {
+    // keep the static size until both devices have some history
+    return;
+  }
+  uint64_t s = m.breakeven(cct->_conf->bluestore_prefer_deferred_adaptive_max,
+                           block_size);
+  if (s != prefer_deferred_size) {
+    dout(20) << __func__ << " prefer_deferred_size 0x" << std::hex
+             << prefer_deferred_size << " -> 0x" << s << std::dec
+             << " direct_lat_us " << m.direct_fixed_us()
+             << " main_bw " << m.main.bw << " kv_bw " << m.kv.bw
+             << " in_flight " << m.main.in_flight << dendl;
+    prefer_deferred_size = s;
+  }
+  logger->set(l_bluestore_deferred_adaptive_size, s);
+}
+
 int BlueStore::_open_bdev(bool create)
 {
   ceph_assert(bdev == NULL);
@@ -9357,6 +9654,8 @@ int BlueStore::umount_readonly()
     mempool_thread.shutdown();
     dout(20) << __func__ << " stopping kv thread" << dendl;
     _kv_stop();
+    // the bdev is closed below, even on fast shutdown
+    _drop_verify_readaheads();
     // skip cache cleanup step on fast shutdown
     if (likely(!m_fast_shutdown)) {
       _shutdown_cache();
@@ -9500,6 +9799,8 @@ int BlueStore::umount()
     mempool_thread.shutdown();
     dout(20) << __func__ << " stopping kv thread" << dendl;
     _kv_stop();
+    // the bdev is closed below, even on fast shutdown
+    _drop_verify_readaheads();
     // skip cache cleanup step on fast shutdown
     if (likely(!m_fast_shutdown)) {
       _shutdown_cache();
@@ -12620,6 +12921,58 @@ int BlueStore::read(
   return r;
 }
 
+int BlueStore::verify_object_checksums(
+  CollectionHandle &c_,
+  const ghobject_t& oid,
+  uint64_t offset,
+  size_t length,
+  uint32_t *digest,
+  uint32_t op_flags)
+{
+  Collection *c = static_cast<Collection *>(c_.get());
+  dout(15) << __func__ << " " << c->get_cid() << " " << oid
+	   << " 0x" << std::hex << offset << "~" << length << std::dec
+	   << dendl;
+  if (!c->exists)
+    return -ENOENT;
+
+  int r;
+  {
+    std::shared_lock l(c->lock);
+    OnodeRef o = c->get_onode(oid, false);
+    if (!o || !o->exists) {
+      r = -ENOENT;
+      goto out;
+    }
+
+    if (offset == length && offset == 0)
+      length = o->onode.size;
+
+    r = _do_verify_checksums(c, o, offset, length, digest, op_flags);
+    if (r == -EIO) {
+      logger->inc(l_bluestore_read_eio);
+    }
+  }
+
+ out:
+  // the same injection points as read(), which scrub tests rely on
+  if (r >= 0 && _debug_data_eio(oid)) {
+    r = -EIO;
+    derr << __func__ << " " << c->cid << " " << oid << " INJECT EIO" << dendl;
+  } else if (oid.hobj.pool > 0 &&
+	     cct->_conf->bluestore_debug_random_read_err &&
+	     (rand() % (int)(cct->_conf->bluestore_debug_random_read_err *
+			     100.0)) == 0) {
+    dout(0) << __func__ << ": inject random EIO" << dendl;
+    r = -EIO;
+  }
+  dout(10) << __func__ << " " << c->get_cid() << " " << oid
+	   << " 0x" << std::hex << offset << "~" << length
+	   << " digest 0x" << *digest << std::dec
+	   << " = " << r << dendl;
+  return r;
+}
+
 void BlueStore::_read_cache(
   OnodeRef& o,
   uint64_t offset,
@@ -13004,6 +13357,296 @@ int BlueStore::_do_read(
   return r;
 }
 
+int BlueStore::_do_verify_checksums(
+  Collection *c,
+  OnodeRef& o,
+  uint64_t offset,
+  size_t length,
+  uint32_t *digest,
+  uint32_t op_flags,
+  uint64_t retry_count)
+{
+  if (offset >= o->onode.size) {
+    return 0;
+  }
+  if (offset + length > o->onode.size) {
+    length = o->onode.size - offset;
+  }
+  o->extent_map.fault_range(db, offset, length);
+
+  int read_cache_policy = 0;
+  if (op_flags & CEPH_OSD_OP_FLAG_BYPASS_CLEAN_CACHE) {
+    read_cache_policy = BufferSpace::BYPASS_CLEAN_CACHE;
+  }
+  ready_regions_t ready_regions;
+  blobs2read_t blobs2read;
+  _read_cache(o, offset, length, read_cache_policy, ready_regions, blobs2read);
+
+  vector<bufferlist> compressed_blob_bls;
+  IOContext ioc(cct, NULL, !cct->_conf->bluestore_fail_eio);
+  int r;
+  // a retry after a checksum error always rereads
+  if (retry_count == 0 &&
+      _take_verify_readahead(c, o, offset, length, blobs2read,
+			     &blobs2read, &compressed_blob_bls)) {
+    dout(20) << __func__ << " 0x" << std::hex << offset << "~" << length
+	     << std::dec << " was read ahead" << dendl;
+  } else {
+    r = _prepare_read_ioc(blobs2read, &compressed_blob_bls, &ioc);
+    if (r < 0)
+      return r;
+    if (ioc.has_pending_aios()) {
+      bdev->aio_submit(&ioc);
+      ioc.aio_wait();
+      r = ioc.get_return_value();
+      if (r < 0) {
+	ceph_assert(r == -EIO);
+	return -EIO;
+      }
+    }
+  }
+
+  // crc32c with seed 0 and length of each piece of the range, by
+  // logical offset; holes are left out and digested as zeros
+  std::map<uint64_t, std::pair<uint32_t, uint64_t>> pieces;
+  for (auto& [off, bl] : ready_regions) {
+    pieces[off] = {bl.crc32c(0), bl.length()};
+  }
+
+  bool csum_error = false;
+  auto p = compressed_blob_bls.begin();
+  for (auto& [bptr, r2r] : blobs2read) {
+    const bluestore_blob_t& blob = bptr->get_blob();
+    if (blob.is_compressed()) {
+      ceph_assert(p != compressed_blob_bls.end());
+      bufferlist& compressed_bl = *p++;
+      uint64_t l_off = r2r.front().regs.front().logical_offset;
+      if (_verify_csum(o, &blob, 0, compressed_bl, l_off) < 0) {
+        csum_error = true;
+        break;
+      }
+      bufferlist raw_bl;
+      r = _decompress(compressed_bl, &raw_bl);
+      if (r < 0)
+        return r;
+      for (auto& req : r2r) {
+        for (auto& reg : req.regs) {
+          bufferlist t;
+          t.substr_of(raw_bl, reg.blob_xoffset, reg.length);
+          pieces[reg.logical_offset] = {t.crc32c(0), reg.length};
+        }
+      }
+      continue;
+    }
+    for (auto& req : r2r) {
+      uint64_t l_off = req.regs.front().logical_offset;
+      if (_verify_csum(o, &blob, req.r_off, req.bl, l_off) < 0) {
+        csum_error = true;
+        break;
+      }
+      for (auto& reg : req.regs) {
+        pieces[reg.logical_offset] = {
+          _region_crc32c(blob, req.bl, reg), reg.length};
+      }
+    }
+    if (csum_error)
+      break;
+  }
+  if (csum_error) {
+    // retry spurious read errors as _do_read() does
+    if (retry_count >= cct->_conf->bluestore_retry_disk_reads) {
+      return -EIO;
+    }
+    return _do_verify_checksums(c, o, offset, length, digest, op_flags,
+                                retry_count + 1);
+  }
+
+  uint32_t crc = *digest;
+  uint64_t pos = offset;
+  for (auto& [off, piece] : pieces) {
+    ceph_assert(off >= pos);
+    if (off > pos) {
+      crc = ceph_crc32c(crc, nullptr, off - pos);
+    }
+    crc = ceph_crc32c_combine(crc, piece.first, piece.second);
+    pos = off + piece.second;
+  }
+  ceph_assert(pos <= offset + length);
+  if (pos < offset + length) {
+    crc = ceph_crc32c(crc, nullptr, offset + length - pos);
+  }
+  *digest = crc;
+  if (retry_count) {
+    logger->inc(l_bluestore_reads_with_retries);
+    dout(5) << __func__ << " read at 0x" << std::hex << offset << "~" << length
+            << " failed " << std::dec << retry_count << " times before succeeding" << dendl;
+    stringstream s;
+    s << " reads with retries: " << logger->get(l_bluestore_reads_with_retries);
+    _set_spurious_read_errors_alert(s.str());
+  }
+  if ((op_flags & CEPH_OSD_OP_FLAG_FADVISE_SEQUENTIAL) &&
+      offset + length < o->onode.size &&
+      cct->_conf.get_val<bool>("bluestore_verify_readahead")) {
+    // deep scrub asks for the next stride once it has been requeued
+    _start_verify_readahead(c, o, offset + length, length, read_cache_policy);
+  }
+  return length;
+}
+
+void BlueStore::_start_verify_readahead(
+  Collection *c,
+  OnodeRef& o,
+  uint64_t offset,
+  size_t length,
+  int read_cache_policy)
+{
+  if (offset + length > o->onode.size) {
+    length = o->onode.size - offset;
+  }
+  o->extent_map.fault_range(db, offset, length);
+  auto ra = std::make_unique<VerifyReadahead>(cct, c, o, offset, length);
+  ready_regions_t ready_regions;
+  _read_cache(o, offset, length, read_cache_policy, ready_regions,
+	      ra->blobs2read);
+  int r = _prepare_read_ioc(ra->blobs2read, &ra->compressed_blob_bls,
+			    &ra->ioc);
+  if (r < 0 || !ra->ioc.has_pending_aios()) {
+    return;
+  }
+  dout(20) << __func__ << " " << o->oid << " 0x" << std::hex << offset
+	   << "~" << length << std::dec << dendl;
+  bdev->aio_submit(&ra->ioc);
+
+  // destroyed, i.e. waited for, after the lock is dropped
+  std::list<std::unique_ptr<VerifyReadahead>> evicted;
+  std::lock_guard l(verify_readahead_lock);
+  for (auto p = verify_readaheads.begin(); p != verify_readaheads.end(); ) {
+    if ((*p)->o == o) {
+      evicted.splice(evicted.end(), verify_readaheads, p++);
+    } else {
+      ++p;
+    }
+  }
+  verify_readaheads.push_back(std::move(ra));
+  if (verify_readaheads.size() > VERIFY_READAHEAD_MAX) {
+    evicted.splice(evicted.end(), verify_readaheads,
+		   verify_readaheads.begin());
+  }
+}
+
+bool BlueStore::_take_verify_readahead(
+  Collection *c,
+  OnodeRef& o,
+  uint64_t offset,
+  size_t length,
+  const blobs2read_t& blobs2read,
+  blobs2read_t* ra_blobs2read,
+  vector<bufferlist>* ra_compressed_blob_bls)
+{
+  std::unique_ptr<VerifyReadahead> ra;
+  {
+    std::lock_guard l(verify_readahead_lock);
+    auto p = std::find_if(
+      verify_readaheads.begin(), verify_readaheads.end(),
+      [&](auto& i) { return i->c == c && i->o == o; });
+    if (p == verify_readaheads.end()) {
+      return false;
+    }
+    ra = std::move(*p);
+    verify_readaheads.erase(p);
+  }
+  ra->ioc.aio_wait();
+  if (ra->offset != offset || ra->length != length ||
+      ra->ioc.get_return_value() < 0) {
+    return false;
+  }
+  // the data is only good if the range still maps to the very same blob
+  // reads; the PG blocks writes to an object while it is being scrubbed,
+  // and a stale read would still fail its checksum and be retried
+  auto same_regions = [](const regions2read_t& a, const regions2read_t& b) {
+    return std::equal(
+      a.begin(), a.end(), b.begin(), b.end(),
+      [](const read_req_t& x, const read_req_t& y) {
+	return x.r_off == y.r_off && x.r_len == y.r_len &&
+	  std::equal(
+	    x.regs.begin(), x.regs.end(), y.regs.begin(), y.regs.end(),
+	    [](const region_t& m, const region_t& n) {
+	      return m.logical_offset == n.logical_offset &&
+		m.blob_xoffset == n.blob_xoffset &&
+		m.length == n.length && m.front == n.front;
+	    });
+      });
+  };
+  if (!std::equal(
+	blobs2read.begin(), blobs2read.end(),
+	ra->blobs2read.begin(), ra->blobs2read.end(),
+	[&](auto& x, auto& y) {
+	  return x.first == y.first && same_regions(x.second, y.second);
+	})) {
+    dout(20) << __func__ << " " << o->oid << " 0x" << std::hex << offset
+	     << "~" << length << std::dec << " mapping changed" << dendl;
+    return false;
+  }
+  ra_blobs2read->swap(ra->blobs2read);
+  ra_compressed_blob_bls->swap(ra->compressed_blob_bls);
+  return true;
+}
+
+void BlueStore::_drop_verify_readaheads(Collection *c)
+{
+  std::list<std::unique_ptr<VerifyReadahead>> dropped;
+  std::lock_guard l(verify_readahead_lock);
+  for (auto p = verify_readaheads.begin(); p != verify_readaheads.end(); ) {
+    if (!c || (*p)->c == c) {
+      dropped.splice(dropped.end(), verify_readaheads, p++);
+    } else {
+      ++p;
+    }
+  }
+  // destroying them after the lock is dropped waits for their aios
+}
+
+uint32_t BlueStore::_region_crc32c(
+
+  const bluestore_blob_t& blob,
+  const bufferlist& bl,
+  const region_t& reg)
+{
+  auto hash = [&](uint64_t b_off, uint64_t len) {
+    bufferlist t;
+    t.substr_of(bl, reg.front + b_off - reg.blob_xoffset, len);
+    return t.crc32c(0);
+  };
+  if (blob.csum_type != Checksummer::CSUM_CRC32C) {
+    return hash(reg.blob_xoffset, reg.length);
+  }
+  // the chunks just verified already carry the crc32c of their data,
+  // so only partial chunks at either end of the region are hashed
+  uint64_t chunk = blob.get_csum_chunk_size();
+  uint64_t b_off = reg.blob_xoffset;
+  uint64_t b_end = b_off + reg.length;
+  uint64_t full_start = p2roundup(b_off, chunk);
+  uint64_t full_end = p2align(b_end, chunk);
+  if (full_start >= full_end) {
+    return hash(b_off, reg.length);
+  }
+  uint32_t crc = 0;
+  if (b_off < full_start) {
+    crc = hash(b_off, full_start - b_off);
+  }
+  // stored csums are seeded with -1, rebase them to seed 0
+  uint32_t zero_chunk_crc = ceph_crc32c(-1, nullptr, chunk);
+  for (uint64_t b = full_start; b < full_end; b += chunk) {
+    uint32_t chunk_crc = blob.get_csum_item(b / chunk) ^ zero_chunk_crc;
+    crc = ceph_crc32c_combine(crc, chunk_crc, chunk);
+  }
+  if (full_end < b_end) {
+    crc = ceph_crc32c_combine(crc, hash(full_end, b_end - full_end),
+                              b_end - full_end);
+  }
+  return crc;
+}
+
 void inline BlueStore::_do_read_and_pad(
   Collection* c,
   OnodeRef& o,
@@ -13099,7 +13742,19 @@ int BlueStore::_decompress(bufferlist& source, bufferlist* result)
     }
   } else {
     ceph_assert((int)cp->get_type() == alg);
-    r = cp->decompress(i, chdr.length, *result, chdr.compressor_message);
+    if (chdr.dict_id) {
+      Compressor::DictionaryRef dict = _get_compression_dict(chdr.dict_id);
+      if (dict) {
+	r = cp->decompress_with_dict(i, chdr.length, *result, dict,
+				     chdr.compressor_message);
+      } else {
+	derr << __func__ << " missing compression dict " << chdr.dict_id
+	     << dendl;
+	r = -ENOENT;
+      }
+    } else {
+      r = cp->decompress(i, chdr.length, *result, chdr.compressor_message);
+    }
     if (r < 0) {
       derr << __func__ << " decompression failed with exit code " << r << dendl;
       r = -EIO;
@@ -14149,10 +14804,239 @@ int BlueStore::_open_super_meta()
   _set_blob_size();
   _update_allocator_lookup_policy();
 
+  int r = _open_compression_dicts();
+  if (r < 0) {
+    return r;
+  }
+
   _validate_bdev();
   return 0;
 }
 
+int BlueStore::_open_compression_dicts()
+{
+  std::lock_guard l(compression_dict_lock);
+  compression_dict_samplers.clear();
+  compression_dict_max = 0;
+  {
+    bufferlist bl;
+    if (db->get(PREFIX_SUPER, "compress_dict_max", &bl) >= 0) {
+      auto p = bl.cbegin();
+      try {
+	decode(compression_dict_max, p);
+      } catch (ceph::buffer::error& e) {
+	derr << __func__ << " unable to read compress_dict_max" << dendl;
+	return -EIO;
+      }
+    }
+  }
+  auto m = std::make_shared<CompressionDictMap>();
+  KeyValueDB::Iterator it = db->get_iterator(PREFIX_SUPER);
+  for (it->lower_bound(COMPRESSION_DICT_KEY_PREFIX); it->valid(); it->next()) {
+    uint32_t id;
+    if (get_key_compression_dict(it->key(), &id) < 0) {
+      break;
+    }
+    bluestore_compression_dict_t d;
+    bufferlist bl = it->value();
+    auto p = bl.cbegin();
+    try {
+      decode(d, p);
+    } catch (ceph::buffer::error& e) {
+      derr << __func__ << " unable to decode compression dict " << id << dendl;
+      return -EIO;
+    }
+    CompressorRef cp =
+      d.type < compressors.size() ? compressors[d.type] : CompressorRef();
+    Compressor::DictionaryRef dict;
+    if (cp) {
+      dict = cp->load_dictionary(d.dict);
+    }
+    if (!dict) {
+      // blobs referencing it will fail to decompress
+      derr << __func__ << " unable to load compression dict " << id
+	   << " for pool " << d.pool << " alg "
+	   << Compressor::get_comp_alg_name(d.type) << dendl;
+      continue;
+    }
+    // keys are ordered by id, so each by_key list is oldest first
+    m->by_key[{d.pool, d.type}].push_back(id);
+    m->dicts[id] = CompressionDict{d.pool, d.type, d.ctime, dict};
+  }
+  dout(1) << __func__ << " loaded " << m->dicts.size()
+	  << " compression dicts, max " << compression_dict_max << dendl;
+  compression_dict_map.store(std::move(m));
+  return 0;
+}
+
+Compressor::DictionaryRef BlueStore::_get_compression_dict(uint32_t id)
+{
+  auto m = compression_dict_map.load();
+  auto p = m->dicts.find(id);
+  if (p == m->dicts.end()) {
+    return Compressor::DictionaryRef();
+  }
+  return p->second.dict;
+}
+
+void BlueStore::_queue_compression_dict_training()
+{
+  if (!cct->_conf->bluestore_compression_dict_max_blob_size) {
+    return;
+  }
+  utime_t next = ceph_clock_now();
+  next += cct->_conf->bluestore_compression_dict_max_age;
+  std::map<compression_dict_key_t,std::vector<bufferlist>> ready;
+  std::lock_guard l(compression_dict_lock);
+  for (auto& [key, s] : compression_dict_samplers) {
+    if (s.bytes >= cct->_conf->bluestore_compression_dict_sample_size) {
+      ready[key].swap(s.samples);
+      s.samples.clear();
+      s.bytes = 0;
+    }
+  }
+  if (ready.empty()) {
+    return;
+  }
+  // success or not, leave these pools alone for a while
+  auto m = std::make_shared<CompressionDictMap>(*compression_dict_map.load());
+  for (auto& [key, samples] : ready) {
+    m->next_sample[key] = next;
+  }
+  compression_dict_map.store(std::move(m));
+  compression_dict_finisher.queue(new LambdaContext(
+    [this, ready = std::move(ready)](int) mutable {
+      _train_compression_dicts(ready);
+    }));
+}
+
+void BlueStore::_train_compression_dicts(
+  std::map<compression_dict_key_t,std::vector<bufferlist>>& ready)
+{
+  for (auto& [key, samples] : ready) {
+    auto& [pool, alg] = key;
+    // use a private instance: compressors[] belongs to the write path, and
+    // dictionaries do not depend on the instance that loaded them
+    CompressorRef cp = Compressor::create(cct, alg);
+    bufferlist raw;
+    int r = cp ? cp->train_dictionary(
+      samples, cct->_conf->bluestore_compression_dict_size, &raw) : -ENOENT;
+    Compressor::DictionaryRef dict;
+    if (r == 0) {
+      dict = cp->load_dictionary(raw);
+      if (!dict) {
+	r = -EINVAL;
+      }
+    }
+    if (r < 0) {
+      dout(5) << __func__ << " unable to train "
+	      << Compressor::get_comp_alg_name(alg) << " dict for pool "
+	      << pool << ": " << cpp_strerror(r) << dendl;
+      continue;
+    }
+
+    if (std::shared_lock cl(coll_lock); !_have_pool_collection(pool)) {
+      dout(10) << __func__ << " pool " << pool << " is gone" << dendl;
+      continue;
+    }
+    // the commit below is synchronous; do not hold up collection
+    // create/remove behind it
+    utime_t now = ceph_clock_now();
+    bluestore_compression_dict_t d;
+    d.pool = pool;
+    d.type = alg;
+    d.ctime = now;
+    d.dict = raw;
+    uint32_t id;
+    {
+      std::lock_guard l(compression_dict_lock);
+      id = ++compression_dict_max;
+    }
+    // make it durable before any blob can refer to it
+    KeyValueDB::Transaction t = db->get_transaction();
+    string dkey;
+    get_compression_dict_key(id, &dkey);
+    bufferlist bl, mbl;
+    encode(d, bl);
+    encode(id, mbl);
+    t->set(PREFIX_SUPER, dkey, bl);
+    t->set(PREFIX_SUPER, "compress_dict_max", mbl);
+    r = db->submit_transaction_sync(t);
+    if (r < 0) {
+      derr << __func__ << " failed to store compression dict " << id
+	   << ": " << cpp_strerror(r) << dendl;
+      continue;
+    }
+    {
+      // publish under coll_lock so that _drop_compression_dicts either
+      // sees the new dictionary or has already run and we clean up here
+      std::shared_lock cl(coll_lock);
+      if (!_have_pool_collection(pool)) {
+	dout(10) << __func__ << " pool " << pool << " went away, dropping dict "
+		 << id << dendl;
+	t = db->get_transaction();
+	t->rmkey(PREFIX_SUPER, dkey);
+	db->submit_transaction(t);
+	continue;
+      }
+      std::lock_guard l(compression_dict_lock);
+      auto m = std::make_shared<CompressionDictMap>(
+	*compression_dict_map.load());
+      m->dicts[id] = CompressionDict{pool, alg, now, dict};
+      m->by_key[key].push_back(id);
+      compression_dict_map.store(std::move(m));
+    }
+    dout(1) << __func__ << " trained " << Compressor::get_comp_alg_name(alg)
+	    << " dict " << id << " for pool " << pool << " from "
+	    << samples.size() << " samples, 0x" << std::hex << raw.length()
+	    << std::dec << " bytes" << dendl;
+  }
+}
+
+bool BlueStore::_have_pool_collection(int64_t pool)
+{
+  // caller holds coll_lock
+  return std::any_of(coll_map.begin(), coll_map.end(),
+		     [pool](auto& p) { return p.second->pool() == pool; });
+}
+
+void BlueStore::_drop_compression_dicts(TransContext *txc, int64_t pool)
+{
+  // caller holds coll_lock; blobs never span pools, so once the last
+  // collection of a pool is gone nothing refers to its dictionaries
+  for (auto& p : coll_map) {
+    if (p.second->pool() == pool) {
+      return;
+    }
+  }
+  std::lock_guard l(compression_dict_lock);
+  for (auto i = compression_dict_samplers.begin();
+       i != compression_dict_samplers.end(); ) {
+    if (i->first.first == pool) {
+      i = compression_dict_samplers.erase(i);
+    } else {
+      ++i;
+    }
+  }
+  auto m = std::make_shared<CompressionDictMap>(*compression_dict_map.load());
+  for (auto i = m->by_key.begin(); i != m->by_key.end(); ) {
+    if (i->first.first != pool) {
+      ++i;
+      continue;
+    }
+    for (auto id : i->second) {
+      dout(10) << __func__ << " pool " << pool << " dict " << id << dendl;
+      string key;
+      get_compression_dict_key(id, &key);
+      txc->t->rmkey(PREFIX_SUPER, key);
+      m->dicts.erase(id);
+    }
+    m->next_sample.erase(i->first);
+    i = m->by_key.erase(i);
+  }
+  compression_dict_map.store(std::move(m));
+}
+
 int BlueStore::_upgrade_super()
 {
   dout(1) << __func__ << " from " << ondisk_format << ", latest "
@@ -14382,22 +15266,10 @@ void BlueStore::_txc_state_proc(TransContext *txc)
 	  _txc_apply_kv(txc, true);
 	}
       }
-      {
-	std::lock_guard l(kv_lock);
-	kv_queue.push_back(txc);
-	if (!kv_sync_in_progress) {
-	  kv_sync_in_progress = true;
-	  kv_cond.notify_one();
-	}
-	if (txc->get_state() != TransContext::STATE_KV_SUBMITTED) {
-	  kv_queue_unsubmitted.push_back(txc);
-	  ++txc->osr->kv_committing_serially;
-	}
-	if (txc->had_ios)
-	  kv_ios++;
-	kv_throttle_costs += txc->cost;
-	++kv_throttle_txcs;
+      if (txc->get_state() != TransContext::STATE_KV_SUBMITTED) {
+	++txc->osr->kv_committing_serially;
       }
+      _kv_queue_txc(txc);
       return;
     case TransContext::STATE_KV_SUBMITTED:
       _txc_committed_kv(txc);
@@ -14582,6 +15454,25 @@ void BlueStore::_txc_finalize_kv(TransContext *txc, KeyValueDB::Transaction t)
   _txc_update_store_statfs(txc);
 }
 
+// Hand a txc in STATE_KV_QUEUED over to the kv sync thread.  Only
+// the push that finds the queue empty needs kv_lock, to wake the
+// thread; later pushes are picked up by the drain that follows it.
+void BlueStore::_kv_queue_txc(TransContext *txc)
+{
+  TransContext *head = kv_queue_head.load(std::memory_order_relaxed);
+  do {
+    txc->kv_queue_next = head;
+  } while (!kv_queue_head.compare_exchange_weak(
+	     head, txc, std::memory_order_release, std::memory_order_relaxed));
+  if (head == nullptr) {
+    std::lock_guard l(kv_lock);
+    if (!kv_sync_in_progress) {
+      kv_sync_in_progress = true;
+      kv_cond.notify_one();
+    }
+  }
+}
+
 void BlueStore::_txc_apply_kv(TransContext *txc, bool sync_submit_transaction)
 {
   ceph_assert(txc->get_state() == TransContext::STATE_KV_QUEUED);
@@ -14598,11 +15489,6 @@ void BlueStore::_txc_apply_kv(TransContext *txc, bool sync_submit_transaction)
 
     int r = cct->_conf->bluestore_debug_omit_kv_commit ? 0 : db->submit_transaction(txc->t);
     ceph_assert(r == 0);
-    txc->set_state(TransContext::STATE_KV_SUBMITTED);
-    if (txc->osr->kv_submitted_waiters) {
-      std::lock_guard l(txc->osr->qlock);
-      txc->osr->qcond.notify_all();
-    }
 
 #if defined(WITH_LTTNG)
     if (txc->tracing) {
@@ -14616,6 +15502,55 @@ void BlueStore::_txc_apply_kv(TransContext *txc, bool sync_submit_transaction)
     }
 #endif
   }
+  _txc_kv_submitted(txc);
+}
+
+// Submit the kv transactions of all txcs with one db write.
+void BlueStore::_txc_apply_kv_batch(const std::deque<TransContext*>& txcs)
+{
+  if (txcs.empty()) {
+    return;
+  }
+#if defined(WITH_LTTNG)
+  auto start = mono_clock::now();
+#endif
+  std::vector<KeyValueDB::Transaction> ts;
+  ts.reserve(txcs.size());
+  for (auto txc : txcs) {
+    ceph_assert(txc->get_state() == TransContext::STATE_KV_QUEUED);
+#ifdef WITH_BLKIN
+    if (txc->trace) {
+      txc->trace.event("db batch submit");
+    }
+#endif
+    ts.push_back(txc->t);
+  }
+  int r = cct->_conf->bluestore_debug_omit_kv_commit ? 0 : db->submit_transactions(ts);
+  ceph_assert(r == 0);
+  logger->inc(l_bluestore_kv_batched_txcs, txcs.size());
+  for (auto txc : txcs) {
+#if defined(WITH_LTTNG)
+    if (txc->tracing) {
+      tracepoint(
+	bluestore,
+	transaction_kv_submit_latency,
+	txc->osr->get_sequencer_id(),
+	(uint64_t)txc,
+	false,
+	ceph::to_seconds<double>(mono_clock::now() - start));
+    }
+#endif
+    _txc_kv_submitted(txc);
+  }
+}
+
+void BlueStore::_txc_kv_submitted(TransContext *txc)
+{
+  txc->set_state(TransContext::STATE_KV_SUBMITTED);
+  if (txc->osr->kv_submitted_waiters) {
+    std::lock_guard l(txc->osr->qlock);
+    txc->osr->qcond.notify_all();
+  }
 
   for (auto ls : { &txc->onodes, &txc->modified_objects }) {
     for (auto& o : *ls) {
@@ -14927,6 +15862,7 @@ void BlueStore::_kv_start()
   dout(10) << __func__ << dendl;
 
   finisher.start();
+  compression_dict_finisher.start();
   kv_sync_thread.create("bstore_kv_sync");
   kv_finalize_thread.create("bstore_kv_final");
 }
@@ -14934,6 +15870,9 @@ void BlueStore::_kv_start()
 void BlueStore::_kv_stop()
 {
   dout(10) << __func__ << dendl;
+  // dictionary training submits to the kv store directly
+  compression_dict_finisher.wait_for_empty();
+  compression_dict_finisher.stop();
   {
     std::unique_lock l{kv_lock};
     while (!kv_sync_started) {
@@ -14995,7 +15934,7 @@ void BlueStore::_kv_sync_thread()
       kv_submitted = 0;
     }
     ceph_assert(kv_committing.empty());
-    if (kv_queue.empty() &&
+    if (kv_queue_head.load(std::memory_order_relaxed) == nullptr &&
 	((deferred_done_queue.empty() && deferred_stable_queue.empty()) ||
 	 !deferred_aggressive)) {
       if (kv_stop)
@@ -15012,21 +15951,29 @@ void BlueStore::_kv_sync_thread()
       deque<DeferredBatch*> deferred_done, deferred_stable;
       uint64_t aios = 0, costs = 0, txcs = 0;
 
-      dout(20) << __func__ << " committing " << kv_queue.size()
-	       << " submitting " << kv_queue_unsubmitted.size()
+      // the queue is a stack, restore arrival order
+      for (auto txc = kv_queue_head.exchange(nullptr, std::memory_order_acquire);
+	   txc;
+	   txc = txc->kv_queue_next) {
+	kv_committing.push_front(txc);
+      }
+      for (auto txc : kv_committing) {
+	if (txc->get_state() == TransContext::STATE_KV_QUEUED) {
+	  kv_submitting.push_back(txc);
+	}
+	if (txc->had_ios) {
+	  ++aios;
+	}
+	costs += txc->cost;
+	++txcs;
+      }
+      dout(20) << __func__ << " committing " << kv_committing.size()
+	       << " submitting " << kv_submitting.size()
 	       << " deferred done " << deferred_done_queue.size()
 	       << " stable " << deferred_stable_queue.size()
 	       << dendl;
-      kv_committing.swap(kv_queue);
-      kv_submitting.swap(kv_queue_unsubmitted);
       deferred_done.swap(deferred_done_queue);
       deferred_stable.swap(deferred_stable_queue);
-      aios = kv_ios;
-      costs = kv_throttle_costs;
-      txcs = kv_throttle_txcs;
-      kv_ios = 0;
-      kv_throttle_costs = 0;
-      kv_throttle_txcs = 0;
       l.unlock();
 
       dout(30) << __func__ << " committing " << kv_committing << dendl;
@@ -15104,17 +16051,15 @@ void BlueStore::_kv_sync_thread()
 
       for (auto txc : kv_committing) {
 	throttle.log_state_latency(*txc, logger, l_bluestore_state_kv_queued_lat);
-	if (txc->get_state() == TransContext::STATE_KV_QUEUED) {
-	  ++kv_submitted;
-	  _txc_apply_kv(txc, false);
-	  --txc->osr->kv_committing_serially;
-	} else {
-	  ceph_assert(txc->get_state() == TransContext::STATE_KV_SUBMITTED);
-	}
 	if (txc->had_ios) {
 	  --txc->osr->txc_with_unstable_io;
 	}
       }
+      kv_submitted += kv_submitting.size();
+      _txc_apply_kv_batch(kv_submitting);
+      for (auto txc : kv_submitting) {
+	--txc->osr->kv_committing_serially;
+      }
 
       // release throttle *before* we commit.  this allows new ops
       // to be prepared and enter pipeline while we are waiting on
@@ -17001,7 +17946,8 @@ int BlueStore::_do_alloc_write(
       // FIXME: memory alignment here is bad
       bufferlist t;
       std::optional<int32_t> compressor_message;
-      int r = wctx->compressor->compress(wi.bl, t, compressor_message);
+      uint32_t dict_id;
+      int r = _compress_blob(wctx, wi.bl, t, compressor_message, &dict_id);
       uint64_t want_len_raw = wi.blob_length * wctx->crr;
       uint64_t want_len = p2roundup(want_len_raw, min_alloc_size);
       bool rejected = false;
@@ -17014,6 +17960,7 @@ int BlueStore::_do_alloc_write(
 	chdr.type = wctx->compressor->get_type();
 	chdr.length = t.length();
 	chdr.compressor_message = compressor_message;
+	chdr.dict_id = dict_id;
 	encode(chdr, wi.compressed_bl);
 	wi.compressed_bl.claim_append(t);
 
@@ -17456,6 +18403,7 @@ void BlueStore::_choose_write_options(
     wctx->crr = c->compression_req_ratio.has_value() ?
       *(c->compression_req_ratio) :
       cct->_conf->bluestore_compression_required_ratio;
+    _choose_compression_dict(c->pool(), wctx);
   }
 
   dout(20) << __func__ << " prefer csum_order " << wctx->csum_order
@@ -17465,6 +18413,73 @@ void BlueStore::_choose_write_options(
            << std::dec << dendl;
 }
 
+void BlueStore::_choose_compression_dict(int64_t pool, WriteContext *wctx)
+{
+  if (!cct->_conf->bluestore_compression_dict_max_blob_size ||
+      !wctx->compressor) {
+    return;
+  }
+  compression_dict_key_t key(pool, wctx->compressor->get_type());
+  utime_t now = ceph_clock_now();
+  auto m = compression_dict_map.load();
+  bool stale = true;
+  auto p = m->by_key.find(key);
+  if (p != m->by_key.end()) {
+    uint32_t id = p->second.back();
+    auto& d = m->dicts.at(id);
+    wctx->compressor_dict = d.dict;
+    wctx->compressor_dict_id = id;
+    // old dictionaries stay around for as long as the pool does, so stop
+    // retraining once it has its share
+    stale = p->second.size() <
+      cct->_conf->bluestore_compression_dict_max_per_pool &&
+      d.ctime + cct->_conf->bluestore_compression_dict_max_age < now;
+  }
+  if (stale) {
+    auto q = m->next_sample.find(key);
+    if (q == m->next_sample.end() || q->second <= now) {
+      wctx->dict_sample_pool = pool;
+    }
+  }
+}
+
+int BlueStore::_compress_blob(
+  const WriteContext *wctx,
+  const bufferlist& in,
+  bufferlist& out,
+  std::optional<int32_t>& compressor_message,
+  uint32_t *dict_id)
+{
+  *dict_id = 0;
+  bool small = in.length() <= cct->_conf->bluestore_compression_dict_max_blob_size;
+  if (small && wctx->dict_sample_pool >= 0) {
+    compression_dict_key_t key(wctx->dict_sample_pool,
+			       wctx->compressor->get_type());
+    std::lock_guard l(compression_dict_lock);
+    auto& s = compression_dict_samplers[key];
+    if (s.bytes < cct->_conf->bluestore_compression_dict_sample_size) {
+      // copy, so that we do not pin the write's buffers; the blob is
+      // small, and once the sampler is full nothing is copied at all
+      bufferlist sample;
+      sample.substr_of(in, 0, in.length());
+      sample.rebuild();
+      s.bytes += sample.length();
+      s.samples.push_back(std::move(sample));
+    }
+  }
+  if (small && wctx->compressor_dict) {
+    int r = wctx->compressor->compress_with_dict(
+      in, out, wctx->compressor_dict, compressor_message);
+    if (r == 0) {
+      *dict_id = wctx->compressor_dict_id;
+      return 0;
+    }
+    out.clear();
+    compressor_message.reset();
+  }
+  return wctx->compressor->compress(in, out, compressor_message);
+}
+
 int BlueStore::_do_gc(
   TransContext *txc,
   CollectionRef& c,
@@ -18686,6 +19701,8 @@ void BlueStore::_do_remove_collection(TransContext *txc,
   (*c)->exists = false;
   _osr_register_zombie((*c)->osr.get());
   txc->t->rmkey(PREFIX_COLL, stringify((*c)->cid));
+  _drop_compression_dicts(txc, (*c)->pool());
+  _drop_verify_readaheads(c->get());
   c->reset();
 }
 
@@ -19151,6 +20168,7 @@ void BlueStore::generate_db_histogram(Formatter *f)
 void BlueStore::_shutdown_cache()
 {
   dout(10) << __func__ << dendl;
+  _drop_verify_readaheads();
   for (auto i : buffer_cache_shards) {
     i->flush();
     ceph_assert(i->empty());
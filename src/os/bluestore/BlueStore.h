@@ -58,6 +58,7 @@
 #include "bluestore_types.h"
 #include "bluestore_common.h"
 #include "BlueFS.h"
+#include "DeferredWriteModel.h"
 #include "common/EventTrace.h"
 #include "common/admin_socket.h"
 
@@ -127,6 +128,7 @@ enum {
   l_bluestore_kv_commit_lat,
   l_bluestore_kv_sync_lat,
   l_bluestore_kv_final_lat,
+  l_bluestore_kv_batched_txcs,
   //****************************************
 
   // write op stats
@@ -150,6 +152,7 @@ enum {
   l_bluestore_issued_deferred_write_bytes,
   l_bluestore_submitted_deferred_writes,
   l_bluestore_submitted_deferred_write_bytes,
+  l_bluestore_deferred_adaptive_size,
 
   l_bluestore_write_big_skipped_blobs,
   l_bluestore_write_big_skipped_bytes,
@@ -1336,6 +1339,12 @@ public:
                               /// (it can be pinned and hence physically out
                               /// of it at the moment though)
     uint16_t prev_spanning_cnt = 0; /// spanning blobs count
+    /// CLOCK state (ClockOnodeCacheShard only); clock_ref may be bumped
+    /// without the shard lock, the rest is protected by it
+    std::atomic<uint8_t> clock_ref = {0};
+    std::atomic_bool clock_linked = {false};
+    std::atomic_bool clock_pinned = {false}; ///< counted as pinned
+    bool clock_hot = false;
     ExtentMap extent_map;
     BufferSpace bc;             ///< buffer cache
 
@@ -1549,6 +1558,8 @@ public:
     virtual void _rm(Onode* o) = 0;
     virtual void _move_pinned(OnodeCacheShard *to, Onode *o) = 0;
 
+    /// called when a reference beyond the cache's own is taken
+    virtual void on_pin(Onode* o) {}
     virtual void maybe_unpin(Onode* o) = 0;
     virtual void add_stats(uint64_t *onodes, uint64_t *pinned_onodes) = 0;
     bool empty() {
@@ -1616,6 +1627,7 @@ public:
     friend struct Collection; // for split_cache()
     friend struct Onode; // for put()
     friend struct LruOnodeCacheShard;
+    friend struct ClockOnodeCacheShard;
     void _remove(const ghobject_t& oid);
   public:
     OnodeSpace(OnodeCacheShard *c) : cache(c) {}
@@ -1914,6 +1926,7 @@ public:
 
     IOContext ioc;
     bool had_ios = false;  ///< true if we submitted IOs before our kv txn
+    TransContext *kv_queue_next = nullptr;  ///< link in kv_queue_head
 
     //uint64_t seq = 0;
     ceph::mono_clock::time_point start;
@@ -2391,8 +2404,8 @@ private:
   bool kv_stop = false;
   bool kv_finalize_started = false;
   bool kv_finalize_stop = false;
-  std::deque<TransContext*> kv_queue;             ///< ready, already submitted
-  std::deque<TransContext*> kv_queue_unsubmitted; ///< ready, need submit by kv thread
+  /// txcs ready for the kv thread, newest first; pushed without kv_lock
+  std::atomic<TransContext*> kv_queue_head = {nullptr};
   std::deque<TransContext*> kv_committing;        ///< currently syncing
   std::deque<DeferredBatch*> deferred_done_queue;   ///< deferred ios done
   bool kv_sync_in_progress = false;
@@ -2454,6 +2467,39 @@ private:
   std::atomic<int> def_compressor_alg = {Compressor::COMP_ALG_NONE};
   std::vector<CompressorRef> compressors;
   std::atomic<uint64_t> comp_min_blob_size = {0};
+
+  /// a loaded bluestore_compression_dict_t
+  struct CompressionDict {
+    int64_t pool;
+    uint8_t type;
+    utime_t ctime;
+    Compressor::DictionaryRef dict;
+  };
+  /// small blobs collected to train a pool's next dictionary
+  struct CompressionDictSampler {
+    std::vector<ceph::buffer::list> samples;
+    uint64_t bytes = 0;
+  };
+  using compression_dict_key_t = std::pair<int64_t,uint8_t>; ///< (pool, alg)
+  /// immutable; replaced as a whole when a dictionary is added or dropped
+  struct CompressionDictMap {
+    std::map<uint32_t,CompressionDict> dicts;  ///< id -> dict
+    /// ids of each (pool, alg), oldest first; the last one is used for writes
+    std::map<compression_dict_key_t,std::vector<uint32_t>> by_key;
+    /// do not sample a (pool, alg) again before this
+    std::map<compression_dict_key_t,utime_t> next_sample;
+  };
+  using CompressionDictMapRef = std::shared_ptr<const CompressionDictMap>;
+  /// read lock-free by the write and read paths
+  std::atomic<CompressionDictMapRef> compression_dict_map{
+    std::make_shared<const CompressionDictMap>()};
+  /// serializes updates of compression_dict_map and guards the rest
+  ceph::mutex compression_dict_lock =
+    ceph::make_mutex("BlueStore::compression_dict_lock");
+  uint32_t compression_dict_max = 0;  ///< last dictionary id handed out
+  std::map<compression_dict_key_t,CompressionDictSampler> compression_dict_samplers;
+  /// trains and stores dictionaries off the mempool thread
+  Finisher compression_dict_finisher;
   std::atomic<uint64_t> comp_max_blob_size = {0};
 
   std::atomic<uint64_t> max_blob_size = {0};  ///< maximum blob size
@@ -2461,10 +2507,6 @@ private:
                                             /// When 0 onode_bluestore_t v2 is in force, otherwise v3 is used.
                                             /// Ability to disable is important for efficient testing.
 
-  uint64_t kv_ios = 0;
-  uint64_t kv_throttle_costs = 0;
-  uint64_t kv_throttle_txcs = 0;
-
   // cache trim control
   uint64_t cache_size = 0;       ///< total cache size
   double cache_meta_ratio = 0;   ///< cache ratio dedicated to metadata
@@ -2765,6 +2807,8 @@ private:
   int _write_fsid();
   void _close_fsid();
   void _set_alloc_sizes();
+  DeferredWriteModel _get_deferred_write_model() const;
+  void _update_deferred_policy();
   void _set_blob_size();
   void _set_finisher_num();
   void _set_per_pool_omap();
@@ -2853,6 +2897,13 @@ private:
   void _main_bdev_label_remove(Allocator* alloc);
 
   int _open_super_meta();
+  int _open_compression_dicts();
+  Compressor::DictionaryRef _get_compression_dict(uint32_t id);
+  void _queue_compression_dict_training();
+  void _train_compression_dicts(
+    std::map<compression_dict_key_t,std::vector<ceph::buffer::list>>& ready);
+  bool _have_pool_collection(int64_t pool);
+  void _drop_compression_dicts(TransContext *txc, int64_t pool);
 
   void _open_statfs();
   void _get_statfs_overall(struct store_statfs_t *buf);
@@ -2891,6 +2942,9 @@ private:
   void _txc_finish_io(TransContext *txc);
   void _txc_finalize_kv(TransContext *txc, KeyValueDB::Transaction t);
   void _txc_apply_kv(TransContext *txc, bool sync_submit_transaction);
+  void _txc_apply_kv_batch(const std::deque<TransContext*>& txcs);
+  void _txc_kv_submitted(TransContext *txc);
+  void _kv_queue_txc(TransContext *txc);
   void _txc_committed_kv(TransContext *txc);
   void _txc_finish(TransContext *txc);
   void _txc_release_alloc(TransContext *txc);
@@ -3211,6 +3265,13 @@ public:
     size_t len,
     ceph::buffer::list& bl,
     uint32_t op_flags = 0) override;
+  int verify_object_checksums(
+    CollectionHandle &c,
+    const ghobject_t& oid,
+    uint64_t offset,
+    size_t len,
+    uint32_t *digest,
+    uint32_t op_flags = 0) override;
 
 private:
 
@@ -3295,6 +3356,65 @@ private:
     uint32_t op_flags = 0,
     uint64_t retry_count = 0);
 
+  int _do_verify_checksums(
+    Collection *c,
+    OnodeRef& o,
+    uint64_t offset,
+    size_t len,
+    uint32_t *digest,
+    uint32_t op_flags,
+    uint64_t retry_count = 0);
+  /// an asynchronous read of the range that the next sequential
+  /// verify_object_checksums() of an object is expected to ask for
+  struct VerifyReadahead {
+    CollectionRef c;
+    OnodeRef o;
+    uint64_t offset;
+    size_t length;
+    blobs2read_t blobs2read;
+    std::vector<ceph::buffer::list> compressed_blob_bls;
+    IOContext ioc;
+
+    VerifyReadahead(CephContext *cct, Collection *c, OnodeRef& o,
+		    uint64_t offset, size_t length)
+      : c(c), o(o), offset(offset), length(length),
+	ioc(cct, nullptr, !cct->_conf->bluestore_fail_eio) {}
+    ~VerifyReadahead() {
+      // the aios point into blobs2read and compressed_blob_bls
+      ioc.aio_wait();
+    }
+  };
+  /// at most one per object being verified, i.e. per scrubbing PG
+  static constexpr size_t VERIFY_READAHEAD_MAX = 8;
+  ceph::mutex verify_readahead_lock =
+    ceph::make_mutex("BlueStore::verify_readahead_lock");
+  std::list<std::unique_ptr<VerifyReadahead>> verify_readaheads;
+
+  void _start_verify_readahead(
+    Collection *c,
+    OnodeRef& o,
+    uint64_t offset,
+    size_t length,
+    int read_cache_policy);
+  /// take the readahead of the given range, if there is one, and wait
+  /// for it; returns false if its reads are unusable
+  bool _take_verify_readahead(
+    Collection *c,
+    OnodeRef& o,
+    uint64_t offset,
+    size_t length,
+    const blobs2read_t& blobs2read,
+    blobs2read_t* ra_blobs2read,
+    std::vector<ceph::buffer::list>* ra_compressed_blob_bls);
+  /// drop the readaheads of a collection, or all of them if c is null
+  void _drop_verify_readaheads(Collection *c = nullptr);
+
+  /// crc32c (seed 0) of a region of a just verified, uncompressed read
+  uint32_t _region_crc32c(
+    const bluestore_blob_t& blob,
+    const ceph::buffer::list& bl,
+    const region_t& reg);
+
   void _do_read_and_pad(
     Collection* c,
     OnodeRef& o,
@@ -3657,6 +3777,9 @@ private:
     uint8_t csum_type = 0;          ///< checksum type for new blobs
     unsigned csum_order = 0;        ///< target checksum chunk order
     uint64_t target_blob_size = 0;  ///< target (max) blob size
+    Compressor::DictionaryRef compressor_dict; ///< for small blobs, if any
+    uint32_t compressor_dict_id = 0;           ///< id of compressor_dict
+    int64_t dict_sample_pool = -1;  ///< sample small blobs for this pool
 
     old_extent_map_t old_extents;   ///< must deref these blobs
     interval_set<uint64_t> extents_to_gc; ///< extents for garbage collection
@@ -3791,6 +3914,12 @@ private:
                              OnodeRef& o,
                              uint32_t fadvise_flags,
                              WriteContext *wctx);
+  void _choose_compression_dict(int64_t pool, WriteContext *wctx);
+  int _compress_blob(const WriteContext *wctx,
+		     const ceph::buffer::list& in,
+		     ceph::buffer::list& out,
+		     std::optional<int32_t>& compressor_message,
+		     uint32_t *dict_id);
 
   int _do_gc(TransContext *txc,
              CollectionRef& c,
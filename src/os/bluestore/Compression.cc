@@ -207,12 +207,15 @@ int32_t Estimator::split_and_compress(
     // FIXME: memory alignment here is bad
     bufferlist t;
     std::optional<int32_t> compressor_message;
-    int r = wctx->compressor->compress(bd.back().object_data, t, compressor_message);
+    uint32_t dict_id;
+    int r = bluestore->_compress_blob(wctx, bd.back().object_data, t,
+				      compressor_message, &dict_id);
     ceph_assert(r == 0);
     bluestore_compression_header_t chdr;
     chdr.type = wctx->compressor->get_type();
     chdr.length = t.length();
     chdr.compressor_message = compressor_message;
+    chdr.dict_id = dict_id;
     encode(chdr, bd.back().disk_data);
     bd.back().disk_data.claim_append(t);
     uint32_t len = bd.back().disk_data.length();
@@ -0,0 +1,78 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab
+
+#pragma once
+
+#include <algorithm>
+
+#include "blk/BlockDevice.h"
+#include "common/Formatter.h"
+#include "include/intarith.h"
+
+/*
+ * Cost model behind the adaptive bluestore_prefer_deferred_size.
+ *
+ * A direct write makes the client wait for the main device before the
+ * kv commit.  A deferred write instead carries its payload in the kv
+ * WAL and is written to the main device later, off the client's path;
+ * that later write only costs the client when the main device is busy
+ * and it has to queue behind it.  Both costs are linear in the write
+ * length, so deferring wins for every write below one break-even size.
+ */
+struct DeferredWriteModel {
+  bdev_write_stats_t main;   ///< device holding object data
+  bdev_write_stats_t kv;     ///< device holding the kv WAL
+  bool main_rotational = true;
+
+  /// completions needed on both devices before the model is trusted
+  static constexpr uint64_t min_samples = 32;
+
+  bool ready() const {
+    return main.samples >= min_samples && kv.samples >= min_samples &&
+      main.bw > 0 && kv.bw > 0;
+  }
+
+  /// fraction of time a new main device write finds it busy
+  double main_load() const {
+    return double(main.in_flight) / (1 + main.in_flight);
+  }
+
+  /// fixed part of a direct write, including the queue ahead of it
+  double direct_fixed_us() const {
+    // a spinning disk serves the writes ahead of us one at a time;
+    // solid state queueing shows up in the measured latency itself
+    return main_rotational ? main.lat_us * (1 + main.in_flight) : main.lat_us;
+  }
+
+  /// expected client latency of writing len bytes directly
+  double direct_us(uint64_t len) const {
+    return direct_fixed_us() + len * 1000000.0 / main.bw;
+  }
+
+  /// expected client latency added by deferring len bytes
+  double deferred_us(uint64_t len) const {
+    return len * 1000000.0 / kv.bw +
+      main_load() * (main.lat_us + len * 1000000.0 / main.bw);
+  }
+
+  /// largest write length that is cheaper to defer, within [0, max_size]
+  uint64_t breakeven(uint64_t max_size, uint64_t block_size) const {
+    double fixed = direct_fixed_us() - main_load() * main.lat_us;
+    double per_byte = 1000000.0 / kv.bw -
+      (1 - main_load()) * 1000000.0 / main.bw;
+    double size = per_byte > 0 ? fixed / per_byte : max_size;
+    size = std::clamp<double>(size, 0, max_size);
+    return p2align<uint64_t>(size, block_size);
+  }
+
+  void dump(ceph::Formatter *f) const {
+    f->open_object_section("main");
+    main.dump(f);
+    f->dump_bool("rotational", main_rotational);
+    f->close_section();
+    f->open_object_section("kv");
+    kv.dump(f);
+    f->close_section();
+    f->dump_bool("ready", ready());
+  }
+};
@@ -1551,6 +1551,9 @@ void bluestore_compression_header_t::dump(Formatter *f) const
   if (compressor_message) {
     f->dump_int("compressor_message", *compressor_message);
   }
+  if (dict_id) {
+    f->dump_unsigned("dict_id", dict_id);
+  }
 }
 
 list<bluestore_compression_header_t> bluestore_compression_header_t::generate_test_instances()
@@ -1559,6 +1562,31 @@ list<bluestore_compression_header_t> bluestore_compression_header_t::generate_te
   o.emplace_back();
   o.push_back(bluestore_compression_header_t(1));
   o.back().length = 1234;
+  o.push_back(bluestore_compression_header_t(3));
+  o.back().length = 4321;
+  o.back().dict_id = 7;
+  return o;
+}
+
+// bluestore_compression_dict_t
+
+void bluestore_compression_dict_t::dump(Formatter *f) const
+{
+  f->dump_int("pool", pool);
+  f->dump_unsigned("type", type);
+  f->dump_stream("ctime") << ctime;
+  f->dump_unsigned("length", dict.length());
+}
+
+list<bluestore_compression_dict_t> bluestore_compression_dict_t::generate_test_instances()
+{
+  list<bluestore_compression_dict_t> o;
+  o.emplace_back();
+  o.emplace_back();
+  o.back().pool = 2;
+  o.back().type = 3;
+  o.back().ctime = utime_t(123, 456);
+  o.back().dict.append("dictdata");
   return o;
 }
 
@@ -1345,18 +1345,22 @@ struct bluestore_compression_header_t {
   uint8_t type = Compressor::COMP_ALG_NONE;
   uint32_t length = 0;
   std::optional<int32_t> compressor_message;
+  uint32_t dict_id = 0;  ///< bluestore_compression_dict_t used, if any
 
   bluestore_compression_header_t() {}
   bluestore_compression_header_t(uint8_t _type)
     : type(_type) {}
 
   DENC(bluestore_compression_header_t, v, p) {
-    DENC_START(2, 1, p);
+    DENC_START(3, 1, p);
     denc(v.type, p);
     denc(v.length, p);
     if (struct_v >= 2) {
       denc(v.compressor_message, p);
     }
+    if (struct_v >= 3) {
+      denc(v.dict_id, p);
+    }
     DENC_FINISH(p);
   }
   void dump(ceph::Formatter *f) const;
@@ -1364,6 +1368,26 @@ struct bluestore_compression_header_t {
 };
 WRITE_CLASS_DENC(bluestore_compression_header_t)
 
+/// a compression dictionary trained from a pool's small blobs
+struct bluestore_compression_dict_t {
+  int64_t pool = -1;
+  uint8_t type = Compressor::COMP_ALG_NONE;
+  utime_t ctime;
+  ceph::buffer::list dict;
+
+  DENC(bluestore_compression_dict_t, v, p) {
+    DENC_START(1, 1, p);
+    denc(v.pool, p);
+    denc(v.type, p);
+    denc(v.ctime, p);
+    denc(v.dict, p);
+    DENC_FINISH(p);
+  }
+  void dump(ceph::Formatter *f) const;
+  static std::list<bluestore_compression_dict_t> generate_test_instances();
+};
+WRITE_CLASS_DENC(bluestore_compression_dict_t)
+
 template <template <typename> typename V, class COUNTER_TYPE = int32_t>
 class ref_counter_2hash_tracker_t {
   size_t num_non_zero = 0;
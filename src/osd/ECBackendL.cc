@@ -1756,19 +1756,19 @@ int ECBackendL::be_deep_scrub(
     pos.data_hash = bufferhash(-1);
   }
 
-  uint64_t stride = cct->_conf->osd_deep_scrub_stride;
+  uint64_t stride = PGBackend::get_deep_scrub_stride(cct, switcher->store);
   if (stride % sinfo.get_chunk_size())
     stride += sinfo.get_chunk_size() - (stride % sinfo.get_chunk_size());
 
   auto& perf_logger = *(get_parent()->get_logger());
   perf_logger.inc(io_counters.read_cnt);
-  bufferlist bl;
-  r = switcher->store->read(
+  uint32_t digest = pos.data_hash.digest();
+  r = switcher->store->verify_object_checksums(
     switcher->ch,
     ghobject_t(
       poid, ghobject_t::NO_GEN, get_parent()->whoami_shard().shard),
     pos.data_pos,
-    stride, bl,
+    stride, &digest,
     ECCommonL::scrub_fadvise_flags);
   if (r < 0) {
     dout(20) << __func__ << "  " << poid << " got "
@@ -1776,16 +1776,14 @@ int ECBackendL::be_deep_scrub(
     o.read_error = true;
     return 0;
   }
-  if (bl.length() % sinfo.get_chunk_size()) {
+  if (r % sinfo.get_chunk_size()) {
     dout(20) << __func__ << "  " << poid << " got "
 	     << r << " on read, not chunk size " << sinfo.get_chunk_size() << " aligned"
 	     << dendl;
     o.read_error = true;
     return 0;
   }
-  if (r > 0) {
-    pos.data_hash << bl;
-  }
+  pos.data_hash = bufferhash(digest);
   perf_logger.inc(io_counters.read_bytes, r);
   pos.data_pos += r;
   if (r == (int)stride) {
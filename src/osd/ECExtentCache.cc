@@ -3,6 +3,7 @@
 
 #include "ECExtentCache.h"
 #include "ECUtil.h"
+#include "osd_perf_counters.h"
 
 #include <mutex>
 #include <ranges>
@@ -185,7 +186,7 @@ void ECExtentCache::Object::invalidate(const OpRef &invalidating_op) {
   }
 
   // Remove all entries from the LRU
-  pg.lru.remove_object(oid);
+  pg.lru.remove_object(&pg, oid);
 
   ceph_assert(!reading);
   do_not_read.clear();
@@ -312,16 +313,15 @@ void ECExtentCache::on_change() {
 
 /* This must be run toward the end of EC on_change handling.  It asserts that
  * any object which is automatically self-destructs when idle has done so.
- * Additionally, it discards the entire LRU cache. This must be done after all
- * in-flight reads/writes have completed, or we risk attempting to insert data
- * into the cache after it has been cleared.
+ * Additionally, it discards this PG's lines from the LRU cache. This must be
+ * done after all in-flight reads/writes have completed, or we risk attempting
+ * to insert data into the cache after it has been cleared.
  *
- * Note that the LRU will end up being called multiple times. With some
- * additional code complexity this could be fixed for a small (probably
- * insignificant) performance improvement.
+ * Lines cached by other PGs sharing the LRU are unaffected by this PG's
+ * interval change and are retained.
  */
 void ECExtentCache::on_change2() const {
-  lru.discard();
+  lru.discard(this);
   /* If this assert fires in a unit test, make sure that all ops have completed
    * and cleared any extent cache ops they contain */
   ceph_assert(objects.empty());
@@ -360,7 +360,7 @@ void ECExtentCache::LRU::add(const Line &line) {
     return;
   }
 
-  const Key k(line.offset, line.object.oid);
+  const Key k(line.offset, line.object.oid, &line.object.pg);
 
   shared_ptr<shard_extent_map_t> cache = line.cache;
 
@@ -374,22 +374,34 @@ void ECExtentCache::LRU::add(const Line &line) {
 }
 
 shared_ptr<shard_extent_map_t> ECExtentCache::LRU::find(
-    const hobject_t &oid, uint64_t offset) {
+    const ECExtentCache *owner, const hobject_t &oid, uint64_t offset) {
   shared_ptr<shard_extent_map_t> cache = nullptr;
   std::lock_guard lock{mutex};
-  if (auto found = map.find({offset, oid}); found != map.end()) {
+  if (auto found = map.find({offset, oid, owner}); found != map.end()) {
     auto &&[lru_iter, c] = found->second;
     cache = c;
     auto it = lru_iter; // Intentional copy.
     erase(it, false);
+    stats.hits++;
+    stats.hit_bytes += cache->size();
+    if (logger) {
+      logger->inc(l_osd_ec_cache_hit);
+      logger->inc(l_osd_ec_cache_hit_bytes, cache->size());
+    }
+  } else {
+    stats.misses++;
+    if (logger) {
+      logger->inc(l_osd_ec_cache_miss);
+    }
   }
   return cache;
 }
 
-void ECExtentCache::LRU::remove_object(const hobject_t &oid) {
+void ECExtentCache::LRU::remove_object(const ECExtentCache *owner,
+                                       const hobject_t &oid) {
   std::lock_guard lock{mutex};
   for (auto it = lru.begin(); it != lru.end();) {
-    if (it->oid == oid) {
+    if (it->owner == owner && it->oid == oid) {
       it = erase(it, true);
     } else {
       ++it;
@@ -401,15 +413,22 @@ void ECExtentCache::LRU::free_maybe() {
   while (max_size < size) {
     auto it = lru.begin();
     erase(it, true);
+    stats.evictions++;
+    if (logger) {
+      logger->inc(l_osd_ec_cache_evict);
+    }
   }
 }
 
-void ECExtentCache::LRU::discard() {
+void ECExtentCache::LRU::discard(const ECExtentCache *owner) {
   std::lock_guard lock{mutex};
-  lru.clear();
-  update_mempool(0 - map.size(), 0 - size);
-  map.clear();
-  size = 0;
+  for (auto it = lru.begin(); it != lru.end();) {
+    if (it->owner == owner) {
+      it = erase(it, true);
+    } else {
+      ++it;
+    }
+  }
 }
 
 const extent_set ECExtentCache::Op::get_pin_eset(uint64_t alignment) const {
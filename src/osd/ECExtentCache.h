@@ -33,6 +33,11 @@
  * The LRU has a maximum size (defined in the constructor) and will keep its
  * usage below this amount.
  *
+ * LRU entries are tagged with the extent cache (i.e. the PG) that created
+ * them, so that an interval change in one PG only discards that PG's lines
+ * rather than every line cached by the OSD-shard. Lookups count hits and
+ * misses, which are reported through the OSD perf counters if provided.
+ *
  * Cache Lines
  *
  * The LRU tracks extents of recent writes with cache Lines.  These are
@@ -77,6 +82,7 @@
 
 #include "ECUtil.h"
 #include "include/Context.h"
+#include "common/perf_counters.h"
 
 class ECExtentCache {
   class Address;
@@ -107,9 +113,17 @@ class ECExtentCache {
     struct Key {
       uint64_t offset;
       hobject_t oid;
+      const ECExtentCache *owner;
       bool operator==(const Key&) const = default;
     };
 
+    struct Stats {
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+      uint64_t hit_bytes = 0;
+      uint64_t evictions = 0;
+    };
+
     struct KeyHash {
       std::size_t operator()(const Key &obj) const {
         std::size_t seed = 0x625610ED;
@@ -129,20 +143,32 @@ class ECExtentCache {
     std::list<Key> lru;
     uint64_t max_size = 0;
     uint64_t size = 0;
+    Stats stats;
+    PerfCounters *logger = nullptr;
     ceph::mutex mutex = ceph::make_mutex("ECExtentCache::LRU");
 
     void free_maybe();
-    void discard();
+    void discard(const ECExtentCache *owner);
     void add(const Line &line);
     void erase(const Key &k);
     std::list<Key>::iterator erase(const std::list<Key>::iterator &it,
                                    bool update_mempool);
     std::shared_ptr<ECUtil::shard_extent_map_t> find(
-        const hobject_t &oid, uint64_t offset);
-    void remove_object(const hobject_t &oid);
+        const ECExtentCache *owner, const hobject_t &oid, uint64_t offset);
+    void remove_object(const ECExtentCache *owner, const hobject_t &oid);
 
    public:
-    explicit LRU(uint64_t max_size) : map(), max_size(max_size) {}
+    explicit LRU(uint64_t max_size, PerfCounters *logger = nullptr) :
+      map(), max_size(max_size), logger(logger) {}
+
+    Stats get_stats() {
+      std::lock_guard lock{mutex};
+      return stats;
+    }
+    uint64_t get_size() {
+      std::lock_guard lock{mutex};
+      return size;
+    }
   };
 
   class Op {
@@ -270,7 +296,7 @@ private:
       offset(offset),
       object(object) {
       std::shared_ptr<ECUtil::shard_extent_map_t> c = object.pg.lru.find(
-        object.oid, offset);
+        &object.pg, object.oid, offset);
 
       if (c == nullptr) {
         cache = std::make_shared<ECUtil::shard_extent_map_t>(&object.pg.sinfo);
@@ -113,6 +113,29 @@ END_IGNORE_DEPRECATED
       }
     }
 
+    if (ec_impl->get_sub_chunk_count() == 1 &&
+        (ec_impl->get_supported_optimizations() &
+         ceph::ErasureCodeInterface::FLAG_EC_PLUGIN_OPTIMIZED_SUPPORTED)) {
+      shard_id_set want_set;
+      for (int i : need) {
+        want_set.insert(shard_id_t(i));
+      }
+      shard_id_map<bufferlist> chunks(ec_impl->get_chunk_count());
+      for (auto &&[shard, bl] : to_decode) {
+        chunks[shard_id_t(shard)] = bl;
+      }
+      shard_id_map<bufferlist> decoded(ec_impl->get_chunk_count());
+      r = ec_impl->decode_stripes(want_set, chunks, sinfo.get_chunk_size(),
+                                  &decoded);
+      ceph_assert(r == 0);
+      for (auto j = out.begin(); j != out.end(); ++j) {
+        bufferlist &bl = decoded[shard_id_t(j->first)];
+        ceph_assert(bl.length() == chunks_count * sinfo.get_chunk_size());
+        j->second->claim_append(bl);
+      }
+      return 0;
+    }
+
     for (int i = 0; i < chunks_count; i++) {
       map<int, bufferlist> chunks;
       for (auto j = to_decode.begin();
@@ -155,6 +178,22 @@ END_IGNORE_DEPRECATED
     if (logical_size == 0)
       return 0;
 
+    if (ec_impl->get_supported_optimizations() &
+        ceph::ErasureCodeInterface::FLAG_EC_PLUGIN_OPTIMIZED_SUPPORTED) {
+      shard_id_set want_set;
+      for (int i : want) {
+        want_set.insert(shard_id_t(i));
+      }
+      shard_id_map<bufferlist> encoded(ec_impl->get_chunk_count());
+      int r = ec_impl->encode_stripes(want_set, in, sinfo.get_stripe_width(),
+                                      &encoded);
+      ceph_assert(r == 0);
+      for (auto &&[shard, bl] : encoded) {
+        (*out)[static_cast<int>(shard)].claim_append(bl);
+      }
+      return 0;
+    }
+
     for (uint64_t i = 0; i < logical_size; i += sinfo.get_stripe_width()) {
       map<int, bufferlist> encoded;
       bufferlist buf;
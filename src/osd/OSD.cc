@@ -2652,6 +2652,8 @@ int OSD::set_numa_affinity()
 	derr << __func__ << " failed to set numa affinity: " << cpp_strerror(r)
 	     << dendl;
 	numa_node = -1;
+      } else if (cct->_conf.get_val<bool>("osd_op_shard_numa_affinity")) {
+	set_shard_numa_affinity();
       }
     }
   } else {
@@ -2660,6 +2662,38 @@ int OSD::set_numa_affinity()
   return 0;
 }
 
+void OSD::set_shard_numa_affinity()
+{
+  // carve out every slice before pinning anything, so that a failure
+  // leaves all shards unpinned rather than some of them
+  std::vector<std::pair<size_t, cpu_set_t>> slices(shards.size());
+  for (auto& sdata : shards) {
+    auto& [slice_size, slice] = slices[sdata->shard_id];
+    int r = get_cpu_set_slice(numa_cpu_set_size, &numa_cpu_set,
+			      num_shards, sdata->shard_id,
+			      &slice_size, &slice);
+    if (r < 0) {
+      derr << __func__ << " unable to split numa node " << numa_node
+	   << " cpus across " << num_shards << " shards: " << cpp_strerror(r)
+	   << dendl;
+      return;
+    }
+  }
+  for (auto& sdata : shards) {
+    std::lock_guard l(sdata->shard_lock);
+    std::tie(sdata->cpu_set_size, sdata->cpu_set) = slices[sdata->shard_id];
+    ++sdata->cpu_affinity_epoch;
+    dout(1) << __func__ << " " << sdata->shard_name << " cpus "
+	    << cpu_set_to_str_list(sdata->cpu_set_size, &sdata->cpu_set)
+	    << dendl;
+  }
+  // wake idle workers so they pick up their new affinity promptly
+  for (auto& sdata : shards) {
+    std::lock_guard l(sdata->sdata_wait_lock);
+    sdata->sdata_cond.notify_all();
+  }
+}
+
 // asok
 
 class OSDSocketHook : public AdminSocketHook {
@@ -11033,11 +11067,58 @@ OSDShard::OSDShard(
       osd->store->get_type(), osd_op_queue, osd_op_queue_cut_off, osd->monc)),
     context_queue(sdata_wait_lock, sdata_cond),
     ec_extent_cache_lru(cct->_conf.get_val<uint64_t>(
-      "ec_extent_cache_size"))
+      "ec_extent_cache_size"), osd->logger)
 {
+  CPU_ZERO(&cpu_set);
   dout(0) << "using op scheduler " << *scheduler << dendl;
 }
 
+void OSDShard::_maybe_apply_cpu_affinity()
+{
+  // sharded op wq threads are bound to a single shard for their lifetime
+  static thread_local unsigned applied_epoch = 0;
+  ceph_assert(ceph_mutex_is_locked_by_me(shard_lock));
+  if (applied_epoch == cpu_affinity_epoch) {
+    return;
+  }
+  applied_epoch = cpu_affinity_epoch;
+  int r = set_cpu_affinity_this_thread(cpu_set_size, &cpu_set);
+  if (r < 0) {
+    derr << __func__ << " " << shard_name << " failed to set cpu affinity to "
+	 << cpu_set_to_str_list(cpu_set_size, &cpu_set) << ": "
+	 << cpp_strerror(r) << dendl;
+  }
+}
+
+void OSDShard::note_numa_locality()
+{
+#if defined(__linux__)
+  if (osd->numa_node < 0) {
+    return;
+  }
+  int cpu = sched_getcpu();
+  if (cpu >= 0 &&
+      static_cast<size_t>(cpu) < osd->numa_cpu_set_size &&
+      CPU_ISSET(cpu, &osd->numa_cpu_set)) {
+    numa_node_cpu_items.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    off_numa_node_cpu_items.fetch_add(1, std::memory_order_relaxed);
+  }
+#endif
+}
+
+void OSDShard::dump_numa(ceph::Formatter *f) const
+{
+  f->open_object_section("numa");
+  f->dump_string("cpu_affinity",
+		 cpu_set_to_str_list(cpu_set_size, &cpu_set));
+  f->dump_unsigned("numa_node_cpu_items",
+		   numa_node_cpu_items.load(std::memory_order_relaxed));
+  f->dump_unsigned("off_numa_node_cpu_items",
+		   off_numa_node_cpu_items.load(std::memory_order_relaxed));
+  f->close_section();
+}
+
 
 // =============================================================
 
@@ -11083,6 +11164,7 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
 
   // peek at spg_t
   sdata->shard_lock.lock();
+  sdata->_maybe_apply_cpu_affinity();
   if (sdata->scheduler->empty() &&
       (!is_smallest_thread_index || sdata->context_queue.empty())) {
     std::unique_lock wait_lock{sdata->sdata_wait_lock};
@@ -11175,6 +11257,7 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
 
   // Access the stored item
   auto item = std::move(std::get<OpSchedulerItem>(work_item));
+  sdata->note_numa_locality();
   if (osd->is_stopping()) {
     sdata->shard_lock.unlock();
     for (auto c : oncommits) {
@@ -1027,6 +1027,24 @@ struct OSDShard {
   //longer than the most recent IO in each object.
   ECExtentCache::LRU ec_extent_cache_lru;
 
+  /// cpus this shard's worker threads are pinned to when
+  /// osd_op_shard_numa_affinity is enabled; bumping cpu_affinity_epoch makes
+  /// each worker re-apply it on its next pass through _process.
+  size_t cpu_set_size = 0;
+  cpu_set_t cpu_set;  ///< zeroed by the constructor
+  unsigned cpu_affinity_epoch = 0;
+
+  /// work items processed by a worker running on a cpu inside or outside
+  /// the osd's numa node.  this is where the worker was scheduled, not
+  /// where the memory it touched lives; it says nothing about remote
+  /// memory accesses.
+  std::atomic<uint64_t> numa_node_cpu_items = {0};
+  std::atomic<uint64_t> off_numa_node_cpu_items = {0};
+
+  void _maybe_apply_cpu_affinity();
+  void note_numa_locality();
+  void dump_numa(ceph::Formatter *f) const;
+
   void _attach_pg(OSDShardPGSlot *slot, PG *pg);
   void _detach_pg(OSDShardPGSlot *slot);
 
@@ -1785,6 +1803,7 @@ protected:
 	std::scoped_lock l{sdata->shard_lock};
 	f->open_object_section(queue_name);
 	sdata->scheduler->dump(*f);
+	sdata->dump_numa(f);
 	f->close_section();
       }
     }
@@ -2241,6 +2260,7 @@ public:
 
   int enable_disable_fuse(bool stop);
   int set_numa_affinity();
+  void set_shard_numa_affinity();
 
   void suicide(int exitcode);
   int shutdown();
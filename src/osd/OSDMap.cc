@@ -2109,6 +2109,47 @@ void OSDMap::get_upmap_pgs(vector<pg_t> *upmap_pgs) const
     upmap_pgs->push_back(p.first);
 }
 
+void OSDMap::get_explicit_mapping_pgs(const set<int>& osds,
+				      set<pg_t> *pgs) const
+{
+  auto any_of = [&osds](const auto& v) {
+    for (auto osd : v) {
+      if (osds.count(osd)) {
+	return true;
+      }
+    }
+    return false;
+  };
+  for (auto p = pg_temp->begin(); p != pg_temp->end(); ++p) {
+    if (any_of(p->second)) {
+      pgs->insert(p->first);
+    }
+  }
+  for (auto& [pgid, osd] : *primary_temp) {
+    if (osds.count(osd)) {
+      pgs->insert(pgid);
+    }
+  }
+  for (auto& [pgid, v] : pg_upmap) {
+    if (any_of(v)) {
+      pgs->insert(pgid);
+    }
+  }
+  for (auto& [pgid, items] : pg_upmap_items) {
+    for (auto& [from, to] : items) {
+      if (osds.count(from) || osds.count(to)) {
+	pgs->insert(pgid);
+	break;
+      }
+    }
+  }
+  for (auto& [pgid, osd] : pg_upmap_primaries) {
+    if (osds.count(osd)) {
+      pgs->insert(pgid);
+    }
+  }
+}
+
 bool OSDMap::check_pg_upmaps(
   CephContext *cct,
   const vector<pg_t>& to_check,
@@ -3117,6 +3158,63 @@ void OSDMap::_pg_to_up_acting_osds(
     *acting_primary = _acting_primary;
 }
 
+void OSDMap::pg_range_to_up_acting_osds(
+  int64_t poolid, unsigned ps_begin, unsigned ps_end,
+  vector<vector<int>> *up, vector<int> *up_primary,
+  vector<vector<int>> *acting, vector<int> *acting_primary) const
+{
+  ceph_assert(ps_begin <= ps_end);
+  unsigned n = ps_end - ps_begin;
+  up->clear();
+  up->resize(n);
+  up_primary->assign(n, -1);
+  acting->clear();
+  acting->resize(n);
+  acting_primary->assign(n, -1);
+  const pg_pool_t *pool = get_pg_pool(poolid);
+  if (!pool) {
+    return;
+  }
+
+  vector<int> pps(n);
+  for (unsigned i = 0; i < n; ++i) {
+    pps[i] = pool->raw_pg_to_pps(pg_t(ps_begin + i, poolid));
+  }
+  unsigned size = pool->get_size();
+  int ruleno = pool->get_crush_rule();
+  vector<int> rawout, rawout_len;
+  if (ruleno >= 0) {
+    crush->do_rule_batch(ruleno, pps, size, osd_weight, poolid,
+			 &rawout, &rawout_len);
+  }
+
+  for (unsigned i = 0; i < n; ++i) {
+    pg_t pg(ps_begin + i, poolid);
+    vector<int> raw;
+    if (ruleno >= 0) {
+      auto row = rawout.begin() + i * size;
+      raw.assign(row, row + rawout_len[i]);
+    }
+    _remove_nonexistent_osds(*pool, raw);
+
+    vector<int>& _acting = (*acting)[i];
+    int& _acting_primary = (*acting_primary)[i];
+    _get_temp_osds(*pool, pg, &_acting, &_acting_primary);
+    _apply_upmap(*pool, pg, &raw);
+    vector<int>& _up = (*up)[i];
+    _raw_to_up_osds(*pool, raw, &_up);
+    int& _up_primary = (*up_primary)[i];
+    _up_primary = _pick_primary(_up);
+    _apply_primary_affinity(pps[i], *pool, &_up, &_up_primary);
+    if (_acting.empty()) {
+      _acting = _up;
+      if (_acting_primary == -1) {
+	_acting_primary = _up_primary;
+      }
+    }
+  }
+}
+
 int OSDMap::calc_pg_role_broken(int osd, const vector<int>& acting, int nrep)
 {
   // This implementation is broken for EC PGs since the osd may appear
@@ -1138,6 +1138,9 @@ public:
   uint64_t get_up_osd_features() const;
 
   void get_upmap_pgs(std::vector<pg_t> *upmap_pgs) const;
+  /// pgs with a pg_temp, primary_temp or upmap entry naming any of osds
+  void get_explicit_mapping_pgs(const std::set<int>& osds,
+				std::set<pg_t> *pgs) const;
   bool check_pg_upmaps(
     CephContext *cct,
     const std::vector<pg_t>& to_check,
@@ -1315,6 +1318,16 @@ public:
     int up_primary, acting_primary;
     pg_to_up_acting_osds(pg, &up, &up_primary, &acting, &acting_primary);
   }
+  /**
+   * map pgs [ps_begin, ps_end) of a pool to their up and acting sets,
+   * running CRUSH for the whole range on one workspace.  Entry i of each
+   * output is what pg_to_up_acting_osds() returns for ps_begin + i.
+   */
+  void pg_range_to_up_acting_osds(
+    int64_t pool, unsigned ps_begin, unsigned ps_end,
+    std::vector<std::vector<int>> *up, std::vector<int> *up_primary,
+    std::vector<std::vector<int>> *acting,
+    std::vector<int> *acting_primary) const;
   bool pg_is_ec(pg_t pg) const {
     auto i = pools.find(pg.pool());
     ceph_assert(i != pools.end());
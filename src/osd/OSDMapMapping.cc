@@ -1,6 +1,8 @@
 // -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
 // vim: ts=8 sw=2 sts=2 expandtab
 
+#include <algorithm>
+
 #include "OSDMapMapping.h"
 #include "OSDMap.h"
 
@@ -55,11 +57,227 @@ void OSDMapMapping::update(const OSDMap& osdmap)
   //_dump();  // for debugging
 }
 
+void OSDMapMapping::update(const OSDMap& osdmap, const Delta& delta)
+{
+  if (!can_apply(osdmap, delta)) {
+    update(osdmap);
+    return;
+  }
+  vector<pg_t> pgs;
+  bool rebuild_rmap;
+  _get_delta_pgs(osdmap, delta, &pgs, &rebuild_rmap);
+  _start(osdmap, pgs, rebuild_rmap);
+  _update_pgs(osdmap, pgs);
+  _finish(osdmap, pgs, rebuild_rmap);
+}
+
 void OSDMapMapping::update(const OSDMap& osdmap, pg_t pgid)
 {
   _update_range(osdmap, pgid.pool(), pgid.ps(), pgid.ps() + 1);
 }
 
+std::unique_ptr<OSDMapMapping::MappingJob> OSDMapMapping::start_update(
+  const OSDMap& map,
+  ParallelPGMapper& mapper,
+  unsigned pgs_per_item,
+  const Delta& delta)
+{
+  if (!can_apply(map, delta)) {
+    return start_update(map, mapper, pgs_per_item);
+  }
+  vector<pg_t> pgs;
+  bool rebuild_rmap;
+  _get_delta_pgs(map, delta, &pgs, &rebuild_rmap);
+  std::unique_ptr<MappingJob> job(
+    new MappingJob(&map, this, std::move(pgs), rebuild_rmap));
+  if (job->pgs.empty()) {
+    // nothing could have moved; just catch up the epoch
+    job->finish = ceph_clock_now();
+    job->complete();
+  } else {
+    mapper.queue(job.get(), pgs_per_item, job->pgs);
+  }
+  return job;
+}
+
+void OSDMapMapping::Delta::note_incremental(
+  const OSDMap& prev,
+  const OSDMap::Incremental& inc)
+{
+  if (full) {
+    return;
+  }
+  if (prev.get_epoch() != last || inc.epoch != last + 1) {
+    full = true;
+    return;
+  }
+  last = inc.epoch;
+  if (inc.fullmap.length() ||
+      inc.crush.length() ||
+      inc.new_max_osd >= 0) {
+    full = true;
+    return;
+  }
+  for (auto& p : inc.new_pools) {
+    pools.insert(p.first);
+  }
+  for (auto pool : inc.old_pools) {
+    pools.insert(pool);
+  }
+  for (auto& [osd, state] : inc.new_state) {
+    // a plain mark-down leaves the crush output alone; only pgs already
+    // mapped to the osd can change.
+    int s = state ? state : CEPH_OSD_UP;
+    if (s == CEPH_OSD_UP && prev.is_up(osd)) {
+      touched_osds.insert(osd);
+    } else {
+      osds.insert(osd);
+    }
+  }
+  for (auto& p : inc.new_up_client) {
+    osds.insert(p.first);
+  }
+  for (auto& p : inc.new_weight) {
+    osds.insert(p.first);
+  }
+  for (auto& p : inc.new_primary_affinity) {
+    touched_osds.insert(p.first);
+  }
+  for (auto& p : inc.new_pg_temp) {
+    pgs.insert(p.first);
+  }
+  for (auto& p : inc.new_primary_temp) {
+    pgs.insert(p.first);
+  }
+  for (auto& p : inc.new_pg_upmap) {
+    pgs.insert(p.first);
+  }
+  for (auto& p : inc.new_pg_upmap_items) {
+    pgs.insert(p.first);
+  }
+  for (auto& p : inc.new_pg_upmap_primary) {
+    pgs.insert(p.first);
+  }
+  pgs.insert(inc.old_pg_upmap.begin(), inc.old_pg_upmap.end());
+  pgs.insert(inc.old_pg_upmap_items.begin(), inc.old_pg_upmap_items.end());
+  pgs.insert(inc.old_pg_upmap_primary.begin(), inc.old_pg_upmap_primary.end());
+}
+
+void OSDMapMapping::_get_delta_pgs(
+  const OSDMap& osdmap,
+  const Delta& delta,
+  vector<pg_t> *pgs,
+  bool *rebuild_rmap) const
+{
+  // pools we remap in full
+  std::set<int64_t> whole;
+  for (auto pool : delta.pools) {
+    if (osdmap.have_pg_pool(pool)) {
+      whole.insert(pool);
+    }
+  }
+
+  // a weight or existence change can move pgs anywhere under the
+  // rule's take roots, so remap every pool whose rule reaches the osd.
+  if (!delta.osds.empty()) {
+    std::map<int,bool> reaches;  // take root -> contains a changed osd
+    for (auto& [poolid, pool] : osdmap.get_pools()) {
+      if (whole.count(poolid)) {
+	continue;
+      }
+      std::set<int> roots;
+      osdmap.crush->find_takes_by_rule(pool.get_crush_rule(), &roots);
+      for (auto root : roots) {
+	auto r = reaches.find(root);
+	if (r == reaches.end()) {
+	  bool any = false;
+	  if (root >= 0) {
+	    any = delta.osds.count(root);
+	  } else {
+	    const char *name = osdmap.crush->get_item_name(root);
+	    std::set<int> leaves;
+	    if (!name || osdmap.crush->get_leaves(name, &leaves) < 0) {
+	      any = true;
+	    }
+	    for (auto osd : delta.osds) {
+	      if (any || leaves.count(osd)) {
+		any = true;
+		break;
+	      }
+	    }
+	  }
+	  r = reaches.emplace(root, any).first;
+	}
+	if (r->second) {
+	  whole.insert(poolid);
+	  break;
+	}
+      }
+    }
+  }
+
+  std::set<pg_t> some;
+  for (auto& pgid : delta.pgs) {
+    if (!whole.count(pgid.pool())) {
+      some.insert(pgid);
+    }
+  }
+
+  // anything already mapped to, or explicitly mapped to, a changed osd
+  std::set<int> refs(delta.osds);
+  refs.insert(delta.touched_osds.begin(), delta.touched_osds.end());
+  if (!refs.empty()) {
+    osdmap.get_explicit_mapping_pgs(refs, &some);
+    vector<bool> is_ref(osdmap.get_max_osd());
+    for (auto osd : refs) {
+      if (osd >= 0 && osd < (int)is_ref.size()) {
+	is_ref[osd] = true;
+      }
+    }
+    auto ref = [&is_ref](int32_t osd) {
+      return osd >= 0 && osd < (int)is_ref.size() && is_ref[osd];
+    };
+    for (auto& [poolid, pm] : pools) {
+      if (whole.count(poolid) || !osdmap.have_pg_pool(poolid)) {
+	continue;
+      }
+      for (unsigned ps = 0; ps < pm.pg_num; ++ps) {
+	const int32_t *row = &pm.table[pm.row_size() * ps];
+	bool hit = ref(row[0]) || ref(row[1]);
+	for (int i = 0; !hit && i < row[2]; ++i) {
+	  hit = ref(row[4 + i]);
+	}
+	for (int i = 0; !hit && i < row[3]; ++i) {
+	  hit = ref(row[4 + pm.size + i]);
+	}
+	if (hit) {
+	  some.insert(pg_t(ps, poolid));
+	}
+      }
+    }
+  }
+
+  pgs->clear();
+  for (auto poolid : whole) {
+    unsigned pg_num = osdmap.get_pg_pool(poolid)->get_pg_num();
+    for (unsigned ps = 0; ps < pg_num; ++ps) {
+      pgs->push_back(pg_t(ps, poolid));
+    }
+  }
+  for (auto& pgid : some) {
+    auto pi = osdmap.get_pg_pool(pgid.pool());
+    if (whole.count(pgid.pool()) || !pi || pgid.ps() >= pi->get_pg_num()) {
+      continue;
+    }
+    pgs->push_back(pgid);
+  }
+  std::sort(pgs->begin(), pgs->end());
+
+  // pool changes may resize tables, and picking a large number of pgs
+  // out of the rmap costs more than rebuilding it.
+  *rebuild_rmap = !delta.pools.empty() || pgs->size() > num_pgs / 4;
+}
+
 void OSDMapMapping::_build_rmap(const OSDMap& osdmap)
 {
   acting_rmap.resize(osdmap.get_max_osd());
@@ -87,12 +305,58 @@ void OSDMapMapping::_build_rmap(const OSDMap& osdmap)
   }
 }
 
+void OSDMapMapping::_remove_rmap(const vector<pg_t>& pgs)
+{
+  std::map<int,std::set<pg_t>> stale;
+  vector<int> acting;
+  for (auto& pgid : pgs) {
+    get(pgid, nullptr, nullptr, &acting, nullptr);
+    for (auto osd : acting) {
+      if (osd != CRUSH_ITEM_NONE) {
+	stale[osd].insert(pgid);
+      }
+    }
+  }
+  for (auto& [osd, s] : stale) {
+    auto& v = acting_rmap[osd];
+    v.erase(std::remove_if(v.begin(), v.end(),
+			   [&s](const pg_t& pgid) { return s.count(pgid); }),
+	    v.end());
+  }
+}
+
+void OSDMapMapping::_add_rmap(const vector<pg_t>& pgs)
+{
+  vector<int> acting;
+  for (auto& pgid : pgs) {
+    get(pgid, nullptr, nullptr, &acting, nullptr);
+    for (auto osd : acting) {
+      if (osd != CRUSH_ITEM_NONE) {
+	acting_rmap[osd].push_back(pgid);
+      }
+    }
+  }
+}
+
 void OSDMapMapping::_finish(const OSDMap& osdmap)
 {
   _build_rmap(osdmap);
   epoch = osdmap.get_epoch();
 }
 
+void OSDMapMapping::_finish(
+  const OSDMap& osdmap,
+  const vector<pg_t>& pgs,
+  bool rebuild_rmap)
+{
+  if (rebuild_rmap) {
+    _build_rmap(osdmap);
+  } else {
+    _add_rmap(pgs);
+  }
+  epoch = osdmap.get_epoch();
+}
+
 void OSDMapMapping::_dump()
 {
   for (auto& p : pools) {
@@ -115,14 +379,33 @@ void OSDMapMapping::_update_range(
   ceph_assert(i != pools.end());
   ceph_assert(pg_begin <= pg_end);
   ceph_assert(pg_end <= i->second.pg_num);
+  std::vector<std::vector<int>> up, acting;
+  std::vector<int> up_primary, acting_primary;
+  osdmap.pg_range_to_up_acting_osds(
+    pool, pg_begin, pg_end,
+    &up, &up_primary, &acting, &acting_primary);
   for (unsigned ps = pg_begin; ps < pg_end; ++ps) {
-    std::vector<int> up, acting;
-    int up_primary, acting_primary;
-    osdmap.pg_to_up_acting_osds(
-      pg_t(ps, pool),
-      &up, &up_primary, &acting, &acting_primary);
-    i->second.set(ps, std::move(up), up_primary,
-		  std::move(acting), acting_primary);
+    unsigned j = ps - pg_begin;
+    i->second.set(ps, std::move(up[j]), up_primary[j],
+		  std::move(acting[j]), acting_primary[j]);
+  }
+}
+
+void OSDMapMapping::_update_pgs(
+  const OSDMap& osdmap,
+  const vector<pg_t>& pgs)
+{
+  // pgs are sorted; remap each run of consecutive ps in one go
+  auto p = pgs.begin();
+  while (p != pgs.end()) {
+    auto q = p + 1;
+    while (q != pgs.end() &&
+	   q->pool() == p->pool() &&
+	   q->ps() == (q - 1)->ps() + 1) {
+      ++q;
+    }
+    _update_range(osdmap, p->pool(), p->ps(), (q - 1)->ps() + 1);
+    p = q;
   }
 }
 
@@ -7,14 +7,14 @@
 
 #include <vector>
 #include <map>
+#include <set>
 
 #include "osd/osd_types.h"
+#include "osd/OSDMap.h"
 #include "common/WorkQueue.h"
 #include "common/Clock.h" // for ceph_clock_now()
 #include "common/Cond.h"
 
-class OSDMap;
-
 /// work queue to perform work on batches of pgids on multiple CPUs
 class ParallelPGMapper {
 public:
@@ -176,6 +176,41 @@ public:
 class OSDMapMapping {
 public:
   MEMPOOL_CLASS_HELPERS();
+
+  /**
+   * Delta - what a run of incrementals could have moved
+   *
+   * Accumulated from each OSDMap::Incremental as it is applied, starting
+   * at the epoch the mapping was last computed for.  start_update() uses
+   * it to remap only the pgs that may have changed.  Anything we cannot
+   * reason about (new crush map, max_osd change, a gap in the epochs)
+   * sets full and falls back to remapping everything.
+   */
+  struct Delta {
+    epoch_t base = 0;         ///< epoch the delta applies on top of
+    epoch_t last = 0;         ///< epoch of the last incremental noted
+    bool full = true;         ///< remap everything
+    std::set<int64_t> pools;  ///< pools created, changed or removed
+    std::set<int> osds;       ///< osds whose crush placement may change
+    std::set<int> touched_osds; ///< osds whose existing pgs may change
+    std::set<pg_t> pgs;       ///< pgs with changed temp or upmap entries
+
+    void reset(epoch_t e) {
+      base = last = e;
+      full = false;
+      pools.clear();
+      osds.clear();
+      touched_osds.clear();
+      pgs.clear();
+    }
+    bool empty() const {
+      return !full && pools.empty() && osds.empty() &&
+	touched_osds.empty() && pgs.empty();
+    }
+    /// note inc, which is about to be applied on top of prev
+    void note_incremental(const OSDMap& prev, const OSDMap::Incremental& inc);
+  };
+
 private:
 
   struct PoolMapping {
@@ -264,12 +299,28 @@ private:
     int64_t pool,
     unsigned pg_begin, unsigned pg_end);
 
+  void _update_pgs(const OSDMap& map, const std::vector<pg_t>& pgs);
+
   void _build_rmap(const OSDMap& osdmap);
+  void _remove_rmap(const std::vector<pg_t>& pgs);
+  void _add_rmap(const std::vector<pg_t>& pgs);
+
+  void _get_delta_pgs(const OSDMap& osdmap, const Delta& delta,
+		      std::vector<pg_t> *pgs, bool *rebuild_rmap) const;
 
   void _start(const OSDMap& osdmap) {
     _init_mappings(osdmap);
   }
+  void _start(const OSDMap& osdmap, const std::vector<pg_t>& pgs,
+	      bool rebuild_rmap) {
+    if (!rebuild_rmap) {
+      _remove_rmap(pgs);
+    }
+    _init_mappings(osdmap);
+  }
   void _finish(const OSDMap& osdmap);
+  void _finish(const OSDMap& osdmap, const std::vector<pg_t>& pgs,
+	       bool rebuild_rmap);
 
   void _dump();
 
@@ -277,21 +328,37 @@ private:
 
   struct MappingJob : public ParallelPGMapper::Job {
     OSDMapMapping *mapping;
+    bool incremental = false;
+    bool rebuild_rmap = true;
+    std::vector<pg_t> pgs;  ///< pgs to remap if incremental
     MappingJob(const OSDMap *osdmap, OSDMapMapping *m)
       : Job(osdmap), mapping(m) {
       mapping->_start(*osdmap);
     }
-    void process(const std::vector<pg_t>& pgs) override {}
+    MappingJob(const OSDMap *osdmap, OSDMapMapping *m,
+	       std::vector<pg_t>&& p, bool rebuild)
+      : Job(osdmap), mapping(m), incremental(true), rebuild_rmap(rebuild),
+	pgs(std::move(p)) {
+      mapping->_start(*osdmap, pgs, rebuild_rmap);
+    }
+    void process(const std::vector<pg_t>& pgs) override {
+      mapping->_update_pgs(*osdmap, pgs);
+    }
     void process(int64_t pool, unsigned ps_begin, unsigned ps_end) override {
       mapping->_update_range(*osdmap, pool, ps_begin, ps_end);
     }
     void complete() override {
-      mapping->_finish(*osdmap);
+      if (incremental) {
+	mapping->_finish(*osdmap, pgs, rebuild_rmap);
+      } else {
+	mapping->_finish(*osdmap);
+      }
     }
   };
   friend class OSDMapTest;
   // for testing only
   void update(const OSDMap& map);
+  void update(const OSDMap& map, const Delta& delta);
 
 public:
   void get(pg_t pgid,
@@ -343,6 +410,22 @@ public:
     return job;
   }
 
+  /// remap only what delta says may have moved, if it applies to us
+  std::unique_ptr<MappingJob> start_update(
+    const OSDMap& map,
+    ParallelPGMapper& mapper,
+    unsigned pgs_per_item,
+    const Delta& delta);
+
+  /// true if delta can bring this mapping up to date with map
+  bool can_apply(const OSDMap& map, const Delta& delta) const {
+    return !delta.full &&
+      epoch > 0 &&
+      delta.base == epoch &&
+      delta.last == map.get_epoch() &&
+      acting_rmap.size() == (size_t)map.get_max_osd();
+  }
+
   epoch_t get_epoch() const {
     return epoch;
   }
@@ -808,6 +808,17 @@ PGBackend *PGBackend::build_pg_backend(
   }
 }
 
+uint64_t PGBackend::get_deep_scrub_stride(CephContext *cct, ObjectStore *store)
+{
+  if (store->is_rotational()) {
+    auto stride = cct->_conf.get_val<Option::size_t>("osd_deep_scrub_stride_hdd");
+    if (stride > 0) {
+      return stride;
+    }
+  }
+  return cct->_conf->osd_deep_scrub_stride;
+}
+
 int PGBackend::be_scan_list(
   const Scrub::ScrubCounterSet& io_counters,
   ScrubMap &map,
@@ -628,6 +628,10 @@ typedef std::shared_ptr<const OSDMap> OSDMapRef;
                                        shard_id_t shard_id,
                                        bool object_is_legacy_ec) const = 0;
 
+   /// bytes to read per deep scrub step on this store: osd_deep_scrub_stride,
+   /// unless the store is rotational and osd_deep_scrub_stride_hdd is set
+   static uint64_t get_deep_scrub_stride(CephContext *cct, ObjectStore *store);
+
    virtual int be_deep_scrub(
      [[maybe_unused]] const Scrub::ScrubCounterSet& io_counters,
      const hobject_t &oid,
@@ -25,6 +25,7 @@
 #include "osd_types.h"
 #include "os/ObjectStore.h"
 
+#include <functional>
 #include <iosfwd>
 #include <map>
 #include <memory>
@@ -167,7 +168,14 @@ public:
    * plus some methods to manipulate it all.
    */
   struct IndexedLog : public pg_log_t {
-    mutable std::unordered_map<hobject_t, pg_log_entry_t*> objects;  // ptrs into log.  be careful!
+    /// keyed by reference to the soid of the entry each slot points to,
+    /// so an indexed object costs a pointer rather than a copy of its
+    /// hobject_t.  Update it only through index_object(), which keeps
+    /// the key and the entry it lives in together.
+    using object_index_t = std::unordered_map<
+      std::reference_wrapper<const hobject_t>, pg_log_entry_t*,
+      std::hash<hobject_t>, std::equal_to<hobject_t>>;
+    mutable object_index_t objects;  // ptrs into log.  be careful!
     mutable std::unordered_map<osd_reqid_t, pg_log_entry_t*> caller_ops;
     mutable std::unordered_multimap<osd_reqid_t, pg_log_entry_t*> extra_caller_ops;
     mutable std::unordered_map<osd_reqid_t, pg_log_dup_t*> dup_index;
@@ -526,19 +534,25 @@ public:
 	}
       }
 
+      if (to_index & PGLOG_INDEXED_OBJECTS) {
+	// newest first, so that each object is inserted exactly once
+	for (auto i = log.rbegin(); i != log.rend(); ++i) {
+	  if (i->object_is_indexed()) {
+	    auto [it, inserted] = objects.emplace(
+	      i->soid, const_cast<pg_log_entry_t*>(&(*i)));
+	    if (inserted) {
+	      check_object_key(it);
+	    }
+	  }
+	}
+      }
+
       constexpr __u16 any_log_entry_index =
-	PGLOG_INDEXED_OBJECTS |
 	PGLOG_INDEXED_CALLER_OPS |
 	PGLOG_INDEXED_EXTRA_CALLER_OPS;
 
       if (to_index & any_log_entry_index) {
 	for (auto i = log.begin(); i != log.end(); ++i) {
-	  if (to_index & PGLOG_INDEXED_OBJECTS) {
-	    if (i->object_is_indexed()) {
-	      objects[i->soid] = const_cast<pg_log_entry_t*>(&(*i));
-	    }
-	  }
-
 	  if (to_index & PGLOG_INDEXED_CALLER_OPS) {
 	    if (i->reqid_is_indexed()) {
 	      caller_ops[i->reqid] = const_cast<pg_log_entry_t*>(&(*i));
@@ -575,11 +589,38 @@ public:
       index(PGLOG_INDEXED_DUPS);
     }
 
+    /// each key must be the soid of the entry it maps to; an entry
+    /// trimmed, split off or moved without being unindexed first would
+    /// leave a dangling key behind.  checked in debug builds only.
+    static void check_object_key(object_index_t::const_iterator it) {
+#ifndef NDEBUG
+      ceph_assert(&it->first.get() == &it->second->soid);
+#endif
+    }
+
+    void index_object(pg_log_entry_t *e) const {
+      auto it = objects.find(e->soid);
+      if (it == objects.end()) {
+	check_object_key(objects.emplace(e->soid, e).first);
+	return;
+      }
+      check_object_key(it);
+      // the old key lives in the entry being replaced; repoint it at
+      // the new one so it cannot dangle once the old entry is trimmed
+      auto node = objects.extract(it);
+      node.key() = std::cref(e->soid);
+      node.mapped() = e;
+      check_object_key(objects.insert(std::move(node)).position);
+    }
+
     void index(pg_log_entry_t& e) {
       if ((indexed_data & PGLOG_INDEXED_OBJECTS) && e.object_is_indexed()) {
-        if (objects.count(e.soid) == 0 ||
-            objects[e.soid]->version < e.version)
-          objects[e.soid] = &e;
+	auto it = objects.find(e.soid);
+	if (it != objects.end()) {
+	  check_object_key(it);
+	}
+	if (it == objects.end() || it->second->version < e.version)
+	  index_object(&e);
       }
       if (indexed_data & PGLOG_INDEXED_CALLER_OPS) {
 	// divergent merge_log indexes new before unindexing old
@@ -608,8 +649,11 @@ public:
       // NOTE: this only works if we remove from the _tail_ of the log!
       if (indexed_data & PGLOG_INDEXED_OBJECTS) {
 	auto it = objects.find(e.soid);
-        if (it != objects.end() && it->second->version == e.version)
-          objects.erase(it);
+	if (it != objects.end()) {
+	  check_object_key(it);
+	  if (it->second->version == e.version)
+	    objects.erase(it);
+	}
       }
       if (e.reqid_is_indexed()) {
         if (indexed_data & PGLOG_INDEXED_CALLER_OPS) {
@@ -676,7 +720,7 @@ public:
 
       // to our index
       if ((indexed_data & PGLOG_INDEXED_OBJECTS) && e.object_is_indexed()) {
-        objects[e.soid] = &(log.back());
+        index_object(&(log.back()));
       }
       if (indexed_data & PGLOG_INDEXED_CALLER_OPS) {
         if (e.reqid_is_indexed()) {
@@ -797,16 +797,18 @@ int ReplicatedBackend::be_deep_scrub(
       pos.data_hash = bufferhash(-1);
     }
 
-    const uint64_t stride = cct->_conf->osd_deep_scrub_stride;
+    const uint64_t stride = get_deep_scrub_stride(cct, store);
 
     perf_logger.inc(io_counters.read_cnt);
-    bufferlist bl;
-    r = store->read(
+    // the store digests the data as it checks it against its own
+    // checksums, without handing us the bytes
+    uint32_t digest = pos.data_hash.digest();
+    r = store->verify_object_checksums(
       ch,
       ghobject_t(
 	poid, ghobject_t::NO_GEN, get_parent()->whoami_shard().shard),
       pos.data_pos,
-      stride, bl,
+      stride, &digest,
       scrub_fadvise_flags);
     if (r < 0) {
       dout(20) << __func__ << "  " << poid << " got "
@@ -814,9 +816,7 @@ int ReplicatedBackend::be_deep_scrub(
       o.read_error = true;
       return 0;
     }
-    if (r > 0) {
-      pos.data_hash << bl;
-    }
+    pos.data_hash = bufferhash(digest);
     perf_logger.inc(io_counters.read_bytes, r);
     pos.data_pos += r;
     if (static_cast<uint64_t>(r) == stride) {
@@ -325,6 +325,20 @@ PerfCounters *build_osd_logger(CephContext *cct) {
   osd_plb.add_u64_counter(
     l_osd_object_ctx_cache_total, "object_ctx_cache_total", "Object context cache lookups");
 
+  osd_plb.add_u64_counter(
+    l_osd_ec_cache_hit, "ec_extent_cache_hit",
+    "EC extent cache lines found in the LRU");
+  osd_plb.add_u64_counter(
+    l_osd_ec_cache_hit_bytes, "ec_extent_cache_hit_bytes",
+    "Bytes of EC extent cache lines found in the LRU",
+    NULL, 0, unit_t(UNIT_BYTES));
+  osd_plb.add_u64_counter(
+    l_osd_ec_cache_miss, "ec_extent_cache_miss",
+    "EC extent cache lines not found in the LRU");
+  osd_plb.add_u64_counter(
+    l_osd_ec_cache_evict, "ec_extent_cache_evict",
+    "EC extent cache lines evicted from the LRU");
+
   osd_plb.add_u64_counter(l_osd_op_cache_hit, "op_cache_hit");
   osd_plb.add_time_avg(
     l_osd_tier_flush_lat, "osd_tier_flush_lat", "Object flush latency");
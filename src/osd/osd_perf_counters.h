@@ -130,6 +130,11 @@ enum osd_counter_idx_t {
   l_osd_object_ctx_cache_hit,
   l_osd_object_ctx_cache_total,
 
+  l_osd_ec_cache_hit,
+  l_osd_ec_cache_hit_bytes,
+  l_osd_ec_cache_miss,
+  l_osd_ec_cache_evict,
+
   l_osd_op_cache_hit,
   l_osd_tier_flush_lat,
   l_osd_tier_promote_lat,
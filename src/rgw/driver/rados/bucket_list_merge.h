@@ -0,0 +1,323 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cls/rgw/cls_rgw_ops.h"
+
+/// Ordered merge of the listings of a sharded bucket index.
+namespace rgwrados::bucket_list {
+
+/// Interface for ShardMerge to read bucket index shards asynchronously.
+///
+/// \see RadosShardReader in rgw_rados.cc
+class ShardReader {
+ public:
+  virtual ~ShardReader() {}
+
+  /// Start reading up to num_entries entries that follow marker in the
+  /// given shard into *result. ShardMerge has at most one read per shard
+  /// in flight, and keeps *result in place until it completes.
+  virtual void read(int shard, const cls_rgw_obj_key& marker,
+                    uint32_t num_entries, rgw_cls_list_ret* result) = 0;
+
+  /// Wait until at least one started read completes, and return the
+  /// shards whose reads completed in 'completed'. Returns a negative error
+  /// code if any of them failed.
+  virtual int wait(std::vector<int>& completed) = 0;
+
+  /// Wait for all started reads and discard their results.
+  virtual void drain() = 0;
+};
+
+/// Merges the entries of several bucket index shards in name order.
+///
+/// Each shard is first read with the same small read size. As the merge
+/// consumes a shard, its next read is started in the background once a
+/// quarter of its last read is left, with twice the size of that read.
+/// Shards whose entries are consumed quickly thus get larger reads, idle
+/// shards are not over-fetched, and the reads of different shards
+/// overlap with each other and with the caller's processing. The merge
+/// only blocks when the shard it needs next has no entries in memory.
+///
+/// Every completed read is kept unmodified until the ShardMerge is
+/// destroyed, so references to names and entries stay valid.
+class ShardMerge {
+ public:
+  /// num_entries caps the size of a single read; max_refills caps the
+  /// reads of each shard after the first one
+  ShardMerge(ShardReader& reader, uint32_t num_entries,
+             uint32_t max_refills = 16)
+    : reader(reader), num_entries(num_entries), max_refills(max_refills)
+  {}
+
+  ~ShardMerge() {
+    if (outstanding > 0) {
+      // completions must not write into our shards once we are gone
+      reader.drain();
+    }
+  }
+
+  ShardMerge(const ShardMerge&) = delete;
+  ShardMerge& operator=(const ShardMerge&) = delete;
+
+  /// Read the first read_size entries after start_after from each of the
+  /// shards and wait for them.
+  int start(const std::vector<int>& ids, const cls_rgw_obj_key& start_after,
+            uint32_t read_size) {
+    shards.reserve(ids.size()); // never reallocated; reads point into it
+    for (int id : ids) {
+      index[id] = shards.size();
+      shards.emplace_back(id);
+    }
+    for (auto& s : shards) {
+      issue(s, start_after, read_size);
+    }
+    for (auto& s : shards) {
+      int r = wait_for(s);
+      if (r < 0) {
+        return r;
+      }
+    }
+    // shards whose first read was filtered away entirely need more
+    for (auto& s : shards) {
+      int r = ensure_entries(s, true);
+      if (r < 0) {
+        return r;
+      }
+    }
+    for (size_t i = 0; i < shards.size(); ++i) {
+      push_candidate(i);
+    }
+    return 0;
+  }
+
+  /// Whether all entries were consumed or the merge had to stop because
+  /// a truncated shard ran out of entries and could not be read further.
+  bool empty() const {
+    return stopped || candidates.empty();
+  }
+
+  /// The lowest entry not yet consumed, and the shard it comes from;
+  /// only valid when !empty().
+  const std::string& name() const {
+    return *candidates.top().first;
+  }
+  rgw_bucket_dir_entry& dir_entry() {
+    return shards[candidates.top().second].cursor->second;
+  }
+  int shard() const {
+    return shards[candidates.top().second].id;
+  }
+
+  /// Consume the current entry from every shard positioned at its name,
+  /// as the same name (e.g., a common prefix) may come from several
+  /// shards. When more is false the caller is done, so no further reads
+  /// are started.
+  int pop(bool more) {
+    const std::string& current = name();
+    matches.clear();
+    while (!candidates.empty() && *candidates.top().first == current) {
+      matches.push_back(candidates.top().second);
+      candidates.pop();
+    }
+    for (size_t i : matches) {
+      auto& s = shards[i];
+      s.advance();
+      int r = ensure_entries(s, more);
+      if (r < 0) {
+        return r;
+      }
+      if (s.at_end() && s.is_truncated()) {
+        // we cannot be certain that the next entry would not come from
+        // this shard; S3 and swift allow returning fewer than requested
+        stopped = true;
+      }
+      if (more) {
+        maybe_prefetch(s);
+      }
+      push_candidate(i);
+    }
+    return 0;
+  }
+
+  /// Whether any shard has entries left, in memory or in the index.
+  bool is_truncated() const {
+    return std::any_of(shards.begin(), shards.end(), [] (const Shard& s) {
+        return !s.at_end() || s.is_truncated();
+      });
+  }
+
+  /// Whether all reads were filtered by cls.
+  bool cls_filtered() const {
+    return filtered;
+  }
+
+  /// The number of reads issued, for logging.
+  uint32_t reads_issued() const {
+    return reads;
+  }
+
+ private:
+  using entry_map = decltype(rgw_bucket_dir::m);
+
+  struct Shard {
+    const int id;
+    std::deque<rgw_cls_list_ret> results; // completed reads, oldest first
+    rgw_cls_list_ret next;                // target of the read in flight
+    size_t chunk = 0;                     // result the cursor is in
+    entry_map::iterator cursor;
+    size_t remaining = 0;  // entries in memory not yet consumed
+    uint32_t read_size = 0; // entries requested by the last read
+    uint32_t refills = 0;
+    bool reading = false;
+
+    explicit Shard(int id) : id(id) {}
+
+    bool at_end() const {
+      return results.empty() ||
+        (chunk + 1 == results.size() &&
+         cursor == results.back().dir.m.end());
+    }
+    bool is_truncated() const {
+      return results.empty() || results.back().is_truncated;
+    }
+    void advance() {
+      ++cursor;
+      --remaining;
+      skip_empty();
+    }
+    // move the cursor past consumed and empty results
+    void skip_empty() {
+      while (cursor == results[chunk].dir.m.end() &&
+             chunk + 1 < results.size()) {
+        ++chunk;
+        cursor = results[chunk].dir.m.begin();
+      }
+    }
+    void complete() {
+      const bool first = results.empty();
+      results.push_back(std::move(next));
+      next = rgw_cls_list_ret();
+      reading = false;
+      remaining += results.back().dir.m.size();
+      if (first) {
+        cursor = results.front().dir.m.begin();
+      }
+      skip_empty();
+    }
+  };
+
+  ShardReader& reader;
+  const uint32_t num_entries;
+  const uint32_t max_refills;
+  std::vector<Shard> shards;
+  std::map<int, size_t> index; // shard id -> position in shards
+  uint32_t outstanding = 0;
+  uint32_t reads = 0;
+  bool filtered = true;
+  bool stopped = false;
+
+  // min-heap of the next entry of each shard that has one, as
+  // (name, position in shards)
+  using Candidate = std::pair<const std::string*, size_t>;
+  struct CandidateAfter {
+    bool operator()(const Candidate& l, const Candidate& r) const {
+      const int c = l.first->compare(*r.first);
+      return c > 0 || (c == 0 && l.second > r.second);
+    }
+  };
+  std::priority_queue<Candidate, std::vector<Candidate>,
+                      CandidateAfter> candidates;
+  std::vector<size_t> matches;
+
+  void push_candidate(size_t i) {
+    if (!shards[i].at_end()) {
+      candidates.emplace(&shards[i].cursor->first, i);
+    }
+  }
+
+  void issue(Shard& s, const cls_rgw_obj_key& marker, uint32_t read_size) {
+    s.reading = true;
+    s.read_size = read_size;
+    ++outstanding;
+    ++reads;
+    reader.read(s.id, marker, read_size, &s.next);
+  }
+
+  bool can_refill(const Shard& s) const {
+    return !s.reading && s.is_truncated() && !s.results.back().marker.empty()
+      && s.refills < max_refills;
+  }
+
+  void refill(Shard& s) {
+    ++s.refills;
+    issue(s, s.results.back().marker,
+          std::min(num_entries, s.read_size * 2));
+  }
+
+  // start the next read of a shard early, once it is running low
+  void maybe_prefetch(Shard& s) {
+    if (can_refill(s) && s.remaining * 4 <= s.read_size) {
+      refill(s);
+    }
+  }
+
+  // reap completions until the shard's read is done
+  int wait_for(Shard& s) {
+    std::vector<int> completed;
+    while (s.reading) {
+      completed.clear();
+      int r = reader.wait(completed);
+      for (int id : completed) {
+        auto& c = shards[index.at(id)];
+        c.complete();
+        --outstanding;
+        filtered = filtered && c.results.back().cls_filtered;
+      }
+      if (r < 0) {
+        return r;
+      }
+    }
+    return 0;
+  }
+
+  // make sure a truncated shard has entries in memory, unless it cannot
+  // be read any further
+  int ensure_entries(Shard& s, bool more) {
+    while (more && s.at_end() && s.is_truncated()) {
+      if (!s.reading) {
+        if (!can_refill(s)) {
+          break;
+        }
+        refill(s);
+      }
+      int r = wait_for(s);
+      if (r < 0) {
+        return r;
+      }
+    }
+    return 0;
+  }
+}; // class ShardMerge
+
+} // namespace rgwrados::bucket_list
@@ -33,6 +33,7 @@
 #include "rgw_acl_s3.h" /* for dumping s3policy in debug log */
 #include "rgw_aio_throttle.h"
 #include "driver/rados/rgw_bucket.h"
+#include "driver/rados/bucket_list_merge.h"
 #include "rgw_rest_conn.h"
 #include "rgw_cr_rados.h"
 #include "rgw_cr_rest.h"
@@ -70,6 +71,7 @@
 #include <atomic>
 #include <list>
 #include <map>
+#include <queue>
 #include "include/random.h"
 
 #include "rgw_gc.h"
@@ -8200,6 +8202,27 @@ int RGWRados::Object::Read::read(int64_t ofs, int64_t end,
   return bl.length();
 }
 
+static void update_ewma(double& avg, double sample)
+{
+  avg = avg ? avg + (sample - avg) / 8 : sample;
+}
+
+void get_obj_data::update_window()
+{
+  if (!max_window || !min_latency || !drain_rate) {
+    return;
+  }
+  // data buffered behind a slower read counts against the budget too
+  const uint64_t budget = max_window > buffered ? max_window - buffered : 0;
+  const uint64_t target = std::clamp<uint64_t>(2 * drain_rate * min_latency,
+                                               min_window,
+                                               std::max(min_window, budget));
+  if (target != window) {
+    window = target;
+    aio->set_window(window);
+  }
+}
+
 int get_obj_data::flush(rgw::AioResultList&& results) {
   int r = rgw::check_for_errors(results);
   if (r < 0) {
@@ -8207,10 +8230,28 @@ int get_obj_data::flush(rgw::AioResultList&& results) {
   }
   std::list<bufferlist> bl_list;
 
+  if (max_window) {
+    const auto now = ceph::mono_clock::now();
+    for (const auto& result : results) {
+      buffered += result.data.length();
+      if (auto i = issued.find(result.id); i != issued.end()) {
+        // the lowest latency seen, as queueing in the osds grows with
+        // the window and must not feed back into it
+        const double lat =
+            std::chrono::duration<double>(now - i->second).count();
+        if (!min_latency || lat < min_latency) {
+          min_latency = lat;
+        }
+        issued.erase(i);
+      }
+    }
+  }
+
   auto cmp = [](const auto& lhs, const auto& rhs) { return lhs.id < rhs.id; };
   results.sort(cmp); // merge() requires results to be sorted first
   completed.merge(results, cmp); // merge results in sorted order
 
+  uint64_t flushed = 0;
   while (!completed.empty() && completed.front().id == offset) {
     auto bl = std::move(completed.front().data);
 
@@ -8220,6 +8261,7 @@ int get_obj_data::flush(rgw::AioResultList&& results) {
     if (r < 0) {
       return r;
     }
+    flushed += bl.length();
 
     if (rgwrados->get_use_datacache()) {
       const std::lock_guard l(d3n_get_data.d3n_lock);
@@ -8233,6 +8275,19 @@ int get_obj_data::flush(rgw::AioResultList&& results) {
     }
     completed.pop_front_and_dispose(std::default_delete<rgw::AioResultEntry>{});
   }
+  if (max_window && flushed) {
+    // handle_data() only copies into the socket buffer, so the client's
+    // rate is what we hand over per unit of wall clock time
+    const auto now = ceph::mono_clock::now();
+    const double elapsed =
+        std::chrono::duration<double>(now - last_drain).count();
+    if (elapsed > 0) {
+      update_ewma(drain_rate, flushed / elapsed);
+    }
+    last_drain = now;
+    buffered -= std::min(buffered, flushed);
+  }
+  update_window();
   return 0;
 }
 
@@ -8294,7 +8349,16 @@ int RGWRados::get_obj_iterate_cb(const DoutPrefixProvider *dpp,
   const uint64_t cost = len;
   const uint64_t id = obj_ofs; // use logical object offset for sorting replies
 
-  auto completed = d->aio->get(obj.obj, rgw::Aio::librados_op(obj.ioctx, std::move(op), d->yield), cost, id);
+  auto op_func = rgw::Aio::librados_op(obj.ioctx, std::move(op), d->yield);
+  if (d->max_window) {
+    // stamp the read when the throttle submits it, not while it waits
+    op_func = [d, id, f = std::move(op_func)] (rgw::Aio* aio,
+                                               rgw::AioResult& r) mutable {
+      d->read_issued(id);
+      std::move(f)(aio, r);
+    };
+  }
+  auto completed = d->aio->get(obj.obj, std::move(op_func), cost, id);
 
   return d->flush(std::move(completed));
 }
@@ -8309,6 +8373,7 @@ int RGWRados::Object::Read::iterate(const DoutPrefixProvider *dpp, int64_t ofs,
 
   auto aio = rgw::make_throttle(window_size, y);
   get_obj_data data(store, cb, &*aio, ofs, y);
+  data.set_adaptive_window(window_size, cct->_conf->rgw_get_obj_max_window_size);
 
   if (state.obj.empty()) {
     state.obj = source->get_obj();
@@ -10544,6 +10609,93 @@ uint32_t RGWRados::calc_ordered_bucket_list_per_shard(uint32_t num_entries,
 }
 
 
+// reads bucket index shards for ShardMerge through an rgw::Aio throttle, so
+// that the reads of different shards overlap with each other and with the
+// merge
+class RadosShardReader : public rgwrados::bucket_list::ShardReader {
+  librados::IoCtx& ioctx;
+  const std::map<int, std::string>& oids;
+  const std::string& prefix;
+  const std::string& delimiter;
+  const bool list_versions;
+  optional_yield y;
+  std::unique_ptr<rgw::Aio> aio;
+
+  struct Read {
+    rgw_cls_list_ret* result;
+    uint32_t num_entries;
+  };
+  std::map<int, Read> in_flight;
+  std::vector<int> completed; // reaped, but not yet returned by wait()
+  int error = 0;
+  bool draining = false;
+
+  void reap(rgw::AioResultList&& results) {
+    for (auto& e : results) {
+      const int shard = static_cast<int>(e.id);
+      auto i = in_flight.find(shard);
+      ceph_assert(i != in_flight.end());
+      const Read rd = i->second;
+      in_flight.erase(i);
+      if (e.result == RGWBIAdvanceAndRetryError && !draining) {
+	// cls made progress without finding entries to return; continue
+	// from the marker it returned
+	read(shard, rd.result->marker, rd.num_entries, rd.result);
+	continue;
+      }
+      if (e.result < 0 && error == 0) {
+	error = e.result;
+      }
+      completed.push_back(shard);
+    }
+  }
+
+ public:
+  RadosShardReader(librados::IoCtx& ioctx,
+		   const std::map<int, std::string>& oids,
+		   const std::string& prefix, const std::string& delimiter,
+		   bool list_versions, size_t max_aio, optional_yield y)
+    : ioctx(ioctx), oids(oids), prefix(prefix), delimiter(delimiter),
+      list_versions(list_versions), y(y),
+      aio(rgw::make_throttle(max_aio, y))
+  {}
+
+  ~RadosShardReader() override {
+    drain();
+  }
+
+  void read(int shard, const cls_rgw_obj_key& marker, uint32_t num_entries,
+	    rgw_cls_list_ret* result) override {
+    const cls_rgw_obj_key start = marker; // may refer into *result
+    *result = rgw_cls_list_ret();
+    librados::ObjectReadOperation op;
+    cls_rgw_bucket_list_op(op, start, prefix, delimiter, num_entries,
+			   list_versions, result);
+    in_flight[shard] = Read{result, num_entries};
+    rgw_raw_obj obj(rgw_pool(ioctx.get_pool_name()), oids.at(shard));
+    reap(aio->get(std::move(obj),
+		  rgw::Aio::librados_op(ioctx, std::move(op), y),
+		  1, shard));
+  }
+
+  int wait(std::vector<int>& out) override {
+    while (completed.empty() && !in_flight.empty()) {
+      reap(aio->wait());
+    }
+    out.swap(completed);
+    completed.clear();
+    return std::exchange(error, 0);
+  }
+
+  void drain() override {
+    draining = true;
+    while (!in_flight.empty()) {
+      reap(aio->drain());
+    }
+    completed.clear();
+  }
+}; // class RadosShardReader
+
 int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
                                       RGWBucketInfo& bucket_info,
                                       const rgw::bucket_index_layout_generation& idx_layout,
@@ -10638,11 +10790,16 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
   rgw_bucket_entry_ver index_ver;
   index_ver.pool = ioctx.get_id();
 
-  std::map<int, rgw_cls_list_ret> shard_list_results;
   cls_rgw_obj_key start_after_key(start_after.name, start_after.instance);
-  r = svc.bi_rados->list_objects(dpp, y, ioctx, shard_oids, start_after_key,
-                                 prefix, delimiter, num_entries_per_shard,
-                                 list_versions, shard_list_results);
+  RadosShardReader reader(ioctx, shard_oids, prefix, delimiter, list_versions,
+			  cct->_conf->rgw_bucket_index_max_aio, y);
+  rgwrados::bucket_list::ShardMerge merge(reader, num_entries);
+  std::vector<int> shard_ids;
+  shard_ids.reserve(shard_count);
+  for (const auto& [shard, oid] : shard_oids) {
+    shard_ids.push_back(shard);
+  }
+  r = merge.start(shard_ids, start_after_key, num_entries_per_shard);
   if (r < 0) {
     ldpp_dout(dpp, 0) << __func__ <<
       ": CLSRGWIssueBucketList for " << bucket_info.bucket <<
@@ -10650,104 +10807,19 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
     return r;
   }
 
-  // to manage the iterators through each shard's list results
-  struct ShardTracker {
-    const size_t shard_idx;
-    rgw_cls_list_ret& result;
-    const std::string& oid_name;
-    RGWRados::ent_map_t::iterator cursor;
-    RGWRados::ent_map_t::iterator end;
-
-    // manages an iterator through a shard and provides other
-    // accessors
-    ShardTracker(size_t _shard_idx,
-		 rgw_cls_list_ret& _result,
-		 const std::string& _oid_name):
-      shard_idx(_shard_idx),
-      result(_result),
-      oid_name(_oid_name),
-      cursor(_result.dir.m.begin()),
-      end(_result.dir.m.end())
-    {}
-
-    inline const std::string& entry_name() const {
-      return cursor->first;
-    }
-    rgw_bucket_dir_entry& dir_entry() const {
-      return cursor->second;
-    }
-    inline bool is_truncated() const {
-      return result.is_truncated;
-    }
-    inline ShardTracker& advance() {
-      ++cursor;
-      // return a self-reference to allow for chaining of calls, such
-      // as x.advance().at_end()
-      return *this;
-    }
-    inline bool at_end() const {
-      return cursor == end;
-    }
-  }; // ShardTracker
-
-  // add the next unique candidate, or return false if we reach the end
-  auto next_candidate = [] (CephContext *cct, ShardTracker& t,
-                            std::multimap<std::string, size_t>& candidates,
-                            size_t tracker_idx) {
-    if (!t.at_end()) {
-      candidates.emplace(t.entry_name(), tracker_idx);
-    }
-    return;
-  };
-
-  // one tracker per shard requested (may not be all shards)
-  std::vector<ShardTracker> results_trackers;
-  results_trackers.reserve(shard_list_results.size());
-  for (auto& r : shard_list_results) {
-    results_trackers.emplace_back(r.first, r.second, shard_oids[r.first]);
-
-    // if any *one* shard's result is truncated, the entire result is
-    // truncated
-    *is_truncated = *is_truncated || r.second.is_truncated;
-
-    // unless *all* are shards are cls_filtered, the entire result is
-    // not filtered
-    *cls_filtered = *cls_filtered && r.second.cls_filtered;
-  }
-
-  // create a map to track the next candidate entry from ShardTracker
-  // (key=candidate, value=index into results_trackers); as we consume
-  // entries from shards, we replace them with the next entries in the
-  // shards until we run out
-  std::multimap<std::string, size_t> candidates;
-  size_t tracker_idx = 0;
-  std::vector<size_t> vidx;
-  vidx.reserve(shard_list_results.size());
-  for (auto& t : results_trackers) {
-    // it's important that the values in the map refer to the index
-    // into the results_trackers vector, which may not be the same
-    // as the shard number (i.e., when not all shards are requested)
-    next_candidate(cct, t, candidates, tracker_idx);
-    ++tracker_idx;
-  }
-
   rgw_bucket_dir_entry*
     last_entry_visited = nullptr; // to set last_entry (marker)
   std::map<std::string, bufferlist> updates;
   uint32_t count = 0;
-  while (count < num_entries && !candidates.empty()) {
+  while (count < num_entries && !merge.empty()) {
     r = 0;
-    // select the next entry in lexical order (first key in map);
-    // again tracker_idx is not necessarily shard number, but is index
-    // into results_trackers vector
-    tracker_idx = candidates.begin()->second;
-    auto& tracker = results_trackers.at(tracker_idx);
-
-    const std::string& name = tracker.entry_name();
-    rgw_bucket_dir_entry& dirent = tracker.dir_entry();
+    // the next entry in lexical order across all shards
+    const std::string& name = merge.name();
+    rgw_bucket_dir_entry& dirent = merge.dir_entry();
+    const std::string& oid_name = shard_oids.at(merge.shard());
 
     ldpp_dout(dpp, 20) << __func__ << ": currently processing " <<
-      dirent.key << " from shard " << tracker.shard_idx << dendl;
+      dirent.key << " from shard " << merge.shard() << dendl;
 
     const bool force_check =
       force_check_filter && force_check_filter(dirent.key.name);
@@ -10764,7 +10836,7 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
 	" calling check_disk_state bucket=" << bucket_info.bucket <<
 	" entry=" << dirent.key << dendl_bitx;
       r = check_disk_state(dpp, bucket_info, index_ver, dirent, dirent,
-			   updates[tracker.oid_name], y);
+			   updates[oid_name], y);
       if (r < 0 && r != -ENOENT) {
 	ldpp_dout(dpp, 0) << __func__ <<
 	  ": check_disk_state for \"" << dirent.key <<
@@ -10794,39 +10866,34 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
     } else {
       ldpp_dout(dpp, 10) << __func__ << ": skipping " <<
 	dirent.key.name << "[" << dirent.key.instance << "]" << dendl;
-      last_entry_visited = &tracker.dir_entry();
-    }
-
-    // refresh the candidates map
-    vidx.clear();
-    bool need_to_stop = false;
-    auto range = candidates.equal_range(name);
-    for (auto i = range.first; i != range.second; ++i) {
-      vidx.push_back(i->second);
-    } 
-    candidates.erase(range.first, range.second);
-    for (auto idx : vidx) {
-      auto& tracker_match = results_trackers.at(idx);
-      tracker_match.advance();
-      next_candidate(cct, tracker_match, candidates, idx);
-      if (tracker_match.at_end() && tracker_match.is_truncated()) {
-        need_to_stop = true;
-        break;
-      }
+      // entries stay in place in the merge, so this remains valid
+      last_entry_visited = &dirent;
+    }
+
+    // move past this name in every shard, refilling them as needed
+    r = merge.pop(count < num_entries);
+    if (r < 0) {
+      ldpp_dout(dpp, 0) << __func__ <<
+	": CLSRGWIssueBucketList refill for " << bucket_info.bucket <<
+	" failed" << dendl;
+      return r;
     }
-    if (need_to_stop) {
-      // once we exhaust one shard that is truncated, we need to stop,
-      // as we cannot be certain that one of the next entries needs to
-      // come from that shard; S3 and swift protocols allow returning
-      // fewer than what was requested
+    if (count < num_entries && merge.empty() && merge.is_truncated()) {
+      // a truncated shard ran dry and could not be refilled, so we
+      // cannot be certain that one of the next entries does not come
+      // from it; S3 and swift protocols allow returning fewer than what
+      // was requested
       ldpp_dout(dpp, 10) << __func__ <<
 	": stopped accumulating results at count=" << count <<
 	", dirent=\"" << dirent_key <<
 	"\", because its shard is truncated and exhausted" << dendl;
-      break;
     }
   } // while we haven't provided requested # of result entries
 
+  ldpp_dout(dpp, 20) << __func__ << ": issued " << merge.reads_issued() <<
+    " shard read(s)" << dendl;
+  *cls_filtered = *cls_filtered && merge.cls_filtered();
+
   // suggest updates if there are any
   for (auto& miter : updates) {
     if (miter.second.length()) {
@@ -10847,13 +10914,7 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
 
   // determine truncation by checking if all the returned entries are
   // consumed or not
-  *is_truncated = false;
-  for (const auto& t : results_trackers) {
-    if (!t.at_end() || t.is_truncated()) {
-      *is_truncated = true;
-      break;
-    }
-  }
+  *is_truncated = merge.is_truncated();
 
   ldpp_dout(dpp, 20) << __func__ <<
     ": returning, count=" << count << ", is_truncated=" << *is_truncated <<
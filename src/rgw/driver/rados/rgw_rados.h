@@ -1760,6 +1760,29 @@ struct get_obj_data {
   D3nGetObjData d3n_get_data;
   std::atomic_bool d3n_bypass_cache_write{false};
 
+  // adaptive readahead: the aio window follows twice the product of the
+  // lowest rados read latency seen and the rate the client drains data,
+  // between min_window and a memory budget of max_window
+  uint64_t min_window = 0;
+  uint64_t max_window = 0; // 0 disables adaptation
+  uint64_t window = 0;
+  uint64_t buffered = 0; // bytes completed out of order, not yet sent
+  std::map<uint64_t, ceph::mono_time> issued; // read id -> submit time
+  double min_latency = 0; // seconds
+  double drain_rate = 0; // bytes per second
+  ceph::mono_time last_drain; // last time data went to the client
+
+  void set_adaptive_window(uint64_t min, uint64_t max) {
+    min_window = window = min;
+    max_window = max > min ? max : 0;
+    last_drain = ceph::mono_clock::now();
+  }
+  // called by the throttle as the read is submitted
+  void read_issued(uint64_t id) {
+    issued.emplace(id, ceph::mono_clock::now());
+  }
+  void update_window();
+
   int flush(rgw::AioResultList&& results);
 
   void cancel() {
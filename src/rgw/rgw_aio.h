@@ -98,6 +98,9 @@ class Aio {
   // wait for all outstanding completions and return their results
   virtual AioResultList drain() = 0;
 
+  // change the maximum cost in flight, for throttles that have one
+  virtual void set_window(uint64_t window) {}
+
   static OpFunc librados_op(librados::IoCtx ctx,
                             librados::ObjectReadOperation&& op,
                             optional_yield y);
@@ -25,7 +25,7 @@ namespace rgw {
 
 class Throttle {
  protected:
-  const uint64_t window;
+  uint64_t window;
   uint64_t pending_size = 0;
 
   AioResultList pending;
@@ -75,6 +75,11 @@ class BlockingAioThrottle final : public Aio, private Throttle {
   AioResultList wait() override final;
 
   AioResultList drain() override final;
+
+  void set_window(uint64_t w) override final {
+    std::scoped_lock lock{mutex};
+    window = w;
+  }
 };
 
 // a throttle that yields the coroutine instead of blocking. all public
@@ -109,6 +114,11 @@ class YieldingAioThrottle final : public Aio, private Throttle {
   AioResultList wait() override final;
 
   AioResultList drain() override final;
+
+  // must be called within the coroutine strand, so there is no waiter
+  void set_window(uint64_t w) override final {
+    window = w;
+  }
 };
 
 // return a smart pointer to Aio
@@ -5,25 +5,97 @@
 #include "rgw_perf_counters.h"
 
 #include <errno.h>
+#include <set>
 
 #define dout_subsys ceph_subsys_rgw
 
 using namespace std;
 
-int ObjectCache::get(const DoutPrefixProvider *dpp, const string& name, ObjectCacheInfo& info, uint32_t mask, rgw_cache_entry_info *cache_info)
+ObjectCache::Shard::~Shard() = default;
+
+std::shared_lock<ceph::shared_mutex> ObjectCache::Shard::read_lock()
+{
+  std::shared_lock l{lock, std::try_to_lock};
+  if (!l.owns_lock()) {
+    count(l_rgw_cache_shard_contended);
+    l.lock();
+  }
+  return l;
+}
+
+std::unique_lock<ceph::shared_mutex> ObjectCache::Shard::write_lock()
+{
+  std::unique_lock l{lock, std::try_to_lock};
+  if (!l.owns_lock()) {
+    count(l_rgw_cache_shard_contended);
+    l.lock();
+  }
+  return l;
+}
+
+void ObjectCache::Shard::count(int idx)
 {
+  if (counters) {
+    counters->inc(idx);
+  }
+}
+
+ObjectCache::ObjectCache() : shard_max_entries(0), cct(NULL), enabled(false) { }
+
+void ObjectCache::set_ctx(CephContext *_cct, const std::string& counters_name)
+{
+  cct = _cct;
+  expiry = std::chrono::seconds(cct->_conf.get_val<uint64_t>(
+                                  "rgw_cache_expiry_interval"));
+
+  const auto num_shards = std::max<uint64_t>(
+    1, cct->_conf.get_val<uint64_t>("rgw_cache_shards"));
+  shard_max_entries = std::max<int64_t>(
+    1, cct->_conf->rgw_cache_lru_size / (int64_t)num_shards);
+  shards.clear();
+  for (unsigned i = 0; i < num_shards; i++) {
+    auto& shard = shards.emplace_back(std::make_unique<Shard>());
+    if (!counters_name.empty()) {
+      shard->counters = std::make_unique<rgw::cache_counters::CountersManager>(
+        counters_name, i, cct);
+    }
+  }
+}
 
-  std::shared_lock rl{lock};
-  std::unique_lock wl{lock, std::defer_lock}; // may be promoted to write lock
+ObjectCache::Shard& ObjectCache::shard_of(const string& name)
+{
+  ceph_assert(!shards.empty());
+  return *shards[std::hash<string>{}(name) % shards.size()];
+}
+
+std::vector<std::unique_lock<ceph::shared_mutex>> ObjectCache::lock_all()
+{
+  // always in shard order
+  std::vector<std::unique_lock<ceph::shared_mutex>> locks;
+  locks.reserve(shards.size());
+  for (auto& shard : shards) {
+    locks.emplace_back(shard->lock);
+  }
+  return locks;
+}
+
+int ObjectCache::get(const DoutPrefixProvider *dpp, const string& name, ObjectCacheInfo& info, uint32_t mask, rgw_cache_entry_info *cache_info)
+{
   if (!enabled) {
     return -ENOENT;
   }
-  auto iter = cache_map.find(name);
-  if (iter == cache_map.end()) {
+  Shard& shard = shard_of(name);
+  auto rl = shard.read_lock();
+  if (!enabled) {
+    return -ENOENT;
+  }
+  auto iter = shard.cache_map.find(name);
+  if (iter == shard.cache_map.end()) {
     ldpp_dout(dpp, 10) << "cache get: name=" << name << " : miss" << dendl;
     if (perfcounter) {
       perfcounter->inc(l_rgw_cache_miss);
     }
+    shard.count(l_rgw_cache_shard_miss);
     return -ENOENT;
   }
 
@@ -31,47 +103,29 @@ int ObjectCache::get(const DoutPrefixProvider *dpp, const string& name, ObjectCa
        (ceph::coarse_mono_clock::now() - iter->second.info.time_added) > expiry) {
     ldpp_dout(dpp, 10) << "cache get: name=" << name << " : expiry miss" << dendl;
     rl.unlock();
-    wl.lock(); // write lock for expiration
+    auto wl = shard.write_lock(); // write lock for expiration
     // check that wasn't already removed by other thread
-    iter = cache_map.find(name);
-    if (iter != cache_map.end()) {
-      for (auto &kv : iter->second.chained_entries)
-        kv.first->invalidate(kv.second);
-      remove_lru(name, iter->second.lru_iter);
-      cache_map.erase(iter);
+    iter = shard.cache_map.find(name);
+    if (iter != shard.cache_map.end()) {
+      invalidate_chained(iter->second);
+      remove_entry(shard, iter);
     }
     if (perfcounter) {
       perfcounter->inc(l_rgw_cache_miss);
     }
+    shard.count(l_rgw_cache_shard_miss);
     return -ENOENT;
   }
 
   ObjectCacheEntry *entry = &iter->second;
-
-  if (lru_counter - entry->lru_promotion_ts > lru_window) {
-    ldpp_dout(dpp, 20) << "cache get: touching lru, lru_counter=" << lru_counter
-                   << " promotion_ts=" << entry->lru_promotion_ts << dendl;
-    rl.unlock();
-    wl.lock(); // write lock for touch_lru()
-    /* need to redo this because entry might have dropped off the cache */
-    iter = cache_map.find(name);
-    if (iter == cache_map.end()) {
-      ldpp_dout(dpp, 10) << "lost race! cache get: name=" << name << " : miss" << dendl;
-      if(perfcounter) perfcounter->inc(l_rgw_cache_miss);
-      return -ENOENT;
-    }
-
-    entry = &iter->second;
-    /* check again, we might have lost a race here */
-    if (lru_counter - entry->lru_promotion_ts > lru_window) {
-      touch_lru(dpp, name, *entry, iter->second.lru_iter);
-    }
-  }
+  // CLOCK: mark the entry as used; eviction clears the bit
+  entry->referenced.store(true, std::memory_order_relaxed);
 
   ObjectCacheInfo& src = iter->second.info;
   if(src.status == -ENOENT) {
     ldpp_dout(dpp, 10) << "cache get: name=" << name << " : hit (negative entry)" << dendl;
     if (perfcounter) perfcounter->inc(l_rgw_cache_hit);
+    shard.count(l_rgw_cache_shard_hit);
     return -ENODATA;
   }
   if ((src.flags & mask) != mask) {
@@ -79,6 +133,7 @@ int ObjectCache::get(const DoutPrefixProvider *dpp, const string& name, ObjectCa
                    << std::hex << mask << ", cached=0x" << src.flags
                    << std::dec << ")" << dendl;
     if(perfcounter) perfcounter->inc(l_rgw_cache_miss);
+    shard.count(l_rgw_cache_shard_miss);
     return -ENOENT;
   }
   ldpp_dout(dpp, 10) << "cache get: name=" << name << " : hit (requested=0x"
@@ -91,6 +146,7 @@ int ObjectCache::get(const DoutPrefixProvider *dpp, const string& name, ObjectCa
     cache_info->gen = entry->gen;
   }
   if(perfcounter) perfcounter->inc(l_rgw_cache_hit);
+  shard.count(l_rgw_cache_shard_hit);
 
   return 0;
 }
@@ -99,7 +155,21 @@ bool ObjectCache::chain_cache_entry(const DoutPrefixProvider *dpp,
                                     std::initializer_list<rgw_cache_entry_info*> cache_info_entries,
 				    RGWChainedCache::Entry *chained_entry)
 {
-  std::unique_lock l{lock};
+  if (!enabled) {
+    return false;
+  }
+
+  // the entries may live in different shards; lock them in shard order
+  std::set<Shard*> involved;
+  for (auto cache_info : cache_info_entries) {
+    involved.insert(&shard_of(cache_info->cache_locator));
+  }
+  std::vector<std::unique_lock<ceph::shared_mutex>> locks;
+  for (auto& shard : shards) {
+    if (involved.count(shard.get())) {
+      locks.emplace_back(shard->write_lock());
+    }
+  }
 
   if (!enabled) {
     return false;
@@ -111,8 +181,9 @@ bool ObjectCache::chain_cache_entry(const DoutPrefixProvider *dpp,
   for (auto cache_info : cache_info_entries) {
     ldpp_dout(dpp, 10) << "chain_cache_entry: cache_locator="
 		   << cache_info->cache_locator << dendl;
-    auto iter = cache_map.find(cache_info->cache_locator);
-    if (iter == cache_map.end()) {
+    Shard& shard = shard_of(cache_info->cache_locator);
+    auto iter = shard.cache_map.find(cache_info->cache_locator);
+    if (iter == shard.cache_map.end()) {
       ldpp_dout(dpp, 20) << "chain_cache_entry: couldn't find cache locator" << dendl;
       return false;
     }
@@ -141,7 +212,11 @@ bool ObjectCache::chain_cache_entry(const DoutPrefixProvider *dpp,
 
 void ObjectCache::put(const DoutPrefixProvider *dpp, const string& name, ObjectCacheInfo& info, rgw_cache_entry_info *cache_info)
 {
-  std::unique_lock l{lock};
+  if (!enabled) {
+    return;
+  }
+  Shard& shard = shard_of(name);
+  auto l = shard.write_lock();
 
   if (!enabled) {
     return;
@@ -150,21 +225,27 @@ void ObjectCache::put(const DoutPrefixProvider *dpp, const string& name, ObjectC
   ldpp_dout(dpp, 10) << "cache put: name=" << name << " info.flags=0x"
                  << std::hex << info.flags << std::dec << dendl;
 
-  auto [iter, inserted] = cache_map.emplace(name, ObjectCacheEntry{});
+  auto [iter, inserted] = shard.cache_map.try_emplace(name);
   ObjectCacheEntry& entry = iter->second;
   entry.info.time_added = ceph::coarse_mono_clock::now();
   if (inserted) {
-    entry.lru_iter = lru.end();
+    // new entries go right behind the hand, so they survive a full sweep
+    entry.clock_iter = shard.clock.insert(shard.hand, name);
+    ldpp_dout(dpp, 10) << "adding " << name << " to cache" << dendl;
+    evict(shard, name);
+    if (shard.counters) {
+      shard.counters->set(l_rgw_cache_shard_entries, shard.cache_map.size());
+    }
+  } else {
+    entry.referenced.store(true, std::memory_order_relaxed);
   }
   ObjectCacheInfo& target = entry.info;
 
-  invalidate_lru(entry);
+  invalidate_chained(entry);
 
   entry.chained_entries.clear();
   entry.gen++;
 
-  touch_lru(dpp, name, entry, entry.lru_iter);
-
   target.status = info.status;
 
   if (info.status < 0) {
@@ -218,80 +299,66 @@ void ObjectCache::put(const DoutPrefixProvider *dpp, const string& name, ObjectC
 // negative lookup. It must only invalidate.
 bool ObjectCache::invalidate_remove(const DoutPrefixProvider *dpp, const string& name)
 {
-  std::unique_lock l{lock};
+  if (!enabled) {
+    return false;
+  }
+  Shard& shard = shard_of(name);
+  auto l = shard.write_lock();
 
   if (!enabled) {
     return false;
   }
 
-  auto iter = cache_map.find(name);
-  if (iter == cache_map.end())
+  auto iter = shard.cache_map.find(name);
+  if (iter == shard.cache_map.end())
     return false;
 
   ldpp_dout(dpp, 10) << "removing " << name << " from cache" << dendl;
-  ObjectCacheEntry& entry = iter->second;
-
-  for (auto& kv : entry.chained_entries) {
-    kv.first->invalidate(kv.second);
-  }
-
-  remove_lru(name, iter->second.lru_iter);
-  cache_map.erase(iter);
+  invalidate_chained(iter->second);
+  remove_entry(shard, iter);
   return true;
 }
 
-void ObjectCache::touch_lru(const DoutPrefixProvider *dpp, const string& name, ObjectCacheEntry& entry,
-			    std::list<string>::iterator& lru_iter)
+void ObjectCache::evict(Shard& shard, const string& keep)
 {
-  while (lru_size > (size_t)cct->_conf->rgw_cache_lru_size) {
-    auto iter = lru.begin();
-    if ((*iter).compare(name) == 0) {
-      /*
-       * if the entry we're touching happens to be at the lru end, don't remove it,
-       * lru shrinking can wait for next time
-       */
-      break;
+  while (shard.cache_map.size() > shard_max_entries) {
+    if (shard.hand == shard.clock.end()) {
+      shard.hand = shard.clock.begin();
     }
-    auto map_iter = cache_map.find(*iter);
-    ldout(cct, 10) << "removing entry: name=" << *iter << " from cache LRU" << dendl;
-    if (map_iter != cache_map.end()) {
-      ObjectCacheEntry& entry = map_iter->second;
-      invalidate_lru(entry);
-      cache_map.erase(map_iter);
+    auto map_iter = shard.cache_map.find(*shard.hand);
+    ceph_assert(map_iter != shard.cache_map.end());
+    ObjectCacheEntry& entry = map_iter->second;
+    // give referenced entries a second chance, and never evict the
+    // entry being inserted
+    if (*shard.hand == keep ||
+        entry.referenced.exchange(false, std::memory_order_relaxed)) {
+      ++shard.hand;
+      continue;
     }
-    lru.pop_front();
-    lru_size--;
+    ldout(cct, 10) << "removing entry: name=" << *shard.hand << " from cache" << dendl;
+    invalidate_chained(entry);
+    shard.hand = shard.clock.erase(shard.hand);
+    shard.cache_map.erase(map_iter);
+    shard.count(l_rgw_cache_shard_evict);
   }
-
-  if (lru_iter == lru.end()) {
-    lru.push_back(name);
-    lru_size++;
-    lru_iter--;
-    ldpp_dout(dpp, 10) << "adding " << name << " to cache LRU end" << dendl;
-  } else {
-    ldpp_dout(dpp, 10) << "moving " << name << " to cache LRU end" << dendl;
-    lru.erase(lru_iter);
-    lru.push_back(name);
-    lru_iter = lru.end();
-    --lru_iter;
-  }
-
-  lru_counter++;
-  entry.lru_promotion_ts = lru_counter;
 }
 
-void ObjectCache::remove_lru(const string& name,
-			     std::list<string>::iterator& lru_iter)
+void ObjectCache::remove_entry(Shard& shard,
+                               std::unordered_map<string, ObjectCacheEntry>::iterator iter)
 {
-  if (lru_iter == lru.end())
-    return;
-
-  lru.erase(lru_iter);
-  lru_size--;
-  lru_iter = lru.end();
+  auto clock_iter = iter->second.clock_iter;
+  if (shard.hand == clock_iter) {
+    shard.hand = shard.clock.erase(clock_iter);
+  } else {
+    shard.clock.erase(clock_iter);
+  }
+  shard.cache_map.erase(iter);
+  if (shard.counters) {
+    shard.counters->set(l_rgw_cache_shard_entries, shard.cache_map.size());
+  }
 }
 
-void ObjectCache::invalidate_lru(ObjectCacheEntry& entry)
+void ObjectCache::invalidate_chained(ObjectCacheEntry& entry)
 {
   for (auto iter = entry.chained_entries.begin();
        iter != entry.chained_entries.end(); ++iter) {
@@ -302,7 +369,7 @@ void ObjectCache::invalidate_lru(ObjectCacheEntry& entry)
 
 void ObjectCache::set_enabled(bool status)
 {
-  std::unique_lock l{lock};
+  auto locks = lock_all();
 
   enabled = status;
 
@@ -313,32 +380,35 @@ void ObjectCache::set_enabled(bool status)
 
 void ObjectCache::invalidate_all()
 {
-  std::unique_lock l{lock};
+  auto locks = lock_all();
 
   do_invalidate_all();
 }
 
 void ObjectCache::do_invalidate_all()
 {
-  cache_map.clear();
-  lru.clear();
-
-  lru_size = 0;
-  lru_counter = 0;
-  lru_window = 0;
+  for (auto& shard : shards) {
+    shard->cache_map.clear();
+    shard->clock.clear();
+    shard->hand = shard->clock.end();
+    if (shard->counters) {
+      shard->counters->set(l_rgw_cache_shard_entries, 0);
+    }
+  }
 
+  std::lock_guard l{chained_lock};
   for (auto& cache : chained_cache) {
     cache->invalidate_all();
   }
 }
 
 void ObjectCache::chain_cache(RGWChainedCache *cache) {
-  std::unique_lock l{lock};
+  std::lock_guard l{chained_lock};
   chained_cache.push_back(cache);
 }
 
 void ObjectCache::unchain_cache(RGWChainedCache *cache) {
-  std::unique_lock l{lock};
+  std::lock_guard l{chained_lock};
 
   auto iter = chained_cache.begin();
   for (; iter != chained_cache.end(); ++iter) {
@@ -3,10 +3,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <list>
+#include <memory>
 #include <shared_mutex> // for std::shared_lock
 #include <string>
 #include <map>
 #include <unordered_map>
+#include <vector>
 #include "include/types.h"
 #include "include/utime.h"
 #include "include/ceph_assert.h"
@@ -151,37 +155,53 @@ public:
 
 struct ObjectCacheEntry {
   ObjectCacheInfo info;
-  std::list<std::string>::iterator lru_iter;
-  uint64_t lru_promotion_ts;
-  uint64_t gen;
+  std::list<std::string>::iterator clock_iter;
+  // CLOCK reference bit; set by lookups holding only a shared lock
+  mutable std::atomic<bool> referenced = false;
+  uint64_t gen = 0;
   std::vector<std::pair<RGWChainedCache *, std::string> > chained_entries;
-
-  ObjectCacheEntry() : lru_promotion_ts(0), gen(0) {}
 };
 
+namespace rgw::cache_counters { class CountersManager; }
+
 class ObjectCache {
-  std::unordered_map<std::string, ObjectCacheEntry> cache_map;
-  std::list<std::string> lru;
-  unsigned long lru_size;
-  unsigned long lru_counter;
-  unsigned long lru_window;
-  ceph::shared_mutex lock = ceph::make_shared_mutex("ObjectCache");
+  // entries are spread over shards by name hash; each shard has its own
+  // lock and evicts with CLOCK, so hits never take an exclusive lock
+  struct Shard {
+    ceph::shared_mutex lock = ceph::make_shared_mutex("ObjectCache::Shard");
+    std::unordered_map<std::string, ObjectCacheEntry> cache_map;
+    std::list<std::string> clock;
+    std::list<std::string>::iterator hand = clock.end();
+    std::unique_ptr<rgw::cache_counters::CountersManager> counters;
+
+    ~Shard();
+    std::shared_lock<ceph::shared_mutex> read_lock();
+    std::unique_lock<ceph::shared_mutex> write_lock();
+    void count(int idx);
+  };
+
+  std::vector<std::unique_ptr<Shard>> shards;
+  size_t shard_max_entries;
   CephContext *cct;
 
+  ceph::mutex chained_lock = ceph::make_mutex("ObjectCache::chained_lock");
   std::vector<RGWChainedCache *> chained_cache;
 
-  bool enabled;
+  std::atomic<bool> enabled;
   ceph::timespan expiry;
 
-  void touch_lru(const DoutPrefixProvider *dpp, const std::string& name, ObjectCacheEntry& entry,
-		 std::list<std::string>::iterator& lru_iter);
-  void remove_lru(const std::string& name, std::list<std::string>::iterator& lru_iter);
-  void invalidate_lru(ObjectCacheEntry& entry);
+  Shard& shard_of(const std::string& name);
+  std::vector<std::unique_lock<ceph::shared_mutex>> lock_all();
+
+  void evict(Shard& shard, const std::string& keep);
+  void remove_entry(Shard& shard,
+                    std::unordered_map<std::string, ObjectCacheEntry>::iterator iter);
+  void invalidate_chained(ObjectCacheEntry& entry);
 
   void do_invalidate_all();
 
 public:
-  ObjectCache() : lru_size(0), lru_counter(0), lru_window(0), cct(NULL), enabled(false) { }
+  ObjectCache();
   ~ObjectCache();
   int get(const DoutPrefixProvider *dpp, const std::string& name, ObjectCacheInfo& bl, uint32_t mask, rgw_cache_entry_info *cache_info);
   std::optional<ObjectCacheInfo> get(const DoutPrefixProvider *dpp, const std::string& name) {
@@ -192,10 +212,13 @@ public:
 
   template<typename F>
   void for_each(const F& f) {
-    std::shared_lock l{lock};
-    if (enabled) {
-      auto now  = ceph::coarse_mono_clock::now();
-      for (const auto& [name, entry] : cache_map) {
+    if (!enabled) {
+      return;
+    }
+    auto now  = ceph::coarse_mono_clock::now();
+    for (auto& shard : shards) {
+      std::shared_lock l{shard->lock};
+      for (const auto& [name, entry] : shard->cache_map) {
         if (expiry.count() && (now - entry.info.time_added) < expiry) {
           f(name, entry);
         }
@@ -205,12 +228,8 @@ public:
 
   void put(const DoutPrefixProvider *dpp, const std::string& name, ObjectCacheInfo& bl, rgw_cache_entry_info *cache_info);
   bool invalidate_remove(const DoutPrefixProvider *dpp, const std::string& name);
-  void set_ctx(CephContext *_cct) {
-    cct = _cct;
-    lru_window = cct->_conf->rgw_cache_lru_size / 2;
-    expiry = std::chrono::seconds(cct->_conf.get_val<uint64_t>(
-						"rgw_cache_expiry_interval"));
-  }
+  // counters_name, if not empty, labels per-shard perf counters
+  void set_ctx(CephContext *_cct, const std::string& counters_name = "");
   bool chain_cache_entry(const DoutPrefixProvider *dpp,
                          std::initializer_list<rgw_cache_entry_info*> cache_info_entries,
 			 RGWChainedCache::Entry *chained_entry);
@@ -220,4 +239,5 @@ public:
   void chain_cache(RGWChainedCache *cache);
   void unchain_cache(RGWChainedCache *cache);
   void invalidate_all();
+  size_t num_shards() const { return shards.size(); }
 };
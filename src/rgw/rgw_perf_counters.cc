@@ -10,6 +10,7 @@
 using namespace ceph::perf_counters;
 using namespace rgw::op_counters;
 using namespace rgw::persistent_topic_counters;
+using namespace rgw::cache_counters;
 
 PerfCounters *perfcounter = NULL;
 
@@ -103,6 +104,17 @@ void add_rgw_topic_counters(PerfCountersBuilder *lpcb) {
 
 }
 
+void add_rgw_cache_shard_counters(PerfCountersBuilder *lpcb) {
+  lpcb->set_prio_default(PerfCountersBuilder::PRIO_USEFUL);
+
+  lpcb->add_u64_counter(l_rgw_cache_shard_hit, "cache_hit", "Cache hits");
+  lpcb->add_u64_counter(l_rgw_cache_shard_miss, "cache_miss", "Cache miss");
+  lpcb->add_u64_counter(l_rgw_cache_shard_contended, "cache_lock_contended",
+                        "Cache shard lock acquisitions that had to wait");
+  lpcb->add_u64_counter(l_rgw_cache_shard_evict, "cache_evict", "Cache evictions");
+  lpcb->add_u64(l_rgw_cache_shard_entries, "cache_entries", "Cache entries");
+}
+
 void frontend_counters_init(CephContext *cct) {
   PerfCountersBuilder pcb(cct, "rgw", l_rgw_first, l_rgw_last);
   add_rgw_frontend_counters(&pcb);
@@ -232,6 +244,34 @@ CountersManager::~CountersManager() {
 
 } // namespace rgw::persistent_topic_counters
 
+namespace rgw::cache_counters {
+
+const std::string rgw_cache_counters_key = "rgw_cache";
+
+CountersManager::CountersManager(const std::string& cache_name, unsigned shard, CephContext *cct)
+    : cct(cct)
+{
+  const std::string shard_key = ceph::perf_counters::key_create(rgw_cache_counters_key, {{"cache", cache_name}, {"shard", std::to_string(shard)}});
+  PerfCountersBuilder pcb(cct, shard_key, l_rgw_cache_shard_first, l_rgw_cache_shard_last);
+  add_rgw_cache_shard_counters(&pcb);
+  shard_counters = std::unique_ptr<PerfCounters>(pcb.create_perf_counters());
+  cct->get_perfcounters_collection()->add(shard_counters.get());
+}
+
+void CountersManager::inc(int idx, uint64_t v) {
+  shard_counters->inc(idx, v);
+}
+
+void CountersManager::set(int idx, uint64_t v) {
+  shard_counters->set(idx, v);
+}
+
+CountersManager::~CountersManager() {
+  cct->get_perfcounters_collection()->remove(shard_counters.get());
+}
+
+} // namespace rgw::cache_counters
+
 int rgw_perf_start(CephContext *cct)
 {
   frontend_counters_init(cct);
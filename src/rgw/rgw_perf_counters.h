@@ -96,6 +96,18 @@ enum {
   l_rgw_topic_last
 };
 
+enum {
+  l_rgw_cache_shard_first = 18000,
+
+  l_rgw_cache_shard_hit,
+  l_rgw_cache_shard_miss,
+  l_rgw_cache_shard_contended,
+  l_rgw_cache_shard_evict,
+  l_rgw_cache_shard_entries,
+
+  l_rgw_cache_shard_last
+};
+
 namespace rgw::op_counters {
 
 struct CountersContainer {
@@ -129,3 +141,21 @@ public:
 };
 
 } // namespace rgw::persistent_topic_counters
+
+namespace rgw::cache_counters {
+
+// per-shard counters of an ObjectCache, labeled by cache name and shard
+class CountersManager {
+  std::unique_ptr<PerfCounters> shard_counters;
+  CephContext *cct;
+
+public:
+  CountersManager(const std::string& cache_name, unsigned shard, CephContext *cct);
+
+  void inc(int idx, uint64_t v = 1);
+  void set(int idx, uint64_t v);
+
+  ~CountersManager();
+};
+
+} // namespace rgw::cache_counters
@@ -103,7 +103,7 @@ protected:
 
 public:
   RGWSI_SysObj_Cache(const DoutPrefixProvider *dpp, CephContext *cct) : RGWSI_SysObj_Core(cct), asocket(dpp, this) {
-    cache.set_ctx(cct);
+    cache.set_ctx(cct, "sysobj");
   }
 
   bool chain_cache_entry(const DoutPrefixProvider *dpp,
@@ -2615,6 +2615,45 @@ TEST(BufferList, crc32c_zeros) {
   }
 }
 
+TEST(BufferList, crc32c_multi) {
+  constexpr unsigned n = 20;
+  bufferlist bls[n];
+  const bufferlist* pbls[n];
+  uint32_t crcs[n];
+  uint32_t expected[n];
+  for (unsigned i = 0; i < n; i++) {
+    // lists of different shapes, some ptrs shared so their crc is cached
+    for (unsigned j = 0; j < i % 5; j++) {
+      bufferptr p(buffer::create(1 + (i * 37 + j * 101) % 700));
+      for (unsigned k = 0; k < p.length(); k++) {
+        p[k] = rand();
+      }
+      bls[i].push_back(p);
+      if (i > 0 && j == 0) {
+        bls[i].append(bls[i - 1]);
+      }
+    }
+    if (i % 3 == 0) {
+      bls[i].crc32c(rand());
+    }
+    pbls[i] = &bls[i];
+    crcs[i] = i;
+  }
+  for (unsigned i = 0; i < n; i++) {
+    std::string flat;
+    for (const auto& p : bls[i].buffers()) {
+      flat.append(p.c_str(), p.length());
+    }
+    expected[i] = ceph_crc32c(i, (const unsigned char*)flat.data(), flat.size());
+  }
+  bufferlist::crc32c_multi(pbls, crcs, n);
+  for (unsigned i = 0; i < n; i++) {
+    EXPECT_EQ(expected[i], crcs[i]);
+    // and the cached values agree with a plain crc32c
+    EXPECT_EQ(expected[i], bls[i].crc32c(i));
+  }
+}
+
 TEST(BufferList, crc32c_append_perf) {
   int len = 256 * 1024 * 1024;
   bufferptr a(len);
@@ -0,0 +1,4 @@
+  $ crushtool -i "$TESTDIR/test-map-indep.crushmap" --test --bench-batch --rule 1 --min-rep 1 --max-rep 3 --set-choose-local-tries 0 --set-choose-local-fallback-tries 0 --set-choose-total-tries 50 --set-chooseleaf-descend-once 2
+  rule 1 \(metadata\) num_rep 1 x 0..1023: single .*s, batch .*s.*, 0 mismatched mappings (re)
+  rule 1 \(metadata\) num_rep 2 x 0..1023: single .*s, batch .*s.*, 0 mismatched mappings (re)
+  rule 1 \(metadata\) num_rep 3 x 0..1023: single .*s, batch .*s.*, 0 mismatched mappings (re)
@@ -100,6 +100,8 @@
         [--simulate]       simulate placements using a random
                            number generator in place of the CRUSH
                            algorithm
+        [--bench-batch]    time CRUSH mapping with a reused workspace
+                           and verify that they match
      --show-utilization    show OSD usage
      --show-utilization-all
                            include zero weight items
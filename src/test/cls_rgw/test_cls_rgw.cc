@@ -563,16 +563,15 @@ TEST_F(cls_rgw, index_list_delimited)
   list_entries(ioctx, bucket_oid, 1000, listing, start_key, delimiter);
   auto id_entry_map = listing.dir.m;
 
-  // the cls code will make 4 tries to get 1000 entries; however
-  // because each of the subdirectories is so large, each attempt will
-  // only retrieve the first part of the subdirectory
+  // each of the subdirectories is larger than a single read, but the
+  // cls code seeks past every common prefix, so one call is enough
 
-  ASSERT_EQ(48u, id_entry_map.size()) <<
-    "We should get 40 top-level entries and the tops of 8 \"subdirectories\".";
-  ASSERT_EQ(true, listing.is_truncated) << "We did not get all entries.";
+  ASSERT_EQ(65u, id_entry_map.size()) <<
+    "We should get 55 top-level entries and 10 \"subdirectories\".";
+  ASSERT_EQ(false, listing.is_truncated) << "We should get all entries.";
 
   ASSERT_EQ("a-0", id_entry_map.cbegin()->first);
-  ASSERT_EQ("p/", id_entry_map.crbegin()->first);
+  ASSERT_EQ("u-4", id_entry_map.crbegin()->first);
 
   // now let's get the rest of the entries
 
@@ -589,6 +588,59 @@ TEST_F(cls_rgw, index_list_delimited)
   ASSERT_EQ("u-4", id_entry_map.crbegin()->first);
 }
 
+/*
+ * Delimited listing of a sharded bucket index where every shard holds a
+ * part of one very large "subdirectory": each shard should collapse it
+ * into a single common prefix in one call.
+ */
+TEST_F(cls_rgw, index_list_delimited_sharded)
+{
+  constexpr int num_shards = 4;
+  const int dir_num_objs = 4000;
+  const int file_num_objs = 20;
+  uint64_t epoch = 1;
+
+  std::vector<std::string> shard_oids;
+  for (int s = 0; s < num_shards; s++) {
+    shard_oids.push_back(str_int("sharded", s));
+    ObjectWriteOperation op;
+    cls_rgw_bucket_init_index(op);
+    ASSERT_EQ(0, ioctx.operate(shard_oids.back(), &op));
+  }
+
+  rgw_bucket_dir_entry_meta meta;
+  meta.category = RGWObjCategory::None;
+  meta.size = 1024;
+
+  auto add = [&](int i, const std::string& obj) {
+    const std::string& oid = shard_oids[i % num_shards];
+    string tag = str_int("tag", i);
+    string loc = str_int("loc", i);
+    index_prepare(ioctx, oid, CLS_RGW_OP_ADD, tag, obj, loc);
+    index_complete(ioctx, oid, CLS_RGW_OP_ADD, tag, epoch, obj, meta,
+		   0 /* bi_flags */, false /* log_op */);
+  };
+  for (int i = 0; i < dir_num_objs; i++) {
+    add(i, str_int("big/f", i));
+  }
+  for (int i = 0; i < file_num_objs; i++) {
+    add(i, str_int("z", i));
+  }
+
+  const string delimiter = "/";
+  for (const auto& oid : shard_oids) {
+    rgw_cls_list_ret listing;
+    list_entries(ioctx, oid, 100, listing, {}, delimiter);
+    const auto& m = listing.dir.m;
+
+    ASSERT_EQ(1u + file_num_objs / num_shards, m.size());
+    ASSERT_FALSE(listing.is_truncated);
+    ASSERT_EQ("big/", m.cbegin()->first);
+    ASSERT_TRUE(m.cbegin()->second.flags &
+		rgw_bucket_dir_entry::FLAG_COMMON_PREFIX);
+  }
+}
+
 
 TEST_F(cls_rgw, bi_list)
 {
@@ -3,6 +3,8 @@
 
 #include <iostream>
 #include <string.h>
+#include <string>
+#include <vector>
 
 #include "include/types.h"
 #include "include/crc32c.h"
@@ -13,7 +15,9 @@
 
 #include "common/sctp_crc32.h"
 #include "common/crc32c_intel_baseline.h"
+#include "common/crc32c_intel_multi.h"
 #include "common/crc32c_aarch64.h"
+#include "arch/intel.h"
 
 TEST(Crc32c, Small) {
   const char *a = "foo bar baz";
@@ -165,6 +169,129 @@ static uint32_t crc_check_table[] = {
 0xf8eafea1, 0xfe36fdae, 0xb4b546f1, 0x2e27ce89, 0xc1fde8a0, 0x99f2f157, 0xfde687a1, 0x40a75f50,
 0x6c653330, 0xf3e38821, 0xf4663e43, 0x2f7e801e, 0xfca360af, 0x53cd3c59, 0xd20da292, 0x812a0241 };
 
+TEST(Crc32c, Multi) {
+  // lengths around the 8 byte word and the interleave threshold
+  std::vector<std::string> bufs;
+  for (unsigned len : {0, 1, 7, 8, 15, 16, 17, 63, 64, 100, 511, 4096, 4099}) {
+    std::string b(len, 0);
+    for (auto& c : b) {
+      c = rand();
+    }
+    bufs.push_back(b);
+  }
+  for (unsigned n = 1; n <= bufs.size(); n++) {
+    std::vector<uint32_t> crcs(n);
+    std::vector<const unsigned char*> data(n);
+    std::vector<unsigned> lengths(n);
+    for (unsigned i = 0; i < n; i++) {
+      // rotate so that streams of unequal length end up side by side
+      auto& b = bufs[(i * 5 + n) % bufs.size()];
+      crcs[i] = rand();
+      data[i] = (i == 3) ? nullptr : (const unsigned char*)b.data();
+      lengths[i] = b.size();
+    }
+    std::vector<uint32_t> expected(n);
+    for (unsigned i = 0; i < n; i++) {
+      expected[i] = ceph_crc32c(crcs[i], data[i], lengths[i]);
+    }
+    ceph_crc32c_multi(crcs.data(), data.data(), lengths.data(), n);
+    ASSERT_EQ(expected, crcs);
+  }
+}
+
+TEST(Crc32c, MultiUnaligned) {
+  // every interleaved implementation this CPU can run, against the
+  // portable single stream one, with odd lengths starting at every
+  // offset within a word so that no stream is aligned or ends on a word
+  std::vector<std::pair<const char*, ceph_crc32c_multi_func_t>> impls = {
+    {"best choice", ceph_crc32c_multi_func},
+  };
+#if defined(__x86_64__)
+  if (ceph_arch_intel_sse42) {
+    impls.emplace_back("intel", ceph_crc32c_intel_multi);
+  }
+#elif defined(__arm__) || defined(__aarch64__)
+# if defined(HAVE_ARMV8_CRC)
+  if (ceph_arch_aarch64_crc32) {
+    impls.emplace_back("aarch64", ceph_crc32c_aarch64_multi);
+  }
+# endif
+#endif
+  std::string buf(8 + 4 * 4097, 0);
+  for (auto& c : buf) {
+    c = rand();
+  }
+  const unsigned lens[] = {1, 3, 15, 17, 31, 33, 255, 257, 4095, 4097};
+  const unsigned nlens = sizeof(lens) / sizeof(lens[0]);
+  for (auto& [name, multi] : impls) {
+    for (unsigned shift = 0; shift < 8; shift++) {
+      for (unsigned n = 1; n <= 5; n++) {
+        SCOPED_TRACE(std::string(name) + " shift " + std::to_string(shift) +
+                     " n " + std::to_string(n));
+        std::vector<uint32_t> crcs(n), expected(n);
+        std::vector<const unsigned char*> data(n);
+        std::vector<unsigned> lengths(n);
+        for (unsigned i = 0; i < n; i++) {
+          // each stream at its own misalignment and length
+          unsigned off = (shift + i * 3) % 8;
+          data[i] = (const unsigned char*)buf.data() + off + i * 4097;
+          lengths[i] = lens[(shift + i * 7 + n) % nlens];
+          crcs[i] = rand();
+          expected[i] = ceph_crc32c_sctp(crcs[i], data[i], lengths[i]);
+        }
+        multi(crcs.data(), data.data(), lengths.data(), n);
+        ASSERT_EQ(expected, crcs);
+      }
+    }
+  }
+}
+
+TEST(Crc32c, Combine) {
+  std::string a(1000, 0), b(3333, 0);
+  for (auto& c : a) {
+    c = rand();
+  }
+  for (auto& c : b) {
+    c = rand();
+  }
+  std::string ab = a + b;
+  uint32_t crc_a = ceph_crc32c(-1, (const unsigned char*)a.data(), a.size());
+  uint32_t crc_b = ceph_crc32c(0, (const unsigned char*)b.data(), b.size());
+  ASSERT_EQ(ceph_crc32c(-1, (const unsigned char*)ab.data(), ab.size()),
+            ceph_crc32c_combine(crc_a, crc_b, b.size()));
+  ASSERT_EQ(crc_a, ceph_crc32c_combine(crc_a, 0, 0));
+}
+
+TEST(Crc32c, MultiPerformance) {
+  constexpr unsigned total = 256 * 1024 * 1024;
+  std::string buf(total, 0);
+  for (unsigned i = 0; i < total; i++) {
+    buf[i] = i & 0xff;
+  }
+  for (unsigned len : {64, 512, 4096, 65536}) {
+    unsigned n = total / len;
+    std::vector<uint32_t> crcs(n, -1), expected(n, -1);
+    std::vector<const unsigned char*> data(n);
+    std::vector<unsigned> lengths(n, len);
+    for (unsigned i = 0; i < n; i++) {
+      data[i] = (const unsigned char*)buf.data() + i * len;
+    }
+    utime_t start = ceph_clock_now();
+    for (unsigned i = 0; i < n; i++) {
+      expected[i] = ceph_crc32c(expected[i], data[i], len);
+    }
+    utime_t end = ceph_clock_now();
+    float rate = (float)total / (float)(1024*1024) / (float)(end - start);
+    std::cout << "len " << len << " one at a time = " << rate << " MB/sec" << std::endl;
+    start = ceph_clock_now();
+    ceph_crc32c_multi(crcs.data(), data.data(), lengths.data(), n);
+    end = ceph_clock_now();
+    rate = (float)total / (float)(1024*1024) / (float)(end - start);
+    std::cout << "len " << len << " multi = " << rate << " MB/sec" << std::endl;
+    ASSERT_EQ(expected, crcs);
+  }
+}
+
 TEST(Crc32c, Range) {
   int len = sizeof(crc_check_table) / sizeof(crc_check_table[0]);
   unsigned char *b = (unsigned char *)malloc(len);
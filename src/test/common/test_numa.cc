@@ -70,3 +70,24 @@ TEST(cpu_set, round_trip_list)
   }
 }
 
+
+TEST(cpu_set, slice)
+{
+  cpu_set_t cpu_set, slice;
+  size_t size, slice_size;
+  ASSERT_EQ(0, parse_cpu_set_list("0-3,8-11", &size, &cpu_set));
+
+  ASSERT_EQ(0, get_cpu_set_slice(size, &cpu_set, 4, 0, &slice_size, &slice));
+  ASSERT_EQ(std::string("0-1"), cpu_set_to_str_list(slice_size, &slice));
+  ASSERT_EQ(0, get_cpu_set_slice(size, &cpu_set, 4, 2, &slice_size, &slice));
+  ASSERT_EQ(std::string("8-9"), cpu_set_to_str_list(slice_size, &slice));
+  ASSERT_EQ(0, get_cpu_set_slice(size, &cpu_set, 3, 2, &slice_size, &slice));
+  ASSERT_EQ(std::string("9-11"), cpu_set_to_str_list(slice_size, &slice));
+
+  // more slices than cpus: slices wrap around
+  ASSERT_EQ(0, get_cpu_set_slice(size, &cpu_set, 16, 9, &slice_size, &slice));
+  ASSERT_EQ(std::string("1"), cpu_set_to_str_list(slice_size, &slice));
+
+  ASSERT_EQ(-EINVAL, get_cpu_set_slice(size, &cpu_set, 4, 4, &slice_size, &slice));
+  ASSERT_EQ(-EINVAL, get_cpu_set_slice(size, &cpu_set, 0, 0, &slice_size, &slice));
+}
@@ -0,0 +1,115 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "common/sharded_shared_mutex.h"
+
+TEST(ShardedSharedMutex, readers_share)
+{
+  ceph::sharded_shared_mutex m;
+  std::shared_lock l1{m};
+  // a reader on any other thread gets in alongside us
+  auto other = std::async(std::launch::async, [&m] {
+    return m.try_lock_shared() ? (m.unlock_shared(), true) : false;
+  });
+  ASSERT_TRUE(other.get());
+}
+
+TEST(ShardedSharedMutex, writer_excludes)
+{
+  ceph::sharded_shared_mutex m;
+  const unsigned nthreads = 2 * ceph::sharded_shared_mutex::num_shards;
+  {
+    // whatever shard a reader lands on, a writer sees it
+    std::vector<std::thread> readers;
+    std::atomic<unsigned> locked = 0;
+    std::atomic<bool> release = false;
+    for (unsigned i = 0; i < nthreads; ++i) {
+      readers.emplace_back([&] {
+        std::shared_lock l{m};
+        ++locked;
+        while (!release) {
+          std::this_thread::yield();
+        }
+      });
+    }
+    while (locked < nthreads) {
+      std::this_thread::yield();
+    }
+    ASSERT_FALSE(m.try_lock());
+    release = true;
+    for (auto& t : readers) {
+      t.join();
+    }
+  }
+  std::unique_lock w{m};
+  for (unsigned i = 0; i < nthreads; ++i) {
+    auto r = std::async(std::launch::async, [&m] {
+      return m.try_lock_shared() ? (m.unlock_shared(), true) : false;
+    });
+    ASSERT_FALSE(r.get());
+  }
+}
+
+TEST(ShardedSharedMutex, counter)
+{
+  ceph::sharded_shared_mutex m;
+  uint64_t value = 0;
+  constexpr int nthreads = 8;
+  constexpr int rounds = 10000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < nthreads; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < rounds; ++j) {
+        if (j % 16 == 0) {
+          std::unique_lock l{m};
+          ++value;
+        } else {
+          std::shared_lock l{m};
+          ASSERT_LE(value, uint64_t(nthreads * rounds));
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(value, uint64_t(nthreads * (rounds / 16)));
+}
+
+template <typename Mutex>
+static double read_lock_rate(unsigned nthreads)
+{
+  Mutex m;
+  constexpr int rounds = 1000000;
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < nthreads; ++i) {
+    threads.emplace_back([&m] {
+      for (int j = 0; j < rounds; ++j) {
+        std::shared_lock l{m};
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+  return nthreads * rounds / elapsed.count();
+}
+
+TEST(ShardedSharedMutex, read_performance)
+{
+  unsigned nthreads = std::max(2u, std::thread::hardware_concurrency());
+  double plain = read_lock_rate<std::shared_mutex>(nthreads);
+  double sharded = read_lock_rate<ceph::sharded_shared_mutex>(nthreads);
+  std::cout << nthreads << " readers: shared_mutex " << plain / 1e6
+            << " M/s, sharded_shared_mutex " << sharded / 1e6 << " M/s"
+            << std::endl;
+}
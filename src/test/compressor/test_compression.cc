@@ -20,9 +20,12 @@
 #include <stdlib.h>
 
 #include <iostream> // for std::cout
+#include <random>
+#include <sstream>
 
 #include "gtest/gtest.h"
 #include "common/ceph_context.h"
+#include "common/ceph_time.h"
 #include "common/config.h"
 #include "compressor/Compressor.h"
 #include "compressor/CompressionPlugin.h"
@@ -457,6 +460,81 @@ TEST(ZlibCompressor, zlib_isal_compatibility)
 }
 #endif
 
+// small blobs that share structure (think rgw head objects) barely
+// compress on their own; compare that against a trained dictionary.
+static bufferlist make_small_blob(unsigned seed, size_t len)
+{
+  std::mt19937 rng(seed);
+  std::ostringstream ss;
+  while (ss.tellp() < (std::streamoff)len) {
+    ss << "{\"bucket\":\"bucket-" << rng() % 16
+       << "\",\"key\":\"obj-" << rng()
+       << "\",\"etag\":\"" << std::hex << rng() << rng() << std::dec
+       << "\",\"storage_class\":\"STANDARD\""
+       << ",\"content_type\":\"application/octet-stream\""
+       << ",\"acl\":{\"owner\":\"user-" << rng() % 8
+       << "\",\"grants\":[\"FULL_CONTROL\"]}"
+       << ",\"mtime\":" << 1700000000 + rng() % 100000 << "}\n";
+  }
+  bufferlist bl;
+  bl.append(ss.str().substr(0, len));
+  return bl;
+}
+
+TEST(ZstdCompressor, dictionary_small_blobs)
+{
+  CompressorRef zstd = Compressor::create(g_ceph_context, "zstd");
+  ASSERT_TRUE(zstd);
+
+  vector<bufferlist> samples;
+  for (unsigned i = 0; i < 512; ++i) {
+    samples.push_back(make_small_blob(i, 8192));
+  }
+  bufferlist raw_dict;
+  ASSERT_EQ(0, zstd->train_dictionary(samples, 64 * 1024, &raw_dict));
+  Compressor::DictionaryRef dict = zstd->load_dictionary(raw_dict);
+  ASSERT_TRUE(dict);
+
+  for (size_t size : {4096, 8192, 16384}) {
+    uint64_t raw = 0, plain = 0, with_dict = 0;
+    ceph::timespan plain_time = ceph::timespan::zero();
+    ceph::timespan dict_time = ceph::timespan::zero();
+    for (unsigned i = 0; i < 1000; ++i) {
+      bufferlist in = make_small_blob(100000 + i, size);
+      raw += in.length();
+
+      std::optional<int32_t> compressor_message;
+      bufferlist out;
+      auto start = ceph::mono_clock::now();
+      ASSERT_EQ(0, zstd->compress(in, out, compressor_message));
+      plain_time += ceph::mono_clock::now() - start;
+      plain += out.length();
+
+      bufferlist dout;
+      start = ceph::mono_clock::now();
+      ASSERT_EQ(0, zstd->compress_with_dict(in, dout, dict,
+					    compressor_message));
+      dict_time += ceph::mono_clock::now() - start;
+      with_dict += dout.length();
+
+      bufferlist after;
+      auto p = dout.cbegin();
+      ASSERT_EQ(0, zstd->decompress_with_dict(p, dout.length(), after, dict,
+					      compressor_message));
+      ASSERT_TRUE(in.contents_equal(after));
+      // the dictionary is not optional
+      after.clear();
+      ASSERT_NE(0, zstd->decompress(dout, after, compressor_message));
+    }
+    cout << "size " << size
+	 << " per-blob ratio " << (double)raw / plain
+	 << " in " << plain_time
+	 << ", dict ratio " << (double)raw / with_dict
+	 << " in " << dict_time << std::endl;
+    EXPECT_LT(with_dict, plain);
+  }
+}
+
 TEST(CompressionPlugin, all)
 {
   CompressorRef compressor;
@@ -1558,3 +1558,104 @@ TEST_F(CRUSHTest, msr_multi_root) {
     }
   }
 }
+
+TEST_F(CRUSHTest, do_rule_batch) {
+  // do_rule_batch() must map every input exactly as do_rule() does, for
+  // any rule, device weights and weight set
+  CrushWrapper c;
+  c.create();
+  c.set_tunables_optimal();
+  c.set_type_name(2, "root");
+  c.set_type_name(1, "host");
+  c.set_type_name(0, "osd");
+
+  int rootno;
+  c.add_bucket(0, CRUSH_BUCKET_STRAW2, CRUSH_HASH_RJENKINS1,
+	       2, 0, nullptr, nullptr, &rootno);
+  c.set_item_name(rootno, "default");
+  map<string,string> loc;
+  loc["root"] = "default";
+  int num_osd = 0;
+  for (int h = 0; h < 5; ++h) {
+    loc["host"] = string("host-") + stringify(h);
+    for (int o = 0; o < 4; ++o, ++num_osd) {
+      c.insert_item(cct, num_osd, 1.0 + 0.25 * (num_osd % 3),
+		    string("osd.") + stringify(num_osd), loc);
+    }
+  }
+
+  vector<int> rules;
+  rules.push_back(c.add_simple_rule("firstn-host", "default", "host", "",
+				    "firstn", pg_pool_t::TYPE_REPLICATED));
+  rules.push_back(c.add_simple_rule("indep-host", "default", "host", "",
+				    "indep", pg_pool_t::TYPE_ERASURE));
+  rules.push_back(c.add_simple_rule("firstn-osd", "default", "osd", "",
+				    "firstn", pg_pool_t::TYPE_REPLICATED));
+  {
+    // two osds on each of three hosts
+    int ruleno = c.add_rule(-1, 4, CRUSH_RULE_TYPE_MSR_INDEP);
+    ASSERT_LE(0, ruleno);
+    ASSERT_EQ(0, c.set_rule_step(ruleno, 0, CRUSH_RULE_TAKE, rootno, 0));
+    ASSERT_EQ(0, c.set_rule_step(ruleno, 1, CRUSH_RULE_CHOOSE_MSR, 3, 1));
+    ASSERT_EQ(0, c.set_rule_step(ruleno, 2, CRUSH_RULE_CHOOSE_MSR, 2, 0));
+    ASSERT_EQ(0, c.set_rule_step(ruleno, 3, CRUSH_RULE_EMIT, 0, 0));
+    c.set_rule_name(ruleno, "msr-indep");
+    rules.push_back(ruleno);
+  }
+  for (auto r : rules) {
+    ASSERT_LE(0, r);
+  }
+  c.finalize();
+
+  // weight sets: none, a compat one, and a positional one for "pool" 1
+  ASSERT_TRUE(c.create_choose_args(CrushWrapper::DEFAULT_CHOOSE_ARGS, 1));
+  ASSERT_TRUE(c.create_choose_args(1, 3));
+  for (int o = 0; o < num_osd; ++o) {
+    c.choose_args_adjust_item_weightf(
+      cct, c.choose_args_get(CrushWrapper::DEFAULT_CHOOSE_ARGS), o,
+      {0.5 + 0.125 * (o % 5)}, nullptr);
+    c.choose_args_adjust_item_weightf(
+      cct, c.choose_args_get(1), o,
+      {1.0, 0.25 + 0.25 * (o % 4), 2.0 - 0.125 * (o % 7)}, nullptr);
+  }
+  const uint64_t choose_args[] = {
+    (uint64_t)CrushWrapper::DEFAULT_CHOOSE_ARGS, 1, 2 /* falls back */};
+
+  // device weights: all in, some out, some partially reweighted
+  vector<vector<__u32>> weights;
+  weights.emplace_back(num_osd, 0x10000);
+  weights.push_back(weights.front());
+  for (int o = 0; o < num_osd; o += 3) {
+    weights.back()[o] = 0;
+  }
+  weights.push_back(weights.front());
+  for (int o = 0; o < num_osd; ++o) {
+    weights.back()[o] = 0x10000 >> (o % 4);
+  }
+
+  vector<int> xs;
+  for (int x = 0; x < 2000; ++x) {
+    xs.push_back(x * 2654435761u);
+  }
+  for (auto rule : rules) {
+    for (auto& weight : weights) {
+      for (auto cai : choose_args) {
+	for (int maxout : {1, 3, 6}) {
+	  SCOPED_TRACE(fmt::format("rule {} maxout {} choose_args {}",
+				   c.get_rule_name(rule), maxout, (int64_t)cai));
+	  vector<int> out, out_len;
+	  c.do_rule_batch(rule, xs, maxout, weight, cai, &out, &out_len);
+	  ASSERT_EQ(xs.size() * maxout, out.size());
+	  ASSERT_EQ(xs.size(), out_len.size());
+	  for (size_t i = 0; i < xs.size(); ++i) {
+	    vector<int> expected;
+	    c.do_rule(rule, xs[i], expected, maxout, weight, cai);
+	    vector<int> got(out.begin() + i * maxout,
+			    out.begin() + i * maxout + out_len[i]);
+	    ASSERT_EQ(expected, got) << "x " << xs[i];
+	  }
+	}
+      }
+    }
+  }
+}
@@ -170,6 +170,98 @@ TEST_P(PluginTest,PartialRead)
     EXPECT_EQ(different, true);
   }
 }
+TEST_P(PluginTest,EncodeDecodeStripes)
+{
+  initialize();
+  shard_id_set want_to_encode;
+  for (shard_id_t i; i < get_k_plus_m(); ++i) {
+    want_to_encode.insert(i);
+  }
+  // Encoding a batch of stripes must give the same chunks as encoding each
+  // stripe separately, and decoding the batch must recover an erased chunk.
+  const unsigned int stripes = 4;
+  const unsigned int stripe_width = get_k() * chunk_size;
+  bufferlist bl;
+  for (unsigned int i = 0; i < get_k() * stripes; i++) {
+    generate_chunk(bl);
+  }
+  shard_id_map<bufferlist> batch(get_k_plus_m());
+  ASSERT_EQ(0, erasure_code->encode_stripes(want_to_encode, bl, stripe_width,
+                                            &batch));
+  for (unsigned int s = 0; s < stripes; s++) {
+    bufferlist stripe;
+    stripe.substr_of(bl, s * stripe_width, stripe_width);
+    shard_id_map<bufferlist> encoded(get_k_plus_m());
+    ASSERT_EQ(0, erasure_code->encode(want_to_encode, stripe, &encoded));
+    for (shard_id_t i; i < get_k_plus_m(); ++i) {
+      ASSERT_EQ((unsigned)chunk_size * stripes, batch[i].length());
+      bufferlist expects;
+      expects.substr_of(batch[i], s * chunk_size, chunk_size);
+      EXPECT_TRUE(expects.contents_equal(encoded[i]));
+    }
+  }
+
+  shard_id_set want_to_read;
+  want_to_read.insert(shard_id_t(0));
+  shard_id_map<bufferlist> chunks = batch;
+  chunks.erase(shard_id_t(0));
+  shard_id_map<bufferlist> decoded(get_k_plus_m());
+  ASSERT_EQ(0, erasure_code->decode_stripes(want_to_read, chunks, chunk_size,
+                                            &decoded));
+  EXPECT_TRUE(decoded[shard_id_t(0)].contents_equal(batch[shard_id_t(0)]));
+}
+TEST_P(PluginTest,EncodeChunksMissingParity)
+{
+  initialize();
+  if (!(erasure_code->get_supported_optimizations() &
+        ErasureCodeInterface::FLAG_EC_PLUGIN_OPTIMIZED_SUPPORTED) ||
+      get_m() < 2) {
+    GTEST_SKIP() << "plugin does not encode partial parity";
+  }
+  // Encoding with a parity shard left out of "out" must not disturb the
+  // zero buffer that later encodes use for missing data shards.
+  const shard_id_t first_parity(get_k());
+  shard_id_map<bufferptr> in(get_k_plus_m());
+  for (shard_id_t i; i < get_k(); ++i) {
+    bufferlist bl;
+    generate_chunk(bl);
+    in[i] = bl.front();
+  }
+  auto encode_parity = [&](const shard_id_map<bufferptr> &data,
+                           const shard_id_set &parity) {
+    shard_id_map<bufferptr> out(get_k_plus_m());
+    for (auto &&shard : parity) {
+      out[shard] = buffer::create_aligned(chunk_size, 4096);
+    }
+    EXPECT_EQ(0, erasure_code->encode_chunks(data, out));
+    return out;
+  };
+
+  shard_id_set all_parity;
+  all_parity.insert_range(first_parity, get_m());
+  shard_id_map<bufferptr> expected = encode_parity(in, all_parity);
+
+  shard_id_set some_parity = all_parity;
+  some_parity.erase(first_parity);
+  shard_id_map<bufferptr> partial = encode_parity(in, some_parity);
+  for (auto &&shard : some_parity) {
+    EXPECT_EQ(0, memcmp(expected[shard].c_str(), partial[shard].c_str(),
+                        chunk_size));
+  }
+
+  // A missing data shard must encode exactly like an explicit zero shard.
+  shard_id_map<bufferptr> with_zeros = in;
+  with_zeros[shard_id_t(0)] = buffer::create_aligned(chunk_size, 4096);
+  with_zeros[shard_id_t(0)].zero();
+  expected = encode_parity(with_zeros, all_parity);
+  shard_id_map<bufferptr> missing = in;
+  missing.erase(shard_id_t(0));
+  shard_id_map<bufferptr> implicit = encode_parity(missing, all_parity);
+  for (auto &&shard : all_parity) {
+    EXPECT_EQ(0, memcmp(expected[shard].c_str(), implicit[shard].c_str(),
+                        chunk_size));
+  }
+}
 TEST_P(PluginTest,PartialWrite)
 {
   initialize();
@@ -59,7 +59,10 @@ int ErasureCodeBench::setup(int argc, char** argv) {
     ("plugin,p", po::value<string>()->default_value("isa"),
      "erasure code plugin name")
     ("workload,w", po::value<string>()->default_value("encode"),
-     "run either encode or decode")
+     "run encode, decode, encode-stripes or decode-stripes; the *-stripes "
+     "workloads compare per stripe calls with the batch API")
+    ("stripe-width", po::value<int>()->default_value(0),
+     "stripe width for the *-stripes workloads (default k * 4096)")
     ("erasures,e", po::value<int>()->default_value(1),
      "number of erasures when decoding")
     ("erased", po::value<vector<int> >(),
@@ -122,6 +125,7 @@ int ErasureCodeBench::setup(int argc, char** argv) {
   max_iterations = vm["iterations"].as<int>();
   plugin = vm["plugin"].as<string>();
   workload = vm["workload"].as<string>();
+  stripe_width = vm["stripe-width"].as<int>();
   erasures = vm["erasures"].as<int>();
   if (vm.count("erasures-generation") > 0 &&
       vm["erasures-generation"].as<string>() == "exhaustive")
@@ -149,6 +153,14 @@ int ErasureCodeBench::setup(int argc, char** argv) {
 
   verbose = vm.count("verbose") > 0 ? true : false;
 
+  if (stripe_width == 0)
+    stripe_width = k * 4096;
+  if (stripe_width % k) {
+    cout << "stripe width " << stripe_width << " is not a multiple of k="
+         << k << std::endl;
+    return -EINVAL;
+  }
+
   return 0;
 }
 
@@ -158,6 +170,8 @@ int ErasureCodeBench::run() {
 
   if (workload == "encode")
     return encode();
+  else if (workload == "encode-stripes" || workload == "decode-stripes")
+    return stripes();
   else
     return decode();
 }
@@ -325,6 +339,109 @@ int ErasureCodeBench::decode()
   return 0;
 }
 
+static void display_rate(const char *mode, utime_t elapsed, uint64_t bytes)
+{
+  double secs = (double)elapsed;
+  cout << mode << "\t" << elapsed << "\t"
+       << (secs > 0 ? bytes / secs / (1024.0 * 1024 * 1024) : 0)
+       << " GB/s" << std::endl;
+}
+
+/* Compare encoding (or decoding) --size bytes one stripe at a time with
+ * the batch encode_stripes (or decode_stripes) API. The benchmark is single
+ * threaded, so the rates reported are per core.
+ */
+int ErasureCodeBench::stripes()
+{
+  ErasureCodePluginRegistry &instance = ErasureCodePluginRegistry::instance();
+  ErasureCodeInterfaceRef erasure_code;
+  stringstream messages;
+  int code = instance.factory(plugin,
+			      g_conf().get_val<std::string>("erasure_code_dir"),
+			      profile, &erasure_code, &messages);
+  if (code) {
+    cerr << messages.str() << std::endl;
+    return code;
+  }
+
+  unsigned chunk_size = stripe_width / k;
+  unsigned stripe_count = std::max(1, in_size / stripe_width);
+  bufferlist in;
+  in.append(string((size_t)stripe_count * stripe_width, 'X'));
+  in.rebuild_aligned(ErasureCode::SIMD_ALIGN);
+  uint64_t bytes = (uint64_t)max_iterations * in.length();
+
+  shard_id_set want_to_encode;
+  for (shard_id_t i; i < k + m; ++i) {
+    want_to_encode.insert(i);
+  }
+
+  if (workload == "encode-stripes") {
+    utime_t begin_time = ceph_clock_now();
+    for (int i = 0; i < max_iterations; i++) {
+      for (unsigned s = 0; s < stripe_count; s++) {
+	bufferlist stripe;
+	stripe.substr_of(in, s * stripe_width, stripe_width);
+	shard_id_map<bufferlist> encoded(erasure_code->get_chunk_count());
+	code = erasure_code->encode(want_to_encode, stripe, &encoded);
+	if (code)
+	  return code;
+      }
+    }
+    display_rate("per-stripe", ceph_clock_now() - begin_time, bytes);
+
+    begin_time = ceph_clock_now();
+    for (int i = 0; i < max_iterations; i++) {
+      shard_id_map<bufferlist> encoded(erasure_code->get_chunk_count());
+      code = erasure_code->encode_stripes(want_to_encode, in, stripe_width,
+					  &encoded);
+      if (code)
+	return code;
+    }
+    display_rate("batch", ceph_clock_now() - begin_time, bytes);
+    return 0;
+  }
+
+  shard_id_map<bufferlist> encoded(erasure_code->get_chunk_count());
+  code = erasure_code->encode_stripes(want_to_encode, in, stripe_width,
+				      &encoded);
+  if (code)
+    return code;
+  shard_id_set want_to_read;
+  for (int i = 0; i < erasures && i < m; i++) {
+    shard_id_t shard = erased.size() > (size_t)i ?
+      shard_id_t(erased[i]) : shard_id_t(i);
+    encoded.erase(shard);
+    want_to_read.insert(shard);
+  }
+
+  utime_t begin_time = ceph_clock_now();
+  for (int i = 0; i < max_iterations; i++) {
+    for (unsigned s = 0; s < stripe_count; s++) {
+      shard_id_map<bufferlist> chunks(erasure_code->get_chunk_count());
+      for (auto &&[shard, bl] : encoded) {
+	chunks[shard].substr_of(bl, s * chunk_size, chunk_size);
+      }
+      shard_id_map<bufferlist> decoded(erasure_code->get_chunk_count());
+      code = erasure_code->decode(want_to_read, chunks, &decoded, chunk_size);
+      if (code)
+	return code;
+    }
+  }
+  display_rate("per-stripe", ceph_clock_now() - begin_time, bytes);
+
+  begin_time = ceph_clock_now();
+  for (int i = 0; i < max_iterations; i++) {
+    shard_id_map<bufferlist> decoded(erasure_code->get_chunk_count());
+    code = erasure_code->decode_stripes(want_to_read, encoded, chunk_size,
+					&decoded);
+    if (code)
+      return code;
+  }
+  display_rate("batch", ceph_clock_now() - begin_time, bytes);
+  return 0;
+}
+
 int main(int argc, char** argv) {
   ErasureCodeBench ecbench;
   try {
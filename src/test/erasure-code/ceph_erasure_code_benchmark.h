@@ -34,6 +34,7 @@
 class ErasureCodeBench {
   int in_size;
   int max_iterations;
+  int stripe_width;
   int erasures;
   int k;
   int m;
@@ -58,6 +59,7 @@ public:
 		      ErasureCodeInterfaceRef erasure_code);
   int decode();
   int encode();
+  int stripes();
 };
 
 #endif
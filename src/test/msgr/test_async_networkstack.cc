@@ -1042,6 +1042,21 @@ TEST_P(NetworkWorkerTest, StressTest) {
   ASSERT_EQ(0, factory.message_left);
 }
 
+TEST_P(NetworkWorkerTest, ZeroCopyStressTest) {
+  // Large sends go through MSG_ZEROCOPY on the posix stack; the payload
+  // must arrive intact whether or not the kernel ends up copying.
+  g_ceph_context->_conf.set_val("ms_async_zerocopy_min_size", "4096");
+  {
+    StressFactory factory(stack, get_addr(), 16, 16, 1000, 256*1024);
+    StressFactory *f = &factory;
+    exec_events([f](Worker *worker) mutable {
+      f->start(worker);
+    });
+    ASSERT_EQ(0, factory.message_left);
+  }
+  g_ceph_context->_conf.set_val("ms_async_zerocopy_min_size", "0");
+}
+
 
 INSTANTIATE_TEST_SUITE_P(
   NetworkStack,
@@ -3017,6 +3017,89 @@ TEST_P(StoreTest, ZeroLengthZero) {
   ASSERT_EQ(0, r);
 }
 
+TEST_P(StoreTest, VerifyObjectChecksums) {
+  int r;
+  coll_t cid;
+  ghobject_t hoid(hobject_t(sobject_t("foo", CEPH_NOSNAP)));
+  auto ch = store->create_new_collection(cid);
+  {
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  auto random_bl = [](unsigned len) {
+    bufferptr bp(len);
+    for (unsigned i = 0; i < len; ++i) {
+      bp[i] = rand();
+    }
+    bufferlist bl;
+    bl.append(bp);
+    return bl;
+  };
+  {
+    // unaligned extents around a hole
+    ObjectStore::Transaction t;
+    t.write(cid, hoid, 0, 70000, random_bl(70000));
+    t.write(cid, hoid, 200003, 100000, random_bl(100000));
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  {
+    // overwrite the middle of a checksum chunk
+    ObjectStore::Transaction t;
+    t.write(cid, hoid, 1000, 777, random_bl(777));
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  ch.reset();
+  r = store->umount();
+  ASSERT_EQ(0, r);
+  r = store->mount();
+  ASSERT_EQ(0, r);
+  ch = store->open_collection(cid);
+
+  const std::vector<std::pair<uint64_t, uint64_t>> ranges = {
+    {0, 0}, {0, 4096}, {1, 65535}, {4096, 200000}, {69999, 200000},
+    {250000, 1 << 20}, {400000, 4096}};
+  for (auto [off, len] : ranges) {
+    for (uint32_t flags : {0u, (uint32_t)CEPH_OSD_OP_FLAG_BYPASS_CLEAN_CACHE}) {
+      bufferlist bl;
+      int rr = store->read(ch, hoid, off, len, bl, flags);
+      uint32_t digest = -1;
+      r = store->verify_object_checksums(ch, hoid, off, len, &digest, flags);
+      ASSERT_EQ(rr, r);
+      ASSERT_EQ(bl.crc32c(-1), digest)
+        << "range 0x" << std::hex << off << "~" << len;
+    }
+  }
+  for (uint64_t stride : {4096u, 65536u, 100000u}) {
+    // sequential strides, as deep scrub does, may be read ahead
+    bufferlist bl;
+    r = store->read(ch, hoid, 0, 0, bl);
+    ASSERT_EQ((int)bl.length(), r);
+    uint32_t digest = -1;
+    uint64_t pos = 0;
+    do {
+      r = store->verify_object_checksums(
+        ch, hoid, pos, stride, &digest,
+        CEPH_OSD_OP_FLAG_FADVISE_SEQUENTIAL |
+        CEPH_OSD_OP_FLAG_BYPASS_CLEAN_CACHE);
+      ASSERT_GE(r, 0);
+      pos += r;
+    } while ((uint64_t)r == stride);
+    ASSERT_EQ(bl.length(), pos);
+    ASSERT_EQ(bl.crc32c(-1), digest) << "stride 0x" << std::hex << stride;
+  }
+  {
+    uint32_t digest = -1;
+    r = store->verify_object_checksums(
+      ch, ghobject_t(hobject_t(sobject_t("nope", CEPH_NOSNAP))),
+      0, 4096, &digest);
+    ASSERT_EQ(-ENOENT, r);
+  }
+}
+
 TEST_P(StoreTest, SimpleAttrTest) {
   int r;
   coll_t cid;
@@ -10959,6 +11042,20 @@ TEST_P(StoreTest, SpuriousReadErrorTest) {
     }
     ASSERT_GE(logger->get(l_bluestore_reads_with_retries), 1u);
   }
+
+  cerr << "Injecting CRC error with retries, expecting checksum verification "
+       << "to succeed after several retries" << std::endl;
+  {
+    auto retried = logger->get(l_bluestore_reads_with_retries);
+    for (int i = 0; i < 25; ++i) {
+      uint32_t digest = -1;
+      r = store->verify_object_checksums(
+        ch, hoid, 0, 0x2000, &digest, CEPH_OSD_OP_FLAG_BYPASS_CLEAN_CACHE);
+      ASSERT_EQ(0x2000, r);
+      ASSERT_EQ(test_data.crc32c(-1), digest);
+    }
+    ASSERT_GT(logger->get(l_bluestore_reads_with_retries), retried);
+  }
 }
 
 TEST_P(StoreTest, mergeRegionTest) {
@@ -3,7 +3,9 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <sys/resource.h>
 #include <iostream>
+#include <random>
 #include <gtest/gtest.h>
 #include "global/global_init.h"
 #include "global/global_context.h"
@@ -11,6 +13,7 @@
 #include "common/ceph_argparse.h"
 #include "include/stringify.h"
 #include "common/errno.h"
+#include "common/ceph_time.h"
 
 #include "blk/BlockDevice.h"
 
@@ -91,6 +94,92 @@ TEST(KernelDevice, Ticket45337) {
   b->close();
 }
 
+// fio-style comparison of the libaio and io_uring queue backends: random
+// O_DIRECT 4k writes and reads at a fixed queue depth.  If io_uring is not
+// supported KernelDevice falls back to libaio (and says so in the log).
+static void bench_queue(const char *name, bool ioring, unsigned fixed_buffers)
+{
+  auto& conf = g_ceph_context->_conf;
+  conf.set_val_or_die("bdev_ioring", ioring ? "true" : "false");
+  conf.set_val_or_die("bdev_ioring_fixed_buffers", stringify(fixed_buffers));
+  conf.apply_changes(nullptr);
+
+  const uint64_t size = 1ull << 30;
+  const uint64_t io_size = 4096;
+  const unsigned qd = 32;
+  const unsigned count = 16384;
+  TempBdev bdev{size};
+  std::unique_ptr<BlockDevice> b(
+    BlockDevice::create(g_ceph_context, bdev.path, NULL, NULL,
+      [](void* handle, void* aio) {}, NULL));
+  ASSERT_EQ(0, b->open(bdev.path));
+
+  std::mt19937_64 rng(count);
+  std::vector<uint64_t> offsets(count);
+  for (auto& o : offsets) {
+    o = (rng() % (size / io_size)) * io_size;
+  }
+
+  auto cpu_us = [] {
+    struct rusage ru;
+    ::getrusage(RUSAGE_SELF, &ru);
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000ull +
+      ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+  };
+  auto run = [&](bool write, const char *op) {
+    auto cpu_start = cpu_us();
+    auto start = ceph::mono_clock::now();
+    for (unsigned i = 0; i < count; i += qd) {
+      IOContext ioc(g_ceph_context, NULL);
+      std::vector<bufferlist> bls(qd);
+      for (unsigned j = 0; j < qd && i + j < count; ++j) {
+	uint64_t off = offsets[i + j];
+	if (write) {
+	  bls[j].append_zero(io_size);
+	  memcpy(bls[j].c_str(), &off, sizeof(off));
+	  ASSERT_EQ(0, b->aio_write(off, bls[j], &ioc, false));
+	} else {
+	  ASSERT_EQ(0, b->aio_read(off, io_size, &bls[j], &ioc));
+	}
+      }
+      b->aio_submit(&ioc);
+      ioc.aio_wait();
+      ASSERT_EQ(0, ioc.get_return_value());
+      if (!write) {
+	for (unsigned j = 0; j < qd && i + j < count; ++j) {
+	  // every block written above is stamped with its own offset
+	  uint64_t stamp;
+	  memcpy(&stamp, bls[j].c_str(), sizeof(stamp));
+	  ASSERT_EQ(offsets[i + j], stamp);
+	}
+      }
+    }
+    double secs = ceph::to_seconds<double>(ceph::mono_clock::now() - start);
+    auto cpu = cpu_us() - cpu_start;
+    std::cout << name << " " << op << ": " << count / secs << " iops, "
+	      << (double)cpu / count << " cpu us/io" << std::endl;
+  };
+  run(true, "randwrite");
+  run(false, "randread");
+
+  b->close();
+  conf.set_val_or_die("bdev_ioring", "false");
+  conf.set_val_or_die("bdev_ioring_fixed_buffers", "0");
+  conf.apply_changes(nullptr);
+}
+
+TEST(KernelDevice, QueueBenchLibaio) {
+  bench_queue("libaio", false, 0);
+}
+
+TEST(KernelDevice, QueueBenchIoring) {
+  bench_queue("io_uring", true, 0);
+}
+
+TEST(KernelDevice, QueueBenchIoringFixedBuffers) {
+  bench_queue("io_uring+fixed", true, 64);
+}
+
 int main(int argc, char **argv) {
   auto args = argv_to_vec(argc, argv);
   map<string,string> defaults = {
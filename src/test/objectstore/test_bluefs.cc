@@ -1999,6 +1999,113 @@ TEST(BlueFS, test_concurrent_dir_link_and_compact_log_56210) {
   }
 }
 
+// Keeps the bluefs log busy: a bounded set of files is created and
+// removed over and over, so every compaction has metadata to dump.
+void churn_metadata(BlueFS &fs, atomic_bool& stop)
+{
+  const unsigned window = 256;
+  ASSERT_EQ(0, fs.mkdir("churn"));
+  for (unsigned i = 0; !stop.load(); i++) {
+    BlueFS::FileWriter *h;
+    ASSERT_EQ(0, fs.open_for_write("churn", "file." + to_string(i), &h, false));
+    fs.close_writer(h);
+    if (i >= window) {
+      ASSERT_EQ(0, fs.unlink("churn", "file." + to_string(i - window)));
+    }
+  }
+}
+
+// RocksDB-like WAL writers: small appends, each followed by an fsync.
+// Not named *.log, so every fsync also commits the file size through
+// the bluefs log.
+void write_wal(BlueFS &fs, unsigned id, unsigned count,
+               std::vector<double>* lat_us)
+{
+  const string dir = "db.wal";
+  const string file = "wal." + to_string(id);
+  BlueFS::FileWriter *h;
+  ASSERT_EQ(0, fs.open_for_write(dir, file, &h, false));
+  auto buf = gen_buffer(4096);
+  for (unsigned i = 0; i < count; i++) {
+    h->append(buf.get(), 4096);
+    auto t0 = std::chrono::steady_clock::now();
+    ASSERT_EQ(0, fs.fsync(h));
+    auto t1 = std::chrono::steady_clock::now();
+    lat_us->push_back(
+      std::chrono::duration<double, std::micro>(t1 - t0).count());
+  }
+  fs.close_writer(h);
+}
+
+void wal_fsync_under_compaction(bool background)
+{
+  const unsigned writers = 4;
+  const unsigned fsyncs = 500;
+  uint64_t size = 1048576 * 256;
+  TempBdev bdev{size};
+  ConfSaver conf(g_ceph_context->_conf);
+  conf.SetVal("bluefs_alloc_size", "65536");
+  conf.SetVal("bluefs_compact_log_sync", "false");
+  conf.SetVal("bluefs_compact_log_background", background ? "true" : "false");
+  // compact as often as possible
+  conf.SetVal("bluefs_log_compact_min_ratio", "0");
+  conf.SetVal("bluefs_log_compact_min_size", "0");
+  conf.ApplyChanges();
+
+  BlueFS fs(g_ceph_context);
+  ASSERT_EQ(0, fs.add_block_device(BlueFS::BDEV_DB, bdev.path, false));
+  uuid_d fsid;
+  ASSERT_EQ(0, fs.mkfs(fsid, { BlueFS::BDEV_DB, false, false }));
+  ASSERT_EQ(0, fs.mount());
+  ASSERT_EQ(0, fs.mkdir("db.wal"));
+
+  atomic_bool stop{false};
+  std::thread churn(churn_metadata, std::ref(fs), std::ref(stop));
+  std::vector<std::vector<double>> lat(writers);
+  std::vector<std::thread> wal;
+  for (unsigned i = 0; i < writers; i++) {
+    wal.emplace_back(write_wal, std::ref(fs), i, fsyncs, &lat[i]);
+  }
+  join_all(wal);
+  stop = true;
+  do_join(churn);
+
+  std::vector<double> all;
+  for (auto& l : lat) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  ASSERT_EQ(all.size(), writers * fsyncs);
+  std::sort(all.begin(), all.end());
+  auto pct = [&](double p) {
+    return all[std::min(all.size() - 1, size_t(p * all.size()))];
+  };
+  uint64_t compactions =
+    fs.get_perf_counters()->get(l_bluefs_log_compactions);
+  std::cout << "wal fsync latency (us) with "
+            << (background ? "background" : "inline")
+            << " compaction: p50 " << pct(0.5)
+            << " p99 " << pct(0.99)
+            << " p99.9 " << pct(0.999)
+            << " max " << all.back()
+            << ", " << compactions << " compactions" << std::endl;
+  ASSERT_GT(compactions, 0u);
+
+  fs.umount(true);
+  ASSERT_EQ(0, fs.mount());
+  for (unsigned i = 0; i < writers; i++) {
+    uint64_t file_size = 0;
+    utime_t mtime;
+    ASSERT_EQ(0, fs.stat("db.wal", "wal." + to_string(i), &file_size, &mtime));
+    ASSERT_EQ(file_size, uint64_t(fsyncs) * 4096);
+  }
+  fs.umount();
+}
+
+TEST(BlueFS, wal_fsync_latency_under_compaction) {
+  wal_fsync_under_compaction(false);
+  wal_fsync_under_compaction(true);
+}
+
 TEST(BlueFS, truncate_drops_allocations) {
   constexpr uint64_t K = 1024;
   constexpr uint64_t M = 1024 * K;
@@ -417,6 +417,61 @@ TEST(bluestore_blob_t, csum_bench) {
   }
 }
 
+TEST(OnodeCacheShard, clock_scan_resistant) {
+  BlueStore store(g_ceph_context, "", 4096);
+  std::unique_ptr<BlueStore::OnodeCacheShard> oc{
+      BlueStore::OnodeCacheShard::create(g_ceph_context, "clock", NULL)};
+  std::unique_ptr<BlueStore::BufferCacheShard> bc{
+      BlueStore::BufferCacheShard::create(&store, "lru", NULL)};
+  auto coll = ceph::make_ref<BlueStore::Collection>(&store, oc.get(), bc.get(), coll_t());
+  oc->set_max(10);
+
+  auto add = [&](const string& name) {
+    ghobject_t oid(hobject_t(sobject_t(name, CEPH_NOSNAP)));
+    BlueStore::OnodeRef o = new BlueStore::Onode(coll.get(), oid, "");
+    o->exists = true;
+    return coll->onode_space.add_onode(oid, o);
+  };
+  auto is_cached = [&](const string& name) {
+    return coll->onode_space.map_any([&](BlueStore::Onode* o) {
+      return o->oid.hobj.oid.name == name;
+    });
+  };
+
+  // a hot set, referenced again after admission
+  for (unsigned i = 0; i < 5; ++i) {
+    BlueStore::OnodeRef o = add("hot" + stringify(i));
+    BlueStore::Onode* raw = o.get();
+    o.reset();
+    o = raw;
+    o.reset();
+  }
+  // a long one-shot scan must not push it out
+  for (unsigned i = 0; i < 100; ++i) {
+    add("scan" + stringify(i));
+    ASSERT_LE(oc->_get_num(), 10u);
+  }
+  for (unsigned i = 0; i < 5; ++i) {
+    ASSERT_TRUE(is_cached("hot" + stringify(i)));
+  }
+  ASSERT_FALSE(is_cached("scan0"));
+
+  uint64_t onodes = 0, pinned = 0;
+  oc->add_stats(&onodes, &pinned);
+  ASSERT_EQ(10u, onodes);
+  ASSERT_EQ(0u, pinned);
+
+  // pinned onodes are never evicted
+  BlueStore::OnodeRef pin = add("pinned");
+  oc->set_max(0);
+  oc->trim();
+  ASSERT_EQ(1u, oc->_get_num());
+  ASSERT_TRUE(is_cached("pinned"));
+  pin.reset();
+  oc->trim();
+  ASSERT_EQ(0u, oc->_get_num());
+}
+
 TEST(Blob, put_ref) {
   {
     BlueStore store(g_ceph_context, "", 4096);
@@ -4106,6 +4161,90 @@ TEST(bluestore_blob_use_tracker_t, mempool_stats_test) {
   }
 }
 
+static bdev_write_stats_t write_stats(double lat_us, double bw,
+                                      uint64_t in_flight = 0)
+{
+  bdev_write_stats_t s;
+  s.lat_us = lat_us;
+  s.bw = bw;
+  s.in_flight = in_flight;
+  s.samples = DeferredWriteModel::min_samples;
+  return s;
+}
+
+TEST(DeferredWriteModel, ready) {
+  DeferredWriteModel m;
+  ASSERT_FALSE(m.ready());
+  m.main = write_stats(4000, 200e6);
+  ASSERT_FALSE(m.ready());
+  m.kv = write_stats(100, 1e9);
+  ASSERT_TRUE(m.ready());
+  m.kv.samples--;
+  ASSERT_FALSE(m.ready());
+}
+
+TEST(DeferredWriteModel, breakeven) {
+  DeferredWriteModel m;
+  // hdd main device, kv wal on a slower per byte path
+  m.main = write_stats(4000, 200e6);
+  m.kv = write_stats(100, 50e6);
+  m.main_rotational = true;
+  uint64_t s = m.breakeven(1 << 20, 4096);
+  ASSERT_GT(s, 4096u);
+  ASSERT_LT(s, 1u << 20);
+  ASSERT_EQ(0u, s % 4096);
+  ASSERT_LT(m.deferred_us(s - 4096), m.direct_us(s - 4096));
+  ASSERT_GT(m.deferred_us(s + 4096), m.direct_us(s + 4096));
+
+  // a queue on the hdd makes direct writes costlier
+  m.main.in_flight = 4;
+  ASSERT_GT(m.breakeven(1 << 20, 4096), s);
+
+  // nvme wal in front of an hdd: always defer, up to the cap
+  m.kv = write_stats(20, 2e9);
+  ASSERT_EQ(128u << 10, m.breakeven(128 << 10, 4096));
+}
+
+TEST(DeferredWriteModel, busy_ssd) {
+  DeferredWriteModel m;
+  m.main = write_stats(50, 1e9);
+  m.kv = write_stats(50, 1e9);
+  m.main_rotational = false;
+  // idle: deferring saves the fixed latency
+  ASSERT_EQ(64u << 10, m.breakeven(64 << 10, 4096));
+  // busy: the later rewrite queues behind other writes, go direct
+  m.main.in_flight = 15;
+  ASSERT_EQ(0u, m.breakeven(64 << 10, 4096));
+}
+
+TEST(DeferredWriteModel, fit) {
+  // 100us fixed cost, 200MB/s, over a mix of sizes
+  bdev_write_stats_t s;
+  for (unsigned i = 0; i < 1000; ++i) {
+    uint64_t len = 4096u << (i % 9);
+    s.add_sample(len, 100 + len * 1000000.0 / 200e6, 1e9);
+  }
+  ASSERT_TRUE(s.bw_fitted);
+  ASSERT_NEAR(200e6, s.bw, 1e6);
+  ASSERT_NEAR(100, s.lat_us, 1);
+}
+
+TEST(DeferredWriteModel, small_writes_only) {
+  // hdd main device whose small writes are all deferred, and an nvme
+  // wal that only takes small appends: no device ever sees a large write
+  DeferredWriteModel m;
+  for (unsigned i = 0; i < DeferredWriteModel::min_samples; ++i) {
+    m.main.add_sample(4096, 4000, 150e6);
+    m.kv.add_sample(4096, 20, 1e9);
+  }
+  ASSERT_FALSE(m.main.bw_fitted);
+  ASSERT_FALSE(m.kv.bw_fitted);
+  ASSERT_TRUE(m.ready());
+  ASSERT_NEAR(4000 - 4096 * 1000000.0 / 150e6, m.main.lat_us, 1);
+  // deferring to the nvme wal is cheaper up to the cap
+  ASSERT_EQ(128u << 10, m.breakeven(128 << 10, 4096));
+}
+
 int main(int argc, char **argv) {
   auto args = argv_to_vec(argc, argv);
   auto cct =
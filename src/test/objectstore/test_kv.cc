@@ -173,6 +173,43 @@ TEST_P(KVTest, PutReopen) {
   fini();
 }
 
+TEST_P(KVTest, SubmitTransactions) {
+  ASSERT_EQ(0, db->create_and_open(cout));
+  {
+    std::vector<KeyValueDB::Transaction> ts;
+    for (int i = 0; i < 3; ++i) {
+      KeyValueDB::Transaction t = db->get_transaction();
+      bufferlist value;
+      value.append(stringify(i));
+      t->set("prefix", "key", value);
+      t->set("prefix", "key" + stringify(i), value);
+      if (i == 2) {
+        t->rmkey("prefix", "key0");
+      }
+      ts.push_back(t);
+    }
+    ASSERT_EQ(0, db->submit_transactions(ts));
+    KeyValueDB::Transaction t = db->get_transaction();
+    db->submit_transaction_sync(t);
+  }
+  fini();
+
+  init();
+  ASSERT_EQ(0, db->open(cout));
+  {
+    // later transactions win, as if submitted one by one
+    bufferlist v, v0, v1, v2;
+    ASSERT_EQ(0, db->get("prefix", "key", &v));
+    ASSERT_EQ("2", v.to_str());
+    ASSERT_EQ(-ENOENT, db->get("prefix", "key0", &v0));
+    ASSERT_EQ(0, db->get("prefix", "key1", &v1));
+    ASSERT_EQ("1", v1.to_str());
+    ASSERT_EQ(0, db->get("prefix", "key2", &v2));
+    ASSERT_EQ("2", v2.to_str());
+  }
+  fini();
+}
+
 TEST_P(KVTest, BenchCommit) {
   int n = 1024;
   ASSERT_EQ(0, db->create_and_open(cout));
@@ -505,6 +542,57 @@ TEST_P(KVTest, RocksDBShardingIteratorTest) {
   fini();
 }
 
+TEST_P(KVTest, RocksDBPrefixExtractorIteratorTest) {
+  if(string(GetParam()) != "rocksdb")
+    return;
+
+  std::string cfs("A(3)=prefix_extractor=rocksdb.CappedPrefix.3");
+  ASSERT_EQ(0, db->init(g_conf()->bluestore_rocksdb_options));
+  ASSERT_EQ(0, db->create_and_open(cout, cfs));
+  // keys 100.0 .. 199.9, flushed to SST files so prefix filters apply
+  for (int p = 100; p < 200; p += 10) {
+    KeyValueDB::Transaction t = db->get_transaction();
+    for (int v = p; v < p + 10; v++) {
+      for (int i = 0; i < 10; i++) {
+        std::string str = to_string(v) + "." + to_string(i);
+        bufferlist val;
+        val.append(str);
+        t->set("A", str, val);
+      }
+    }
+    ASSERT_EQ(0, db->submit_transaction_sync(t));
+    db->compact();
+  }
+  for (bool same_prefix : {true, false}) {
+    // bounds within one prefix, and bounds spanning several
+    std::string lower = "150.";
+    std::string upper = same_prefix ? "150~" : "153~";
+    KeyValueDB::Iterator it = db->get_iterator(
+      "A", 0, KeyValueDB::IteratorBounds{lower, upper});
+    ASSERT_EQ(0, it->lower_bound("150.3"));
+    int last = same_prefix ? 150 : 153;
+    for (int v = 150; v <= last; v++) {
+      for (int i = (v == 150 ? 3 : 0); i < 10; i++) {
+        ASSERT_TRUE(it->valid());
+        ASSERT_EQ(to_string(v) + "." + to_string(i), it->key());
+        it->next();
+      }
+    }
+    ASSERT_FALSE(it->valid());
+  }
+  {
+    // unbounded iteration still walks all prefixes in order
+    KeyValueDB::Iterator it = db->get_iterator("A");
+    ASSERT_EQ(0, it->lower_bound("155.0"));
+    int count = 0;
+    for (; it->valid(); it->next()) {
+      ++count;
+    }
+    ASSERT_EQ(450, count);
+  }
+  fini();
+}
+
 TEST_P(KVTest, RocksDBCFMerge) {
   if(string(GetParam()) != "rocksdb")
     return;
@@ -220,6 +220,21 @@ public:
     return 0;
   }
 
+  int encode_stripes(const shard_id_set &want_to_encode, const bufferlist &in,
+                     unsigned int stripe_width,
+                     shard_id_map<bufferlist> *encoded) override {
+    ADD_FAILURE();
+    return 0;
+  }
+
+  int decode_stripes(const shard_id_set &want_to_read,
+                     const shard_id_map<bufferlist> &chunks,
+                     unsigned int chunk_size,
+                     shard_id_map<bufferlist> *decoded) override {
+    ADD_FAILURE();
+    return 0;
+  }
+
   int decode(const shard_id_set &want_to_read, const shard_id_map<bufferlist> &chunks, shard_id_map<bufferlist> *decoded,
 	     int chunk_size) override {
     return 0;
@@ -302,6 +302,43 @@ public:
     cout << "first: " << *first << std::endl;;
     cout << "primary: " << *primary << std::endl;;
   }
+  void start_incremental_mapping(OSDMapMapping::Delta& delta) {
+    mapping.update(osdmap);
+    delta.reset(osdmap.get_epoch());
+  }
+  // apply inc, update the mapping incrementally and check it against
+  // a mapping calculated from scratch
+  void apply_and_check_mapping(OSDMapMapping::Delta& delta,
+			       OSDMap::Incremental& inc) {
+    delta.note_incremental(osdmap, inc);
+    osdmap.apply_incremental(inc);
+    ASSERT_TRUE(mapping.can_apply(osdmap, delta));
+    mapping.update(osdmap, delta);
+    delta.reset(osdmap.get_epoch());
+
+    OSDMapMapping full;
+    full.update(osdmap);
+    for (auto& [poolid, pool] : osdmap.get_pools()) {
+      for (unsigned ps = 0; ps < pool.get_pg_num(); ++ps) {
+	pg_t pgid(ps, poolid);
+	vector<int> up, acting, up2, acting2;
+	int up_primary, acting_primary, up_primary2, acting_primary2;
+	full.get(pgid, &up, &up_primary, &acting, &acting_primary);
+	mapping.get(pgid, &up2, &up_primary2, &acting2, &acting_primary2);
+	ASSERT_EQ(up, up2) << pgid;
+	ASSERT_EQ(up_primary, up_primary2) << pgid;
+	ASSERT_EQ(acting, acting2) << pgid;
+	ASSERT_EQ(acting_primary, acting_primary2) << pgid;
+      }
+    }
+    for (int osd = 0; osd < osdmap.get_max_osd(); ++osd) {
+      auto a = full.get_osd_acting_pgs(osd);
+      auto b = mapping.get_osd_acting_pgs(osd);
+      std::sort(a.begin(), a.end());
+      std::sort(b.begin(), b.end());
+      ASSERT_EQ(a, b) << "osd." << osd;
+    }
+  }
   void clean_pg_upmaps(CephContext *cct,
                        const OSDMap& om,
                        OSDMap::Incremental& pending_inc) {
@@ -775,6 +812,85 @@ TEST_F(OSDMapTest, PrimaryAffinity) {
   }
 }
 
+TEST_F(OSDMapTest, IncrementalMapping) {
+  set_up_map();
+  OSDMapMapping::Delta delta;
+  start_incremental_mapping(delta);
+
+  entity_addrvec_t sample_addrs;
+  sample_addrs.v.push_back(entity_addr_t());
+  pg_t pgid = osdmap.raw_pg_to_pg(pg_t(7, my_rep_pool));
+  vector<int> up;
+  int up_primary;
+  osdmap.pg_to_raw_up(pgid, &up, &up_primary);
+  ASSERT_LT(1u, up.size());
+  int unused = -1;
+  for (int i = 0; i < get_num_osds(); ++i) {
+    if (std::find(up.begin(), up.end(), i) == up.end()) {
+      unused = i;
+      break;
+    }
+  }
+  ASSERT_LE(0, unused);
+
+  {
+    // mark down
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    inc.fsid = osdmap.get_fsid();
+    inc.new_state[up[0]] = CEPH_OSD_UP;
+    apply_and_check_mapping(delta, inc);
+  }
+  {
+    // and back up
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    inc.fsid = osdmap.get_fsid();
+    inc.new_state[up[0]] = CEPH_OSD_UP;
+    inc.new_up_client[up[0]] = sample_addrs;
+    apply_and_check_mapping(delta, inc);
+  }
+  {
+    // mark out
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    inc.fsid = osdmap.get_fsid();
+    inc.new_weight[up[1]] = CEPH_OSD_OUT;
+    apply_and_check_mapping(delta, inc);
+  }
+  {
+    // pg_temp and primary affinity
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    inc.fsid = osdmap.get_fsid();
+    inc.new_pg_temp[pgid] = mempool::osdmap::vector<int>(up.rbegin(), up.rend());
+    inc.new_primary_affinity[unused] = 0;
+    apply_and_check_mapping(delta, inc);
+  }
+  {
+    // upmap to an unused osd, then take that osd out
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    inc.fsid = osdmap.get_fsid();
+    inc.new_pg_upmap_items[pgid] =
+      mempool::osdmap::vector<pair<int32_t,int32_t>>({{up[0], unused}});
+    apply_and_check_mapping(delta, inc);
+  }
+  {
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    inc.fsid = osdmap.get_fsid();
+    inc.new_weight[unused] = CEPH_OSD_OUT;
+    inc.new_weight[up[1]] = CEPH_OSD_IN;
+    apply_and_check_mapping(delta, inc);
+  }
+  {
+    // pool change
+    OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+    inc.fsid = osdmap.get_fsid();
+    pg_pool_t *p = inc.get_new_pool(
+      my_rep_pool, osdmap.get_pg_pool(my_rep_pool));
+    p->set_pg_num(p->get_pg_num() * 2);
+    p->set_pgp_num(p->get_pgp_num() * 2);
+    inc.old_pg_upmap_items.insert(pgid);
+    apply_and_check_mapping(delta, inc);
+  }
+}
+
 TEST_F(OSDMapTest, get_osd_crush_node_flags) {
   set_up_map();
 
@@ -3255,6 +3255,86 @@ TEST_F(PGLogTrimTest, TestCopyAfter2) {
   EXPECT_EQ(7u, copy.dups.size()) << copy;
 }
 
+TEST_F(PGLogTrimTest, TestIndexLargeLog) {
+  SetUp(0);
+  // a full-sized pg log, each object written several times
+  constexpr unsigned num_entries = 10000;
+  constexpr unsigned num_objects = 1000;
+  PGLog::IndexedLog log;
+  log.head = mk_evt(1, 0);
+  for (unsigned i = 1; i <= num_entries; ++i) {
+    log.add(mk_ple_mod(mk_obj(i % num_objects), mk_evt(1, i),
+		       mk_evt(1, i - 1)));
+  }
+  log.skip_can_rollback_to_to_head();
+  log.index();
+
+  auto check_index = [&] {
+    ASSERT_EQ(num_objects, log.objects.size());
+    for (auto& [soid, entry] : log.objects) {
+      // the key must live in the newest entry for the object
+      ASSERT_EQ(&soid.get(), &entry->soid);
+      ASSERT_GT(entry->version.version, num_entries - num_objects);
+    }
+  };
+  check_index();
+
+  std::set<eversion_t> trimmed;
+  std::set<std::string> trimmed_dups;
+  eversion_t write_from_dups = eversion_t::max();
+  log.trim(cct, mk_evt(1, num_entries / 2), &trimmed, &trimmed_dups,
+	   &write_from_dups);
+  ASSERT_EQ(num_entries / 2, log.log.size());
+  check_index();
+  for (unsigned i = 0; i < num_objects; ++i) {
+    ASSERT_TRUE(log.logged_object(mk_obj(i)));
+  }
+
+  // the incrementally maintained index matches a full rebuild
+  std::map<hobject_t, const pg_log_entry_t*> incremental;
+  for (auto& [soid, entry] : log.objects) {
+    incremental[soid] = entry;
+  }
+  log.index();
+  check_index();
+  for (auto& [soid, entry] : log.objects) {
+    ASSERT_EQ(incremental[soid], entry) << soid.get();
+  }
+}
+
+TEST_F(PGLogTrimTest, IndexLargeLogBench) {
+  SetUp(0);
+  constexpr unsigned num_entries = 10000;
+  constexpr unsigned num_objects = 1000;
+  PGLog::IndexedLog log;
+  log.head = mk_evt(1, 0);
+
+  auto start = ceph::mono_clock::now();
+  for (unsigned i = 1; i <= num_entries; ++i) {
+    log.add(mk_ple_mod(mk_obj(i % num_objects), mk_evt(1, i),
+		       mk_evt(1, i - 1)));
+  }
+  auto add_time = ceph::mono_clock::now() - start;
+  log.skip_can_rollback_to_to_head();
+
+  start = ceph::mono_clock::now();
+  log.index();
+  auto index_time = ceph::mono_clock::now() - start;
+
+  std::set<eversion_t> trimmed;
+  std::set<std::string> trimmed_dups;
+  eversion_t write_from_dups = eversion_t::max();
+  start = ceph::mono_clock::now();
+  log.trim(cct, mk_evt(1, num_entries / 2), &trimmed, &trimmed_dups,
+	   &write_from_dups);
+  auto trim_time = ceph::mono_clock::now() - start;
+
+  std::cout << num_entries << " entries, " << num_objects << " objects: "
+	    << "add " << add_time << ", index " << index_time
+	    << ", trim " << trim_time << ", osd_pglog mempool "
+	    << mempool::osd_pglog::allocated_bytes() << " bytes" << std::endl;
+}
+
 // Local Variables:
 // compile-command: "cd ../.. ; make unittest_pglog ; ./unittest_pglog --log-to-stderr=true  --debug-osd=20 # --gtest_filter=*.* "
 // End:
@@ -62,14 +62,21 @@ struct Client : public ECExtentCache::BackendReadListener
 {
   hobject_t oid = hobject_t().make_temp_hobject("My first object");
   stripe_info_t sinfo;
-  ECExtentCache::LRU lru;
+  optional<ECExtentCache::LRU> own_lru;
+  ECExtentCache::LRU &lru;
   ECExtentCache cache;
   optional<shard_extent_set_t> active_reads;
   list<shard_extent_map_t> results;
 
   Client(uint64_t chunk_size, int k, int m, uint64_t cache_size) :
     sinfo(k, m, k*chunk_size, vector<shard_id_t>(0)),
-    lru(cache_size), cache(*this, lru, sinfo, g_ceph_context) {};
+    own_lru(std::in_place, cache_size), lru(*own_lru),
+    cache(*this, lru, sinfo, g_ceph_context) {};
+
+  // Share an LRU with other clients, as PGs in the same OSD shard do.
+  Client(uint64_t chunk_size, int k, int m, ECExtentCache::LRU &shared_lru) :
+    sinfo(k, m, k*chunk_size, vector<shard_id_t>(0)),
+    lru(shared_lru), cache(*this, lru, sinfo, g_ceph_context) {};
 
   void backend_read(hobject_t _oid, const shard_extent_set_t& request,
     uint64_t object_size) override  {
@@ -693,4 +700,69 @@ TEST(ECExtentCache, test_invalidate_lru)
     cl.complete_write(*op5);
     op5.reset();
   }
-}
\ No newline at end of file
+}
+TEST(ECExtentCache, shared_lru_on_change)
+{
+  uint64_t c = 4096;
+  ECExtentCache::LRU lru(1024*c);
+  Client cl1(c, 2, 1, lru);
+  Client cl2(c, 2, 1, lru);
+
+  auto io = iset_from_vector({{{0, c}}}, cl1.get_stripe_info());
+
+  /* Populate the shared LRU from both clients with the same object name. */
+  for (auto cl : {&cl1, &cl2}) {
+    optional op = cl->cache.prepare(cl->oid, nullopt, io, 0, c, false,
+      [cl](ECExtentCache::OpRef &op)
+      {
+        cl->cache_ready(op->get_hoid(), op->get_result());
+      });
+    cl->cache_execute(*op);
+    ASSERT_FALSE(cl->active_reads);
+    cl->complete_write(*op);
+    op.reset();
+  }
+
+  uint64_t both_size = lru.get_size();
+  ASSERT_LT(0u, both_size);
+  ASSERT_EQ(0u, lru.get_stats().hits);
+  ASSERT_EQ(2u, lru.get_stats().misses);
+
+  /* An interval change on one client must only discard its own lines. */
+  cl1.cache.on_change();
+  cl1.cache.on_change2();
+  ASSERT_EQ(both_size / 2, lru.get_size());
+
+  /* The second client still reads its data from the LRU... */
+  {
+    optional op = cl2.cache.prepare(cl2.oid, io, io, c, c, false,
+      [&cl2](ECExtentCache::OpRef &op)
+      {
+        cl2.cache_ready(op->get_hoid(), op->get_result());
+      });
+    cl2.cache_execute(*op);
+    ASSERT_FALSE(cl2.active_reads);
+    ASSERT_EQ(1u, lru.get_stats().hits);
+    cl2.complete_write(*op);
+    op.reset();
+  }
+
+  /* ... whereas the first client has to go to the backend. */
+  {
+    optional op = cl1.cache.prepare(cl1.oid, io, io, c, c, false,
+      [&cl1](ECExtentCache::OpRef &op)
+      {
+        cl1.cache_ready(op->get_hoid(), op->get_result());
+      });
+    cl1.cache_execute(*op);
+    ASSERT_TRUE(cl1.active_reads);
+    ASSERT_EQ(3u, lru.get_stats().misses);
+    cl1.complete_read();
+    cl1.complete_write(*op);
+    op.reset();
+  }
+
+  cl1.cache.on_change2();
+  cl2.cache.on_change2();
+  ASSERT_EQ(0u, lru.get_size());
+}
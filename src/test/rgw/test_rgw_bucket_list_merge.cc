@@ -0,0 +1,388 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ */
+
+#include "driver/rados/bucket_list_merge.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using rgwrados::bucket_list::ShardMerge;
+using rgwrados::bucket_list::ShardReader;
+
+// serves listings of in-memory shards like cls_rgw_bucket_list does:
+// entries after the marker, common prefixes rolled up by the delimiter,
+// and 'hidden' names that use up the read but are filtered out
+class MockReader : public ShardReader {
+ public:
+  std::map<int, std::vector<std::string>> shards; // sorted names
+  std::string delimiter;
+  std::string hidden;
+  bool lifo = false;  // complete the newest read first
+  int fail_shard = -1;
+  size_t fail_read = 0; // fail this read of fail_shard (0 is the first)
+
+  std::map<int, std::vector<uint32_t>> read_sizes;
+  size_t drained = 0;
+
+  void read(int shard, const cls_rgw_obj_key& marker, uint32_t num_entries,
+            rgw_cls_list_ret* result) override {
+    EXPECT_EQ(0, std::count_if(pending.begin(), pending.end(),
+                               [shard] (const Pending& p) {
+                                 return p.shard == shard;
+                               }));
+    read_sizes[shard].push_back(num_entries);
+    pending.push_back(Pending{shard, marker.name, num_entries, result,
+                              read_sizes[shard].size() - 1});
+  }
+
+  int wait(std::vector<int>& completed) override {
+    EXPECT_FALSE(pending.empty());
+    if (pending.empty()) {
+      return -EINVAL;
+    }
+    Pending p;
+    if (lifo) {
+      p = pending.back();
+      pending.pop_back();
+    } else {
+      p = pending.front();
+      pending.pop_front();
+    }
+    completed.push_back(p.shard);
+    if (p.shard == fail_shard && p.seq == fail_read) {
+      return -EIO;
+    }
+    fill(p);
+    return 0;
+  }
+
+  void drain() override {
+    drained += pending.size();
+    pending.clear();
+  }
+
+ private:
+  struct Pending {
+    int shard = -1;
+    std::string marker;
+    uint32_t num_entries = 0;
+    rgw_cls_list_ret* result = nullptr;
+    size_t seq = 0;
+  };
+  std::deque<Pending> pending;
+
+  bool is_prefix(const std::string& name) const {
+    return !delimiter.empty() && name.size() >= delimiter.size() &&
+      name.compare(name.size() - delimiter.size(), delimiter.size(),
+                   delimiter) == 0;
+  }
+
+  void fill(const Pending& p) {
+    const auto& names = shards[p.shard];
+    auto i = std::upper_bound(names.begin(), names.end(), p.marker);
+    if (is_prefix(p.marker)) {
+      // skip the rest of the common prefix returned last time
+      while (i != names.end() && i->starts_with(p.marker)) {
+        ++i;
+      }
+    }
+    auto& result = *p.result;
+    std::string last;
+    uint32_t examined = 0;
+    while (i != names.end() && examined < p.num_entries) {
+      ++examined;
+      std::string name = *i++;
+      if (!hidden.empty() && name.starts_with(hidden)) {
+        last = name;
+        continue;
+      }
+      if (const auto pos = delimiter.empty() ? std::string::npos :
+                           name.find(delimiter);
+          pos != std::string::npos) {
+        name.resize(pos + delimiter.size());
+        while (i != names.end() && i->starts_with(name)) {
+          ++i;
+        }
+      }
+      rgw_bucket_dir_entry e;
+      e.key.name = name;
+      e.exists = true;
+      result.dir.m.emplace(name, std::move(e));
+      last = name;
+    }
+    result.is_truncated = i != names.end();
+    result.marker = cls_rgw_obj_key(last);
+  }
+};
+
+struct Page {
+  int r = 0;
+  std::vector<std::string> names;
+  bool truncated = false;
+};
+
+// one call of cls_bucket_list_ordered()
+Page list_page(MockReader& reader, const std::string& start_after,
+               uint32_t num_entries, uint32_t per_shard,
+               uint32_t max_refills = 16)
+{
+  Page page;
+  ShardMerge merge(reader, num_entries, max_refills);
+  std::vector<int> ids;
+  for (const auto& [id, names] : reader.shards) {
+    ids.push_back(id);
+  }
+  page.r = merge.start(ids, cls_rgw_obj_key(start_after), per_shard);
+  while (page.r == 0 && page.names.size() < num_entries && !merge.empty()) {
+    EXPECT_EQ(merge.name(), merge.dir_entry().key.name);
+    page.names.push_back(merge.name());
+    page.r = merge.pop(page.names.size() < num_entries);
+  }
+  page.truncated = merge.is_truncated();
+  return page;
+}
+
+// page through the whole bucket
+std::vector<std::string> list_all(MockReader& reader, uint32_t num_entries,
+                                  uint32_t per_shard,
+                                  uint32_t max_refills = 16)
+{
+  std::vector<std::string> all;
+  std::string marker;
+  for (int calls = 0; calls < 10000; ++calls) {
+    Page page = list_page(reader, marker, num_entries, per_shard,
+                          max_refills);
+    EXPECT_EQ(0, page.r);
+    if (page.r < 0) {
+      break;
+    }
+    all.insert(all.end(), page.names.begin(), page.names.end());
+    if (!page.truncated) {
+      break;
+    }
+    EXPECT_FALSE(page.names.empty());
+    if (page.names.empty()) {
+      break;
+    }
+    marker = page.names.back();
+  }
+  return all;
+}
+
+std::string make_name(const std::string& prefix, int i)
+{
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%06d", i);
+  return prefix + buf;
+}
+
+// spread names over shards, putting 'hot' of every 'hot + 1' into shard 0
+void add_skewed(MockReader& reader, int num_shards, int num_names, int hot)
+{
+  for (int i = 0; i < num_names; ++i) {
+    const int shard = (i % (hot + 1) < hot) ? 0 : 1 + i % (num_shards - 1);
+    reader.shards[shard].push_back(make_name("obj", i));
+  }
+  for (int s = 0; s < num_shards; ++s) {
+    reader.shards[s]; // make sure every shard exists
+  }
+}
+
+std::vector<std::string> expected_names(const MockReader& reader)
+{
+  std::set<std::string> names;
+  for (const auto& [id, shard] : reader.shards) {
+    for (auto name : shard) {
+      if (!reader.hidden.empty() && name.starts_with(reader.hidden)) {
+        continue;
+      }
+      if (!reader.delimiter.empty()) {
+        if (auto pos = name.find(reader.delimiter);
+            pos != std::string::npos) {
+          name.resize(pos + reader.delimiter.size());
+        }
+      }
+      names.insert(std::move(name));
+    }
+  }
+  return {names.begin(), names.end()};
+}
+
+TEST(BucketListMerge, Empty)
+{
+  MockReader reader;
+  reader.shards[0];
+  reader.shards[1];
+  Page page = list_page(reader, "", 100, 8);
+  EXPECT_EQ(0, page.r);
+  EXPECT_TRUE(page.names.empty());
+  EXPECT_FALSE(page.truncated);
+}
+
+TEST(BucketListMerge, SkewedShardFillsPage)
+{
+  MockReader reader;
+  add_skewed(reader, 8, 1000, 100);
+
+  // all but a handful of the names live in shard 0, yet a single call
+  // returns a full page by refilling that shard
+  Page page = list_page(reader, "", 100, 8);
+  EXPECT_EQ(0, page.r);
+  EXPECT_TRUE(page.truncated);
+  ASSERT_EQ(100u, page.names.size());
+  EXPECT_TRUE(std::is_sorted(page.names.begin(), page.names.end()));
+  auto expected = expected_names(reader);
+  expected.resize(100);
+  EXPECT_EQ(expected, page.names);
+
+  // the hot shard's reads grow, the others are read once
+  const auto& hot = reader.read_sizes[0];
+  ASSERT_GE(hot.size(), 4u);
+  EXPECT_EQ(8u, hot[0]);
+  EXPECT_EQ(16u, hot[1]);
+  EXPECT_EQ(32u, hot[2]);
+  EXPECT_EQ(64u, hot[3]);
+  for (auto size : hot) {
+    EXPECT_LE(size, 100u);
+  }
+  for (int s = 1; s < 8; ++s) {
+    EXPECT_EQ(std::vector<uint32_t>{8}, reader.read_sizes[s]) << "shard " << s;
+  }
+}
+
+TEST(BucketListMerge, SkewedListsEverything)
+{
+  for (int hot : {0, 1, 10, 1000}) {
+    MockReader reader;
+    add_skewed(reader, 5, 777, hot);
+    EXPECT_EQ(expected_names(reader), list_all(reader, 50, 8)) <<
+      "hot " << hot;
+  }
+}
+
+TEST(BucketListMerge, OutOfOrderCompletions)
+{
+  MockReader reader;
+  reader.lifo = true;
+  add_skewed(reader, 4, 500, 20);
+  EXPECT_EQ(expected_names(reader), list_all(reader, 64, 8));
+}
+
+TEST(BucketListMerge, Delimiter)
+{
+  MockReader reader;
+  reader.delimiter = "/";
+  // the same common prefix shows up in several shards
+  reader.shards[0] = {"a/1", "a/2", "c", "d/1"};
+  reader.shards[1] = {"a/3", "b", "d/2"};
+  reader.shards[2] = {"a/4", "d/3", "e"};
+  const std::vector<std::string> expected = {"a/", "b", "c", "d/", "e"};
+  EXPECT_EQ(expected, expected_names(reader));
+  EXPECT_EQ(expected, list_page(reader, "", 100, 8).names);
+  // with one entry per call, each prefix is returned exactly once
+  EXPECT_EQ(expected, list_all(reader, 1, 1));
+}
+
+TEST(BucketListMerge, DelimiterSkewed)
+{
+  MockReader reader;
+  reader.delimiter = "/";
+  for (int i = 0; i < 300; ++i) {
+    reader.shards[0].push_back(make_name("dir" + std::to_string(i / 30) +
+                                         "/", i));
+    reader.shards[1 + i % 3].push_back(make_name("top", i));
+  }
+  for (auto& [id, names] : reader.shards) {
+    std::sort(names.begin(), names.end());
+  }
+  EXPECT_EQ(expected_names(reader), list_all(reader, 25, 4));
+}
+
+TEST(BucketListMerge, Truncation)
+{
+  MockReader reader;
+  for (int i = 0; i < 30; ++i) {
+    reader.shards[i % 3].push_back(make_name("obj", i));
+  }
+  Page first = list_page(reader, "", 10, 4);
+  EXPECT_EQ(0, first.r);
+  EXPECT_EQ(10u, first.names.size());
+  EXPECT_TRUE(first.truncated);
+
+  Page last = list_page(reader, make_name("obj", 19), 10, 4);
+  EXPECT_EQ(0, last.r);
+  EXPECT_EQ(10u, last.names.size());
+  EXPECT_FALSE(last.truncated);
+
+  // a page that ends exactly where the bucket does
+  Page exact = list_page(reader, "", 30, 16);
+  EXPECT_EQ(30u, exact.names.size());
+  EXPECT_FALSE(exact.truncated);
+}
+
+TEST(BucketListMerge, StopsWhenShardCannotRefill)
+{
+  MockReader reader;
+  for (int i = 0; i < 100; ++i) {
+    reader.shards[i % 2].push_back(make_name("obj", i));
+  }
+  // without refills, the merge stops as soon as a truncated shard runs
+  // dry, and returns a short but truncated page
+  Page page = list_page(reader, "", 50, 8, 0);
+  EXPECT_EQ(0, page.r);
+  EXPECT_LT(page.names.size(), 50u);
+  EXPECT_GE(page.names.size(), 8u);
+  EXPECT_TRUE(page.truncated);
+  EXPECT_EQ(expected_names(reader), list_all(reader, 50, 8, 0));
+}
+
+TEST(BucketListMerge, FilteredShard)
+{
+  MockReader reader;
+  reader.hidden = "_";
+  // the first reads of shard 0 are filtered away entirely
+  for (int i = 0; i < 40; ++i) {
+    reader.shards[0].push_back(make_name("_multipart_", i));
+  }
+  reader.shards[0].push_back("z");
+  reader.shards[1] = {"a", "b"};
+  Page page = list_page(reader, "", 10, 8);
+  EXPECT_EQ(0, page.r);
+  const std::vector<std::string> expected = {"a", "b", "z"};
+  EXPECT_EQ(expected, page.names);
+  EXPECT_FALSE(page.truncated);
+}
+
+TEST(BucketListMerge, ReadError)
+{
+  MockReader reader;
+  add_skewed(reader, 4, 400, 50);
+  reader.fail_shard = 0;
+  reader.fail_read = 2;
+  Page page = list_page(reader, "", 200, 8);
+  EXPECT_EQ(-EIO, page.r);
+
+  // the first read of shard 0 fails while the other three are in flight;
+  // those are drained before the merge goes away
+  reader.fail_read = 0;
+  reader.read_sizes.clear();
+  reader.drained = 0;
+  page = list_page(reader, "", 200, 8);
+  EXPECT_EQ(-EIO, page.r);
+  EXPECT_EQ(3u, reader.drained);
+}
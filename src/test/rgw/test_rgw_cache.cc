@@ -0,0 +1,82 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:nil -*-
+// vim: ts=8 sw=2 sts=2 expandtab ft=cpp
+
+#include "rgw_cache.h"
+#include "common/ceph_context.h"
+#include "common/dout.h"
+#include "global/global_context.h"
+#include <gtest/gtest.h>
+
+static std::string name_of(int i)
+{
+  return "obj." + std::to_string(i);
+}
+
+class ObjectCacheTest : public ::testing::Test {
+protected:
+  NoDoutPrefix dpp{g_ceph_context, ceph_subsys_rgw};
+  ObjectCache cache;
+
+  void SetUp() override {
+    g_ceph_context->_conf.set_val_or_die("rgw_cache_shards", "4");
+    g_ceph_context->_conf.set_val_or_die("rgw_cache_lru_size", "64");
+    cache.set_ctx(g_ceph_context);
+    cache.set_enabled(true);
+  }
+
+  void put(const std::string& name) {
+    ObjectCacheInfo info;
+    info.flags = CACHE_FLAG_DATA;
+    cache.put(&dpp, name, info, nullptr);
+  }
+  bool hit(const std::string& name) {
+    ObjectCacheInfo info;
+    return cache.get(&dpp, name, info, CACHE_FLAG_DATA, nullptr) == 0;
+  }
+};
+
+TEST_F(ObjectCacheTest, PutGetInvalidate)
+{
+  EXPECT_EQ(4u, cache.num_shards());
+  put("a");
+  EXPECT_TRUE(hit("a"));
+  EXPECT_FALSE(hit("b"));
+  EXPECT_TRUE(cache.invalidate_remove(&dpp, "a"));
+  EXPECT_FALSE(hit("a"));
+  EXPECT_FALSE(cache.invalidate_remove(&dpp, "a"));
+}
+
+TEST_F(ObjectCacheTest, Bounded)
+{
+  constexpr int count = 1000;
+  for (int i = 0; i < count; i++) {
+    put(name_of(i));
+  }
+  int hits = 0;
+  for (int i = 0; i < count; i++) {
+    hits += hit(name_of(i));
+  }
+  // each of the 4 shards holds at most 64 / 4 entries
+  EXPECT_GE(64, hits);
+  EXPECT_TRUE(hit(name_of(count - 1)));
+}
+
+TEST_F(ObjectCacheTest, ReferencedEntriesSurvive)
+{
+  put("hot");
+  for (int i = 0; i < 1000; i++) {
+    // keep "hot" referenced while the rest of the cache churns
+    ASSERT_TRUE(hit("hot")) << "evicted after " << i << " puts";
+    put(name_of(i));
+  }
+}
+
+TEST_F(ObjectCacheTest, Disable)
+{
+  put("a");
+  cache.set_enabled(false);
+  EXPECT_FALSE(hit("a"));
+  put("a");
+  cache.set_enabled(true);
+  EXPECT_FALSE(hit("a"));
+}
@@ -101,6 +101,28 @@ TEST(Aio_Throttle, CostOverWindow)
   EXPECT_EQ(-EDEADLK, c.front().result);
 }
 
+TEST(Aio_Throttle, SetWindow)
+{
+  BlockingAioThrottle throttle(4);
+  auto obj = make_obj(__PRETTY_FUNCTION__);
+
+  throttle.set_window(8);
+  {
+    scoped_completion op1;
+    auto c1 = throttle.get(obj, wait_on(op1), 8, 0);
+    EXPECT_TRUE(c1.empty());
+  }
+  auto completions = throttle.drain();
+  ASSERT_EQ(1u, completions.size());
+  EXPECT_EQ(-ECANCELED, completions.front().result);
+
+  throttle.set_window(2);
+  scoped_completion op2;
+  auto c2 = throttle.get(obj, wait_on(op2), 4, 0);
+  ASSERT_EQ(1u, c2.size());
+  EXPECT_EQ(-EDEADLK, c2.front().result);
+}
+
 TEST(Aio_Throttle, ThrottleOverMax)
 {
   constexpr uint64_t window = 4;
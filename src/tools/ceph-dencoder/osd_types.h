@@ -100,6 +100,7 @@ TYPE(SequencerPosition)
 TYPE(bluestore_bdev_label_t)
 TYPE(bluestore_cnode_t)
 TYPE(bluestore_compression_header_t)
+TYPE(bluestore_compression_dict_t)
 TYPE(bluestore_extent_ref_map_t)
 TYPE_FEATUREFUL(bluestore_extent_ref_map_t::record_t)
 TYPE(bluestore_pextent_t)
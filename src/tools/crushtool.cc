@@ -222,6 +222,8 @@ void usage()
   cout << "      [--simulate]       simulate placements using a random\n";
   cout << "                         number generator in place of the CRUSH\n";
   cout << "                         algorithm\n";
+  cout << "      [--bench-batch]    time CRUSH mapping with a reused workspace\n";
+  cout << "                         and verify that they match\n";
   cout << "   --show-utilization    show OSD usage\n";
   cout << "   --show-utilization-all\n";
   cout << "                         include zero weight items\n";
@@ -398,6 +400,7 @@ int main(int argc, const char **argv)
   bool check = false;
   int max_id = -1;
   bool test = false;
+  bool bench_batch = false;
   bool display = false;
   bool tree = false;
   bool bucket_tree = false;
@@ -552,6 +555,8 @@ int main(int argc, const char **argv)
     } else if (ceph_argparse_witharg(args, i, &full_location, err, "--show-location", (char*)NULL)) {
     } else if (ceph_argparse_flag(args, i, "-s", "--simulate", (char*)NULL)) {
       tester.set_random_placement();
+    } else if (ceph_argparse_flag(args, i, "--bench-batch", (char*)NULL)) {
+      bench_batch = true;
     } else if (ceph_argparse_flag(args, i, "--enable-unsafe-tunables", (char*)NULL)) {
       unsafe_tunables = true;
     } else if (ceph_argparse_witharg(args, i, &choose_local_tries, err,
@@ -847,7 +852,8 @@ int main(int argc, const char **argv)
     }
   }
 
-  if (test && !check && !display && !write_to_file && compare.empty()) {
+  if (test && !check && !display && !write_to_file && compare.empty() &&
+      !bench_batch) {
     cerr << "WARNING: no output selected; use --output-csv or --show-X" << std::endl;
   }
 
@@ -1293,7 +1299,7 @@ int main(int argc, const char **argv)
 	tester.get_output_utilization())
       tester.set_output_statistics(true);
 
-    int r = tester.test(cct->get());
+    int r = bench_batch ? tester.bench_batch() : tester.test(cct->get());
     if (r < 0)
       return EXIT_FAILURE;
   }